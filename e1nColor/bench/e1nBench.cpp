@@ -0,0 +1,616 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nBench.cpp - Benchmark driver for the e1nColor scalar & batch operations.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Times every operation over synthetic (or, with --image, real) inputs at each requested size &
+// thread count, & reports pixels & bytes per second. Results can be written as JSON & compared
+// against a stored baseline, in which case the exit code says whether anything regressed:
+//
+//      e1nBench --sizes 1,100,1000 --threads 1,2,4,8,16 --json today.json
+//      e1nBench --baseline release.json --tolerance 0.10
+//
+//     Options:
+//
+//      --sizes <MP,...>        Image sizes in megapixels (default 1,100; 1000 is one gigapixel).
+//      --threads <N,...>       Thread counts to scale across (default powers of two up to the core count).
+//      --reps <N>              Timed repetitions per measurement; the best is reported (default 3).
+//      --image <path>          Tile a real image across the inputs instead of synthetic content.
+//      --ops <name,...>        Only run operations whose name starts with one of these.
+//      --max-memory <GB>       Skip measurements whose working set won't fit (default 16).
+//      --json <path>           Write the results as JSON.
+//      --baseline <path>       Compare against an earlier --json file.
+//      --tolerance <fraction>  Slow-down that counts as a regression (default 0.05).
+//      --cpu <level>           Run the kernels built for scalar, sse4, avx2 or avx512 (default: the best
+//                              the CPU supports).
+//
+//     Exit codes: 0 all good, 1 bad arguments or input, 2 at least one regression against the baseline.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorLUT.h"
+#include "lib/e1nColor/e1nBlend.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nPack.h"
+#include "lib/e1nColor/e1nPipeline.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+// Benchmark definitions:
+//====================================================================================================
+
+// One timed operation. run() gets a fresh copy of the input in the operation's working type, the
+// blend layer, & the scheduler to spread itself across.
+struct e1nBenchOp
+{
+    string name;
+    int    workType;                    // CV_8UC3 or CV_32FC3.
+    int    bytesPerPixel;               // Bytes read plus bytes written, per pixel.
+    bool   needsLayer;                  // Uses a second image of the same size.
+
+    function<void(Mat &image, const Mat &layer, e1nTileScheduler &scheduler)> run;
+};
+
+// One measurement.
+struct e1nBenchResult
+{
+    string op;
+    string input;
+    double megapixels;
+    int    threads;
+    double seconds;
+    double pixelsPerSec;
+    double bytesPerSec;
+};
+
+// Settings from the command line.
+struct e1nBenchOptions
+{
+    vector<double> sizes;
+    vector<int>    threads;
+    vector<string> ops;
+    int            reps;
+    string         imagePath;
+    double         maxMemoryGB;
+    string         jsonPath;
+    string         baselinePath;
+    double         tolerance;
+    string         cpuLevel;
+
+    e1nBenchOptions() : reps(3), maxMemoryGB(16.0), tolerance(0.05) {}
+};
+
+//     Keeps the compiler from discarding the results of the scalar getters. Written once per run, by
+// the calling thread, from per-thread sums.
+static volatile float e1nBenchSink;
+
+//----------------------------------------------------------------------------------------------------
+//     The scalar operations build an e1nColor per pixel, the way code written against the class does,
+// & the batch ones call the library's whole-image functions on each tile.
+//----------------------------------------------------------------------------------------------------
+
+static vector<e1nBenchOp> GetBenchOps()
+{
+    vector<e1nBenchOp> ops;
+
+    auto add = [&ops](const string &name, const int workType, const int bytesPerPixel, const bool needsLayer,
+                      const function<void(Mat &, const Mat &, e1nTileScheduler &)> &run)
+    {
+        e1nBenchOp op;
+
+        op.name          = name;
+        op.workType      = workType;
+        op.bytesPerPixel = bytesPerPixel;
+        op.needsLayer    = needsLayer;
+        op.run           = run;
+
+        ops.push_back(op);
+    };
+
+    // Scalar member functions.
+    add("scalar.GetHue", CV_8UC3, 3, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        vector<float> sums(scheduler.GetThreadCount(), 0.0f);
+
+        scheduler.ForEachTile(image.size(), [&](const Rect &tile, const int thread)
+        {
+            float sum = 0.0f;
+
+            for (int row = tile.y; row < tile.y + tile.height; ++row)
+            {
+                Vec3b *p = image.ptr<Vec3b>(row) + tile.x;
+
+                for (int col = 0; col < tile.width; ++col) {sum += e1nColor(p[col]).GetHue();}
+            }
+
+            sums[thread] += sum;
+        });
+
+        float total = 0.0f;
+
+        for (float sum : sums) {total += sum;}
+
+        e1nBenchSink = total;
+    });
+
+    add("scalar.GetVec3b", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile)
+        {
+            for (int row = 0; row < tile.rows; ++row)
+            {
+                Vec3b *p = tile.ptr<Vec3b>(row);
+
+                for (int col = 0; col < tile.cols; ++col) {p[col] = e1nColor(p[col]).GetVec3b();}
+            }
+        });
+    });
+
+    add("scalar.ConvertRGB2HLS", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile)
+        {
+            for (int row = 0; row < tile.rows; ++row)
+            {
+                Vec3b *p = tile.ptr<Vec3b>(row);
+
+                for (int col = 0; col < tile.cols; ++col)
+                {
+                    e1nColor someColor(p[col]);
+
+                    someColor.ConvertRGB2HLS();
+                    p[col] = someColor.GetVec3b();
+                }
+            }
+        });
+    });
+
+    // Batch functions.
+    add("batch.RGB2HLS.8U", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nConvertRGB2HLS(tile);});
+    });
+
+    add("batch.HLS2RGB.8U", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nConvertHLS2RGB(tile);});
+    });
+
+    add("batch.RGB2HLS.32F", CV_32FC3, 24, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nConvertRGB2HLS(tile);});
+    });
+
+    add("batch.HLS2RGB.32F", CV_32FC3, 24, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nConvertHLS2RGB(tile);});
+    });
+
+    add("batch.ShiftHue.8U", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nShiftHue(tile, 0.25f);});
+    });
+
+    add("table.RGB2HLS.8U", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image, [](Mat &tile) {e1nConvertRGB2HLSTable(tile);});
+    });
+
+    add("blend.Multiply.8U", CV_8UC3, 9, true, [](Mat &image, const Mat &layer, e1nTileScheduler &scheduler)
+    {
+        scheduler.ForEachTile(image.size(), [&](const Rect &tile, const int)
+        {
+            Mat base = image(tile);
+
+            e1nBlend(base, layer(tile), E1N_BLEND_MULTIPLY, 0.75f);
+        });
+    });
+
+    // The typical job: five steps that would otherwise be five passes, fused into one.
+    add("pipeline.Adjust.8U", CV_8UC3, 6, false, [](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+    {
+        e1nPipeline pipeline(&scheduler);
+
+        pipeline.ConvertRGB2HLS().ShiftHue(0.1f).ScaleSat(1.2f).ShiftVal(0.05f).ConvertHLS2RGB();
+        pipeline.Run(image);
+    });
+
+    // The last stage of a job: float results out to 8-bit, plain & dithered. The output is kept
+    // between repetitions so its allocation isn't timed.
+    const int   dithers[]    = {E1N_DITHER_NONE, E1N_DITHER_BLUE_NOISE, E1N_DITHER_ERROR_DIFFUSION};
+    const char *ditherNames[] = {"pack.None.8U", "pack.BlueNoise.8U", "pack.Diffusion.8U"};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        shared_ptr<Mat> packed(new Mat());
+        e1nPackOptions  options;
+
+        options.dither = dithers[i];
+
+        add(ditherNames[i], CV_32FC3, 15, false, [packed, options](Mat &image, const Mat &, e1nTileScheduler &scheduler)
+        {
+            e1nPack(image, *packed, CV_8UC3, options, &scheduler);
+        });
+    }
+
+    return ops;
+}
+
+//====================================================================================================
+// Inputs:
+//====================================================================================================
+
+// Fills an image with smooth gradients plus noise, so neither the hue branches nor the tables see a
+// single repeating pattern.
+static void FillSynthetic(Mat &image, e1nTileScheduler &scheduler)
+{
+    scheduler.ForEachTile(image.size(), [&image](const Rect &tile, const int)
+    {
+        for (int row = tile.y; row < tile.y + tile.height; ++row)
+        {
+            Vec3b *p = image.ptr<Vec3b>(row);
+
+            for (int col = tile.x; col < tile.x + tile.width; ++col)
+            {
+                uint32_t hash = (uint32_t) row * 2654435761u ^ (uint32_t) col * 2246822519u;
+
+                hash ^= hash >> 15;
+                hash *= 2654435761u;
+
+                p[col][0] = (unsigned char) ((col * 255 / image.cols + (hash & 31)) & 255);
+                p[col][1] = (unsigned char) ((row * 255 / image.rows + (hash >> 8 & 31)) & 255);
+                p[col][2] = (unsigned char) (hash >> 16);
+            }
+        }
+    });
+}
+
+// Tiles a real image across the input, so large sizes keep its color distribution.
+static void FillFromImage(Mat &image, const Mat &source, e1nTileScheduler &scheduler)
+{
+    scheduler.ForEachTile(image.size(), [&](const Rect &tile, const int)
+    {
+        for (int row = tile.y; row < tile.y + tile.height; ++row)
+        {
+            const Vec3b *src = source.ptr<Vec3b>(row % source.rows);
+            Vec3b       *dst = image.ptr<Vec3b>(row);
+
+            for (int col = tile.x; col < tile.x + tile.width; ++col) {dst[col] = src[col % source.cols];}
+        }
+    });
+}
+
+// Copies the 8-bit input into a working image of the operation's type.
+static void MakeWorkImage(const Mat &input, Mat &work, const int workType, e1nTileScheduler &scheduler)
+{
+    if (workType == CV_8UC3)
+    {
+        input.copyTo(work);
+        return;
+    }
+
+    // An empty pipeline is just an unpack & pack, i.e. a threaded type conversion.
+    e1nPipeline(&scheduler).Run(input, work, workType);
+}
+
+//====================================================================================================
+// Command line, output & baselines:
+//====================================================================================================
+
+static vector<string> SplitList(const string &list)
+{
+    vector<string> items;
+    stringstream   stream(list);
+    string         item;
+
+    while (getline(stream, item, ',')) {if (!item.empty()) {items.push_back(item);}}
+
+    return items;
+}
+
+static bool ParseOptions(const int argc, char **argv, e1nBenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg   = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+
+        if      (arg == "--sizes")      {for (const string &s : SplitList(value)) {options.sizes.push_back(atof(s.c_str()));}}
+        else if (arg == "--threads")    {for (const string &s : SplitList(value)) {options.threads.push_back(atoi(s.c_str()));}}
+        else if (arg == "--ops")        {options.ops          = SplitList(value);}
+        else if (arg == "--reps")       {options.reps         = max(1, atoi(value.c_str()));}
+        else if (arg == "--image")      {options.imagePath    = value;}
+        else if (arg == "--max-memory") {options.maxMemoryGB  = atof(value.c_str());}
+        else if (arg == "--json")       {options.jsonPath     = value;}
+        else if (arg == "--baseline")   {options.baselinePath = value;}
+        else if (arg == "--tolerance")  {options.tolerance    = atof(value.c_str());}
+        else if (arg == "--cpu")        {options.cpuLevel     = value;}
+        else
+        {
+            fprintf(stderr, "e1nBench: unknown option %s\n", arg.c_str());
+            return false;
+        }
+
+        ++i;
+    }
+
+    if (options.sizes.empty())
+    {
+        options.sizes.push_back(1.0);
+        options.sizes.push_back(100.0);
+    }
+
+    if (options.threads.empty())
+    {
+        int cores = max(1, (int) thread::hardware_concurrency());
+
+        for (int n = 1; n < cores; n *= 2) {options.threads.push_back(n);}
+
+        options.threads.push_back(cores);
+    }
+
+    return true;
+}
+
+static bool Selected(const e1nBenchOptions &options, const string &name)
+{
+    if (options.ops.empty()) {return true;}
+
+    for (const string &prefix : options.ops)
+    {
+        if (name.compare(0, prefix.size(), prefix) == 0) {return true;}
+    }
+
+    return false;
+}
+
+static const char *SimdName()
+{
+    return e1nGetCpuLevelName(e1nGetCpuLevel());
+}
+
+// Forces the kernel level named by --cpu, if any.
+static bool SetCpuLevel(const string &name)
+{
+    if (name.empty()) {return true;}
+
+    for (int level = 0; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (name != e1nGetCpuLevelName((e1nCpuLevel) level)) {continue;}
+
+        if (e1nSetCpuLevel((e1nCpuLevel) level)) {return true;}
+
+        fprintf(stderr, "e1nBench: this CPU can't run %s kernels (best is %s)\n", name.c_str(), e1nGetCpuLevelName(e1nDetectCpuLevel()));
+        return false;
+    }
+
+    fprintf(stderr, "e1nBench: unknown CPU level %s\n", name.c_str());
+    return false;
+}
+
+// One result per line, so the baseline reader below can stay line-based.
+static void WriteJSON(const string &path, const vector<e1nBenchResult> &results)
+{
+    ofstream out(path.c_str());
+
+    if (!out) {CV_Error(Error::StsError, "e1nBench: can't write " + path);}
+
+    out << "{\n  \"library\": \"e1nColor\",\n  \"simd\": \"" << SimdName() << "\",\n  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const e1nBenchResult &r = results[i];
+        char                  line[512];
+
+        snprintf(line, sizeof(line),
+                 "    {\"op\": \"%s\", \"input\": \"%s\", \"megapixels\": %g, \"threads\": %d, "
+                 "\"seconds\": %.6g, \"pixels_per_sec\": %.6g, \"bytes_per_sec\": %.6g}%s\n",
+                 r.op.c_str(), r.input.c_str(), r.megapixels, r.threads,
+                 r.seconds, r.pixelsPerSec, r.bytesPerSec, i + 1 < results.size() ? "," : "");
+
+        out << line;
+    }
+
+    out << "  ]\n}\n";
+}
+
+// Pulls "key": value out of one line of our own JSON.
+static string FindField(const string &line, const string &key)
+{
+    size_t at = line.find("\"" + key + "\":");
+
+    if (at == string::npos) {return "";}
+
+    at = line.find_first_not_of(" \"", at + key.size() + 3);
+
+    size_t end = line.find_first_of(",}\"", at);
+
+    return line.substr(at, end - at);
+}
+
+static string ResultKey(const string &op, const string &input, const double megapixels, const int threads)
+{
+    char key[256];
+
+    snprintf(key, sizeof(key), "%s|%s|%g|%d", op.c_str(), input.c_str(), megapixels, threads);
+
+    return key;
+}
+
+// Returns the number of regressions, printing each measurement that moved by more than the tolerance.
+static int CompareBaseline(const string &path, const vector<e1nBenchResult> &results, const double tolerance)
+{
+    ifstream in(path.c_str());
+
+    if (!in) {CV_Error(Error::StsError, "e1nBench: can't read baseline " + path);}
+
+    map<string, double> baseline;
+    string              line;
+
+    while (getline(in, line))
+    {
+        if (line.find("\"op\":") == string::npos) {continue;}
+
+        string key = ResultKey(FindField(line, "op"), FindField(line, "input"),
+                               atof(FindField(line, "megapixels").c_str()), atoi(FindField(line, "threads").c_str()));
+
+        baseline[key] = atof(FindField(line, "pixels_per_sec").c_str());
+    }
+
+    int regressions = 0;
+
+    printf("\nAgainst %s (tolerance %.0f%%):\n", path.c_str(), tolerance * 100.0);
+
+    for (const e1nBenchResult &r : results)
+    {
+        auto found = baseline.find(ResultKey(r.op, r.input, r.megapixels, r.threads));
+
+        if (found == baseline.end() || found->second <= 0.0) {continue;}
+
+        double ratio = r.pixelsPerSec / found->second;
+
+        if (ratio < 1.0 - tolerance)
+        {
+            printf("  REGRESSION %-24s %7g MP %3d threads: %6.2fx\n", r.op.c_str(), r.megapixels, r.threads, ratio);
+            ++regressions;
+        }
+        else if (ratio > 1.0 + tolerance)
+        {
+            printf("  faster     %-24s %7g MP %3d threads: %6.2fx\n", r.op.c_str(), r.megapixels, r.threads, ratio);
+        }
+    }
+
+    printf("%d regression(s).\n", regressions);
+
+    return regressions;
+}
+
+//====================================================================================================
+// Main:
+//====================================================================================================
+
+int main(int argc, char **argv)
+{
+    e1nBenchOptions options;
+
+    if (!ParseOptions(argc, argv, options)) {return 1;}
+    if (!SetCpuLevel(options.cpuLevel))     {return 1;}
+
+    Mat    source;
+    string inputName = "synthetic";
+
+    if (!options.imagePath.empty())
+    {
+        Mat loaded = imread(options.imagePath, IMREAD_COLOR);
+
+        if (loaded.empty())
+        {
+            fprintf(stderr, "e1nBench: can't read %s\n", options.imagePath.c_str());
+            return 1;
+        }
+
+        cvtColor(loaded, source, COLOR_BGR2RGB);
+        inputName = "image";
+    }
+
+    vector<e1nBenchOp>     ops = GetBenchOps();
+    vector<e1nBenchResult> results;
+
+    // Build the lookup tables up front so their one-off cost isn't charged to the first timing.
+    if (Selected(options, "table")) {e1nGetRGB2HLSTable();}
+
+    printf("e1nColor benchmarks (%s, %s input)\n\n", SimdName(), inputName.c_str());
+    printf("%-24s %9s %7s %12s %12s %10s\n", "operation", "MP", "threads", "Mpixel/s", "MB/s", "ms");
+
+    for (const double megapixels : options.sizes)
+    {
+        double pixels = megapixels * 1.0e6;
+        int    cols   = max(1, (int) sqrt(pixels));
+        int    rows   = max(1, (int) (pixels / cols));
+
+        e1nTileScheduler &filler = e1nTileScheduler::Default();
+        Mat               input(rows, cols, CV_8UC3);
+        Mat               layer;
+        Mat               work;
+
+        if (source.empty()) {FillSynthetic(input, filler);}
+        else                {FillFromImage(input, source, filler);}
+
+        for (const e1nBenchOp &op : ops)
+        {
+            if (!Selected(options, op.name)) {continue;}
+
+            // Input, working copy & (maybe) layer all have to fit.
+            double workingSet = (double) rows * cols * (3.0 + CV_ELEM_SIZE(op.workType) + (op.needsLayer ? CV_ELEM_SIZE(op.workType) : 0));
+
+            if (workingSet > options.maxMemoryGB * 1.0e9)
+            {
+                printf("%-24s %9g skipped (%.1f GB working set)\n", op.name.c_str(), megapixels, workingSet / 1.0e9);
+                continue;
+            }
+
+            if (op.needsLayer && layer.empty()) {MakeWorkImage(input, layer, op.workType, filler);}
+
+            for (const int numThreads : options.threads)
+            {
+                e1nTileScheduler scheduler(numThreads);
+                double           best = 1.0e30;
+
+                for (int rep = 0; rep < options.reps; ++rep)
+                {
+                    MakeWorkImage(input, work, op.workType, filler);
+
+                    auto start = chrono::steady_clock::now();
+
+                    op.run(work, layer, scheduler);
+
+                    best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+                }
+
+                e1nBenchResult r;
+
+                r.op           = op.name;
+                r.input        = inputName;
+                r.megapixels   = megapixels;
+                r.threads      = numThreads;
+                r.seconds      = best;
+                r.pixelsPerSec = (double) rows * cols / best;
+                r.bytesPerSec  = r.pixelsPerSec * op.bytesPerPixel;
+
+                results.push_back(r);
+
+                printf("%-24s %9g %7d %12.1f %12.1f %10.2f\n", r.op.c_str(), megapixels, numThreads,
+                       r.pixelsPerSec / 1.0e6, r.bytesPerSec / 1.0e6, best * 1.0e3);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (!options.jsonPath.empty()) {WriteJSON(options.jsonPath, results);}
+
+    if (!options.baselinePath.empty() && CompareBaseline(options.baselinePath, results, options.tolerance) > 0) {return 2;}
+
+    return 0;
+}
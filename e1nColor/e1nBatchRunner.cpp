@@ -0,0 +1,451 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nBatchRunner.cpp - Implementation file for e1nColor's many-file batch runner.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nBatchRunner.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nBoundedQueue - A blocking FIFO with a fixed capacity. Push() waits while it's full (that's
+// the backpressure), Pop() waits while it's empty, & once Close() is called Pop() drains what's left
+// then returns false.
+//====================================================================================================
+
+template <class T> class e1nBoundedQueue
+{
+private:
+
+    mutex              lock;
+    condition_variable notFull;
+    condition_variable notEmpty;
+    deque<T>           items;
+    size_t             capacity;
+    bool               closed;
+
+public:
+
+    e1nBoundedQueue(const size_t maxItems) : capacity(max(maxItems, (size_t) 1)), closed(false) {}
+
+    void Push(T &&item)
+    {
+        unique_lock<mutex> hold(lock);
+
+        notFull.wait(hold, [this] {return items.size() < capacity;});
+
+        items.push_back(move(item));
+        notEmpty.notify_one();
+    }
+
+    bool Pop(T &item)
+    {
+        unique_lock<mutex> hold(lock);
+
+        notEmpty.wait(hold, [this] {return !items.empty() || closed;});
+
+        if (items.empty()) {return false;}
+
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+
+        return true;
+    }
+
+    void Close()
+    {
+        lock_guard<mutex> hold(lock);
+
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+    size_t Size()
+    {
+        lock_guard<mutex> hold(lock);
+
+        return items.size();
+    }
+};
+
+//====================================================================================================
+// Run state:
+//====================================================================================================
+
+// An image on its way through, with the item it came from.
+struct e1nBatchSlot
+{
+    size_t index;
+    Mat    image;
+};
+
+struct e1nBatchState
+{
+    const vector<e1nBatchItem> &items;
+
+    e1nBoundedQueue<e1nBatchSlot> decoded;
+    e1nBoundedQueue<e1nBatchSlot> processed;
+
+    atomic<size_t> next;                // Next item a reader claims.
+    atomic<size_t> read, done, written, failed;
+    atomic<bool>   stop;
+
+    atomic<int> readersLeft;            // The last thread out of a stage closes its output queue.
+    atomic<int> workersLeft;
+    atomic<int> writersLeft;
+
+    atomic<uint64_t> readTime, processTime, writeTime;
+
+    mutex                 errorLock;
+    vector<e1nBatchError> errors;
+
+    mutex              finishLock;      // Wakes the reporting thread when the writers are done.
+    condition_variable finished;
+
+    e1nBatchState(const vector<e1nBatchItem> &runItems, const e1nBatchOptions &options)
+        : items(runItems), decoded(options.queueDepth), processed(options.queueDepth),
+          next(0), read(0), done(0), written(0), failed(0), stop(false),
+          readersLeft(options.readers), workersLeft(options.workers), writersLeft(options.writers),
+          readTime(0), processTime(0), writeTime(0) {}
+
+    void Fail(const size_t index, const char *stage, const string &message, const bool stopOnError)
+    {
+        {
+            lock_guard<mutex> hold(errorLock);
+
+            errors.push_back(e1nBatchError{items[index].input, stage, message});
+        }
+
+        ++failed;
+
+        if (stopOnError) {stop = true;}
+    }
+};
+
+static uint64_t Nanoseconds()
+{
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Runs one stage's work on an item, timing it & turning anything it throws into a recorded
+// failure. Returns whether it succeeded.
+//----------------------------------------------------------------------------------------------------
+
+template <class Work> static bool RunStep(e1nBatchState &state, const size_t index, const char *stage, const char *traceName,
+                                          atomic<uint64_t> &busy, const bool stopOnError, const Work &work)
+{
+    uint64_t begin = Nanoseconds();
+    string   error;
+
+    try
+    {
+        work();
+    }
+    catch (const cv::Exception &e)
+    {
+        error = e.what();
+    }
+    catch (const exception &e)
+    {
+        error = e.what();
+    }
+    catch (...)
+    {
+        error = "unknown exception";
+    }
+
+    uint64_t elapsed = Nanoseconds() - begin;
+
+    busy += elapsed;
+
+#if defined(E1N_ENABLE_TRACE)
+    if (e1nTrace::IsEnabled()) {e1nTrace::AddStage(traceName, elapsed, 0, 0);}
+#else
+    (void) traceName;
+#endif
+
+    if (error.empty()) {return true;}
+
+    state.Fail(index, stage, error, stopOnError);
+
+    return false;
+}
+
+//====================================================================================================
+// Default reader & writer:
+//====================================================================================================
+
+static Mat ReadImage(const string &path)
+{
+    Mat image = imread(path, IMREAD_UNCHANGED);
+
+    if (image.channels() == 3) {cvtColor(image, image, COLOR_BGR2RGB);}
+    if (image.channels() == 4) {cvtColor(image, image, COLOR_BGRA2RGBA);}
+
+    return image;
+}
+
+static void WriteImage(const Mat &image, const string &path)
+{
+    Mat encoded;
+
+    if      (image.channels() == 3) {cvtColor(image, encoded, COLOR_RGB2BGR);}
+    else if (image.channels() == 4) {cvtColor(image, encoded, COLOR_RGBA2BGRA);}
+    else                            {encoded = image;}
+
+    if (!imwrite(path, encoded)) {CV_Error(Error::StsError, "e1nBatchRunner: can't write " + path);}
+}
+
+//====================================================================================================
+// Constructors & set-up:
+//====================================================================================================
+
+e1nBatchRunner::e1nBatchRunner(const e1nBatchOptions &runOptions)
+{
+    options = runOptions;
+    reader  = ReadImage;
+    writer  = WriteImage;
+}
+
+void e1nBatchRunner::Add(const e1nBatchOp &op)
+{
+    chain.push_back(op);
+}
+
+void e1nBatchRunner::Clear()
+{
+    chain.clear();
+}
+
+void e1nBatchRunner::SetReader(const e1nBatchReader &fileReader)
+{
+    reader = fileReader ? fileReader : e1nBatchReader(ReadImage);
+}
+
+void e1nBatchRunner::SetWriter(const e1nBatchWriter &fileWriter)
+{
+    writer = fileWriter ? fileWriter : e1nBatchWriter(WriteImage);
+}
+
+//====================================================================================================
+// Running:
+//====================================================================================================
+
+e1nBatchResult e1nBatchRunner::Run(const vector<e1nBatchItem> &items) const
+{
+    CV_Assert(options.readers >= 1 && options.workers >= 1 && options.writers >= 1 && options.queueDepth >= 1);
+
+    E1N_TRACE_OP("e1nBatchRunner::Run", 0, 0);
+
+    e1nBatchState  state(items, options);
+    vector<thread> threads;
+    uint64_t       start = Nanoseconds();
+
+    // Readers claim items in list order & decode them.
+    for (int i = 0; i < options.readers; ++i)
+    {
+        threads.emplace_back([this, &state]
+        {
+            for (size_t index = state.next++; index < state.items.size() && !state.stop; index = state.next++)
+            {
+                e1nBatchSlot slot = {index, Mat()};
+
+                bool ok = RunStep(state, index, "read", "batch read", state.readTime, options.stopOnError, [&]
+                {
+                    slot.image = reader(state.items[index].input);
+
+                    if (slot.image.empty()) {CV_Error(Error::StsError, "e1nBatchRunner: can't read " + state.items[index].input);}
+                });
+
+                if (!ok) {continue;}
+
+                ++state.read;
+                state.decoded.Push(move(slot));
+            }
+
+            if (--state.readersLeft == 0) {state.decoded.Close();}
+        });
+    }
+
+    // Workers run the chain.
+    for (int i = 0; i < options.workers; ++i)
+    {
+        threads.emplace_back([this, &state]
+        {
+            e1nBatchSlot slot;
+
+            while (state.decoded.Pop(slot))
+            {
+                bool ok = RunStep(state, slot.index, "process", "batch process", state.processTime, options.stopOnError, [&]
+                {
+                    for (size_t op = 0; op < chain.size(); ++op) {chain[op](slot.image);}
+                });
+
+                if (!ok) {continue;}
+
+                ++state.done;
+                state.processed.Push(move(slot));
+            }
+
+            if (--state.workersLeft == 0) {state.processed.Close();}
+        });
+    }
+
+    // Writers encode & write, releasing each image as soon as it's on disk.
+    for (int i = 0; i < options.writers; ++i)
+    {
+        threads.emplace_back([this, &state]
+        {
+            e1nBatchSlot slot;
+
+            while (state.processed.Pop(slot))
+            {
+                bool ok = RunStep(state, slot.index, "write", "batch write", state.writeTime, options.stopOnError, [&]
+                {
+                    writer(slot.image, state.items[slot.index].output);
+                });
+
+                slot.image.release();
+
+                if (ok) {++state.written;}
+            }
+
+            if (--state.writersLeft == 0)
+            {
+                lock_guard<mutex> hold(state.finishLock);
+
+                state.finished.notify_all();
+            }
+        });
+    }
+
+    // Report progress from here until the writers are done.
+    auto snapshot = [&state, start]
+    {
+        e1nBatchProgress progress;
+
+        progress.total           = state.items.size();
+        progress.read            = state.read;
+        progress.processed       = state.done;
+        progress.written         = state.written;
+        progress.failed          = state.failed;
+        progress.decodedQueued   = state.decoded.Size();
+        progress.processedQueued = state.processed.Size();
+        progress.seconds         = (Nanoseconds() - start) * 1.0e-9;
+        progress.filesPerSecond  = progress.seconds > 0.0 ? (progress.written + progress.failed) / progress.seconds : 0.0;
+
+        return progress;
+    };
+
+    {
+        unique_lock<mutex> hold(state.finishLock);
+        auto               interval = chrono::duration<double>(max(options.reportSeconds, 0.001));
+
+        while (state.writersLeft > 0)
+        {
+            if (state.finished.wait_for(hold, interval, [&state] {return state.writersLeft == 0;})) {break;}
+
+            if (options.progress)
+            {
+                hold.unlock();
+                options.progress(snapshot());
+                hold.lock();
+            }
+        }
+    }
+
+    for (thread &t : threads) {t.join();}
+
+    if (options.progress) {options.progress(snapshot());}
+
+    e1nBatchResult result;
+
+    result.total          = items.size();
+    result.succeeded      = state.written;
+    result.failed         = state.failed;
+    result.seconds        = (Nanoseconds() - start) * 1.0e-9;
+    result.filesPerSecond = result.seconds > 0.0 ? (result.succeeded + result.failed) / result.seconds : 0.0;
+    result.readSeconds    = state.readTime    * 1.0e-9;
+    result.processSeconds = state.processTime * 1.0e-9;
+    result.writeSeconds   = state.writeTime   * 1.0e-9;
+    result.errors         = move(state.errors);
+
+    return result;
+}
+
+//====================================================================================================
+// Helpers:
+//====================================================================================================
+
+static string Lower(string text)
+{
+    for (char &c : text) {c = (char) tolower((unsigned char) c);}
+
+    return text;
+}
+
+vector<e1nBatchItem> e1nListBatchDirectory(const string &inputDir, const string &outputDir, const string &extension)
+{
+    static const char *const imageTypes[] = {".bmp", ".exr", ".jpg", ".jpeg", ".png", ".tif", ".tiff", ".webp"};
+
+    vector<String>       paths;
+    vector<e1nBatchItem> items;
+
+    glob(inputDir + "/*", paths, false);
+
+    sort(paths.begin(), paths.end());
+
+    for (const String &path : paths)
+    {
+        string file  = path;
+        size_t slash = file.find_last_of("/\\");
+        string name  = slash == string::npos ? file : file.substr(slash + 1);
+        size_t dot   = name.find_last_of('.');
+
+        if (dot == string::npos) {continue;}
+
+        string type = Lower(name.substr(dot));
+
+        if (find(begin(imageTypes), end(imageTypes), type) == end(imageTypes)) {continue;}
+
+        if (!extension.empty()) {name = name.substr(0, dot) + extension;}
+
+        items.push_back(e1nBatchItem{file, outputDir + "/" + name});
+    }
+
+    return items;
+}
+
+e1nBatchOp e1nBatchPipeline(const e1nPipeline &pipeline)
+{
+    const e1nPipeline *chain = &pipeline;
+
+    return [chain](Mat &image) {chain->Run(image);};
+}
+
+void e1nPrintBatchProgress(const e1nBatchProgress &progress)
+{
+    fprintf(stderr, "e1nBatchRunner: %zu / %zu files (%zu failed), %.1f files/s, queued %zu decoded & %zu processed\n",
+            progress.written + progress.failed, progress.total, progress.failed, progress.filesPerSecond,
+            progress.decodedQueued, progress.processedQueued);
+}
@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nBatchRunner.h - Interface definition file for e1nColor's many-file batch runner.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NBATCHRUNNER_H
+#define E1NBATCHRUNNER_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nPipeline.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nBatchRunner - Pushes a list of files through the same chain of operations, with decoding,
+// color work & encoding running at the same time on different files:
+//
+//      readers  --[decoded queue]-->  workers  --[processed queue]-->  writers
+//
+//     Each stage has its own threads, & the queues between them are bounded: a stage that gets ahead
+// blocks on a full queue until the next one catches up, so the images in flight (& the memory they
+// take) never exceed readers + workers + writers + 2 * queueDepth, however long the list is.
+//
+//     Operations run on a worker thread, one file at a time, & are free to spread themselves across
+// the tile scheduler (e1nPipeline does). Keep one worker for those; more workers only pay off for
+// operations that run on the calling thread, like e1nConvertRGB2HLS(Mat &).
+//
+//     A file that fails to read, process or write is recorded & skipped; the rest carry on. Files
+// finish out of order.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// Files & hooks:
+//----------------------------------------------------------------------------------------------------
+
+struct e1nBatchItem
+{
+    string input;                       // Path read from.
+    string output;                      // Path written to.
+};
+
+// One step of the chain, in place. Images come in as decoded by the reader (RGB order by default).
+typedef function<void(Mat &image)> e1nBatchOp;
+
+// Decoding & encoding. The defaults use imread(IMREAD_UNCHANGED) & imwrite(), swapping OpenCV's BGR
+// to RGB on the way in & back on the way out. A reader returns an empty Mat or throws on failure.
+typedef function<Mat(const string &path)>                    e1nBatchReader;
+typedef function<void(const Mat &image, const string &path)> e1nBatchWriter;
+
+//----------------------------------------------------------------------------------------------------
+// Progress & results:
+//----------------------------------------------------------------------------------------------------
+
+struct e1nBatchProgress
+{
+    size_t total;                       // Files in the run.
+    size_t read;                        // Files decoded so far.
+    size_t processed;                   // Files through the chain.
+    size_t written;                     // Files written.
+    size_t failed;                      // Files dropped at any stage.
+    size_t decodedQueued;               // Images waiting for a worker.
+    size_t processedQueued;             // Images waiting for a writer.
+    double seconds;                     // Since the run started.
+    double filesPerSecond;              // Files finished (written or failed) per second so far.
+};
+
+struct e1nBatchError
+{
+    string path;                        // The input file.
+    string stage;                       // "read", "process" or "write".
+    string message;
+};
+
+struct e1nBatchResult
+{
+    size_t                total;
+    size_t                succeeded;
+    size_t                failed;
+    double                seconds;
+    double                filesPerSecond;    // Files finished per second, over the whole run.
+    double                readSeconds;       // Busy time summed over each stage's threads, so a
+    double                processSeconds;    // stage near threads * seconds is the bottleneck.
+    double                writeSeconds;
+    vector<e1nBatchError> errors;
+};
+
+//----------------------------------------------------------------------------------------------------
+// Options:
+//----------------------------------------------------------------------------------------------------
+
+struct e1nBatchOptions
+{
+    int    readers;                     // Threads per stage, at least 1 each.
+    int    workers;
+    int    writers;
+    int    queueDepth;                  // Images each queue holds before its producers block.
+    double reportSeconds;               // How often progress is called.
+    bool   stopOnError;                 // Stop reading new files after the first failure.
+
+    function<void(const e1nBatchProgress &)> progress;       // Called on the thread running Run().
+
+    e1nBatchOptions() : readers(2), workers(1), writers(2), queueDepth(4), reportSeconds(1.0), stopOnError(false), progress() {}
+};
+
+//----------------------------------------------------------------------------------------------------
+// e1nBatchRunner:
+//----------------------------------------------------------------------------------------------------
+
+class e1nBatchRunner
+{
+private:
+
+    e1nBatchOptions    options;
+    vector<e1nBatchOp> chain;           // The operations, in order.
+    e1nBatchReader     reader;
+    e1nBatchWriter     writer;
+
+public:
+
+    e1nBatchRunner(const e1nBatchOptions &runOptions = e1nBatchOptions());
+
+    void Add(const e1nBatchOp &op);
+    void Clear();
+
+    void SetReader(const e1nBatchReader &fileReader);
+    void SetWriter(const e1nBatchWriter &fileWriter);
+
+    // Runs every item & returns once the last file is written. Blocks the calling thread, which
+    // reports progress meanwhile.
+    e1nBatchResult Run(const vector<e1nBatchItem> &items) const;
+};
+
+//----------------------------------------------------------------------------------------------------
+// Helpers:
+//----------------------------------------------------------------------------------------------------
+
+//     The image files directly inside inputDir (by extension: bmp, exr, jpg, jpeg, png, tif, tiff,
+// webp), each paired with the same name in outputDir, sorted by path. A non-empty extension (".png")
+// replaces each output file's own.
+vector<e1nBatchItem> e1nListBatchDirectory(const string &inputDir, const string &outputDir, const string &extension = "");
+
+// Runs a whole pipeline over each image. The pipeline must outlive the run.
+e1nBatchOp e1nBatchPipeline(const e1nPipeline &pipeline);
+
+// A progress callback that prints one line per report to stderr.
+void e1nPrintBatchProgress(const e1nBatchProgress &progress);
+
+#endif     // E1NBATCHRUNNER_H
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nBlend.cpp - Implementation file for the e1nColor blending functions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nBlend.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Helpers:
+//====================================================================================================
+
+// Picks the kernel for a blend mode, so the mode is only switched on once per call.
+static e1nKernelTable::BlendFn GetBlendKernel(const e1nBlendMode mode)
+{
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    switch (mode)
+    {
+        case E1N_BLEND_MULTIPLY:   return kernels.blend[E1N_KERNEL_MULTIPLY];
+        case E1N_BLEND_SCREEN:     return kernels.blend[E1N_KERNEL_SCREEN];
+        case E1N_BLEND_OVERLAY:    return kernels.blend[E1N_KERNEL_OVERLAY];
+        case E1N_BLEND_HUE:        return kernels.blend[E1N_KERNEL_HUE];
+        case E1N_BLEND_SATURATION: return kernels.blend[E1N_KERNEL_SATURATION];
+        case E1N_BLEND_LIGHTEN:    return kernels.blend[E1N_KERNEL_LIGHTEN];
+        case E1N_BLEND_DARKEN:     return kernels.blend[E1N_KERNEL_DARKEN];
+        default:                   return kernels.blend[E1N_KERNEL_NORMAL];
+    }
+}
+
+// Folds the opacity, the mask & (for alpha blending) the layer alpha into one coverage run.
+static void BuildCoverage(float *cov, const int count, const float opacity, const e1nMask &mask,
+                          const int row, const int col, const float *alpha)
+{
+    mask.UnpackRow(row, col, count, cov);
+
+    for (int i = 0; i < count; ++i) {cov[i] *= opacity;}
+
+    if (alpha)
+    {
+        for (int i = 0; i < count; ++i) {cov[i] *= alpha[i];}
+    }
+}
+
+//====================================================================================================
+// Blending functions:
+//====================================================================================================
+
+void e1nBlend(Mat &base, const Mat &layer, const e1nBlendMode mode, const float opacity, const e1nMask &mask)
+{
+    CV_Assert(base.type()  == CV_8UC3  || base.type()  == CV_8UC4  || base.type()  == CV_16UC3 || base.type()  == CV_16UC4 ||
+              base.type()  == CV_32FC3 || base.type()  == CV_32FC4);
+    CV_Assert(layer.type() == CV_8UC3  || layer.type() == CV_8UC4  || layer.type() == CV_16UC3 || layer.type() == CV_16UC4 ||
+              layer.type() == CV_32FC3 || layer.type() == CV_32FC4);
+    CV_Assert(base.size() == layer.size());
+    CV_Assert(mask.Empty() || mask.GetSize() == base.size());
+
+    E1N_TRACE_OP("e1nBlend", base.total(), base.total() * (base.elemSize() * 2 + layer.elemSize()));
+
+    e1nKernelTable::BlendFn kernel   = GetBlendKernel(mode);
+    bool                    useAlpha = mode == E1N_BLEND_ALPHA;
+
+    alignas(64) float b0[E1N_BATCH_CHUNK], b1[E1N_BATCH_CHUNK], b2[E1N_BATCH_CHUNK];
+    alignas(64) float l0[E1N_BATCH_CHUNK], l1[E1N_BATCH_CHUNK], l2[E1N_BATCH_CHUNK], l3[E1N_BATCH_CHUNK];
+    alignas(64) float cov[E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < base.rows; ++row)
+    {
+        for (int col = 0; col < base.cols; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, base.cols - col);
+
+            e1nUnpackRow(base,  row, col, count, b0, b1, b2);
+            e1nUnpackRow(layer, row, col, count, l0, l1, l2, useAlpha ? l3 : nullptr);
+
+            BuildCoverage(cov, count, opacity, mask, row, col, useAlpha ? l3 : nullptr);
+
+            kernel(b0, b1, b2, l0, l1, l2, cov, count);
+
+            e1nPackRow(base, row, col, count, b0, b1, b2);
+        }
+    }
+}
+
+void e1nBlend(e1nColorPlanes &base, const e1nColorPlanes &layer, const e1nBlendMode mode, const float opacity, const e1nMask &mask)
+{
+    CV_Assert(base.Rows() == layer.Rows() && base.Cols() == layer.Cols());
+    CV_Assert(mask.Empty() || mask.GetSize() == Size(base.Cols(), base.Rows()));
+
+    E1N_TRACE_OP("e1nBlend", (uint64_t) base.Rows() * base.Cols(), (uint64_t) base.Rows() * base.Cols() * 36);
+
+    e1nKernelTable::BlendFn kernel   = GetBlendKernel(mode);
+    bool                    useAlpha = mode == E1N_BLEND_ALPHA && layer.HasAlpha();
+
+    alignas(64) float cov[E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < base.Rows(); ++row)
+    {
+        for (int col = 0; col < base.Cols(); col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, base.Cols() - col);
+
+            BuildCoverage(cov, count, opacity, mask, row, col, useAlpha ? layer.Row(3, row) + col : nullptr);
+
+            kernel(base.Row(0, row) + col, base.Row(1, row) + col, base.Row(2, row) + col,
+                   layer.Row(0, row) + col, layer.Row(1, row) + col, layer.Row(2, row) + col,
+                   cov, count);
+        }
+    }
+}
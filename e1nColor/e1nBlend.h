@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nBlend.h - Interface definition file for the e1nColor blending functions.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NBLEND_H
+#define E1NBLEND_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorBatch.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Masked, Photoshop-like layer blending. Each call blends a layer into a base image in place in
+// a single pass:
+//
+//      base = base + (Blend(base, layer) - base) * opacity * mask
+//
+// E1N_BLEND_ALPHA additionally weights by the layer's own alpha channel (treated as 1.0 if it has
+// none). The base's alpha channel, if any, is left untouched. Both images must be RGB, the same
+// size, & CV_8UC3/4, CV_16UC3/4 or CV_32FC3/4 (the depths may differ); or e1nColorPlanes buffers.
+//====================================================================================================
+
+enum e1nBlendMode
+{
+    E1N_BLEND_OPACITY,                  // The layer over the base at the given opacity.
+    E1N_BLEND_ALPHA,                    // As above, also weighted by the layer's alpha.
+    E1N_BLEND_MULTIPLY,                 // base * layer.
+    E1N_BLEND_SCREEN,                   // 1 - (1 - base) * (1 - layer).
+    E1N_BLEND_OVERLAY,                  // Multiply below base 0.5, screen above.
+    E1N_BLEND_HUE,                      // The layer's hue with the base's lightness & saturation.
+    E1N_BLEND_SATURATION,               // The layer's saturation with the base's hue & lightness.
+    E1N_BLEND_LIGHTEN,                  // Per-channel max.
+    E1N_BLEND_DARKEN                    // Per-channel min.
+};
+
+//----------------------------------------------------------------------------------------------------
+// Blending functions:
+//----------------------------------------------------------------------------------------------------
+
+void e1nBlend(Mat &base, const Mat &layer, const e1nBlendMode mode,
+              const float opacity = 1.0f, const e1nMask &mask = e1nMask());
+
+void e1nBlend(e1nColorPlanes &base, const e1nColorPlanes &layer, const e1nBlendMode mode,
+              const float opacity = 1.0f, const e1nMask &mask = e1nMask());
+
+#endif     // E1NBLEND_H
@@ -8,11 +8,13 @@
 // Includes:
 #include "lib/stdafx.h"
 #include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorKernels.h"
 #include <opencv2/opencv.hpp>               // Some functions require the OpenCV library.
 
 // Preprocessor directives:
 using namespace std;
 using namespace cv;
+using namespace e1nSimd;
 
 //====================================================================================================
 // Constructors:
@@ -30,18 +32,18 @@ e1nColor::e1nColor()
 // Single-Byte per channel RGB initialization.
 e1nColor::e1nColor(const unsigned char rVal, const unsigned char gVal, const unsigned char bVal)
 {
-	r = rVal / 255.0f;		// Red
-	g = gVal / 255.0f;		// Green
-	b = bVal / 255.0f;		// Blue
-	a = 1.0f;				// Alpha defaults to white.
+	r = e1nByteToFloat(rVal);		// Red
+	g = e1nByteToFloat(gVal);		// Green
+	b = e1nByteToFloat(bVal);		// Blue
+	a = 1.0f;						// Alpha defaults to white.
 }
 
 e1nColor::e1nColor(const unsigned char rVal, const unsigned char gVal, const unsigned char bVal, const unsigned char aVal)     // Single-Byte per channel RGBA initialization.
 {
-	r = rVal / 255.0f;		// Red
-	g = gVal / 255.0f;		// Green
-	b = bVal / 255.0f;		// Blue
-	a = aVal / 255.0f;		// Alpha
+	r = e1nByteToFloat(rVal);		// Red
+	g = e1nByteToFloat(gVal);		// Green
+	b = e1nByteToFloat(bVal);		// Blue
+	a = e1nByteToFloat(aVal);		// Alpha
 }
 
 // RGB Floating-Point initialization.
@@ -65,9 +67,9 @@ e1nColor::e1nColor(const float rVal, const float gVal, const float bVal, const f
 // OpenCV Mat pixel initialization. Single-byte per channel RGB vector.
 e1nColor::e1nColor(Vec3b &someRGB_888)
 {
-    r = someRGB_888[0] / 255.0f;        // Red
-    g = someRGB_888[1] / 255.0f;        // Green
-    b = someRGB_888[2] / 255.0f;        // Blur
+    r = e1nByteToFloat(someRGB_888[0]); // Red
+    g = e1nByteToFloat(someRGB_888[1]); // Green
+    b = e1nByteToFloat(someRGB_888[2]); // Blur
     a = 1.0f;                           // Alpha Defaults to White
 }
 
@@ -93,11 +95,9 @@ ostream &operator <<(ostream &os, e1nColor &someColor)
 // Print function (for debugging).
 void e1nColor::print(ostream *os)
 {
-	float h = e1nColor::GetHue();
-	float s = e1nColor::GetSat();
-	float v = e1nColor::GetVal();
+	e1nHLS hls = GetHLS();
 	
-	cout << "\nRed: " << r << "  Green:" << g << "  Blue: " << b << " | Hue: " << h << "  Saturation: " << s << "  Value: " << v << "\n";
+	*os << "\nRed: " << r << "  Green:" << g << "  Blue: " << b << " | Hue: " << hls.hue << "  Saturation: " << hls.sat << "  Value: " << hls.val << "\n";
 }
 
 //====================================================================================================
@@ -126,43 +126,7 @@ float e1nColor::GetMinRGB()
 
 float e1nColor::GetHue()                // Get the color's position on the hue wheel (such as red vs. orange or blue).
 {
-	// Find Min, Max, & Delta:
-	float max   = GetMaxRGB();
-	float min   = GetMinRGB();
-	float delta = max - min;
-	
-	// Invert the color into its complement.
-	float Rc;
-	float Gc;
-	float Bc;
-	
-	if (delta == 0.0f)
-	{
-		Rc = 0.0f;
-		Gc = 0.0f;
-		Bc = 0.0f;
-	}
-	else
-	{
-		Rc = (max - r) / delta;
-		Gc = (max - g) / delta;
-		Bc = (max - b) / delta;
-	}
-	
-	// Calculate the color's 0-360º floating-point Hue.
-	float h;
-	
-	if 		(r == max) {h = 60.0f * (Bc - Gc);}
-	else if (g == max) {h = 60.0f * (2.0 + Rc - Bc);}
-	else			   {h = 60.0f * (4.0 + Gc - Rc);}
-	
-	// Correct for negative results in the 300º - 359.9º (Magenta to Red) range.
-	if (h < 0.0f){h = h + 360.0f;}
-    
-    // And reduce the 0-360º hue range to 0-1.
-    h = h / 360.0f;
-	
-    return h;
+    return GetHLS().hue;
 }
 
 float e1nColor::GetSat()                // Get the intensity of a color. It's hue-purity if you will.
@@ -189,24 +153,87 @@ float e1nColor::GetVal()                // Get the lightness (value) of a color.
     return v;
 }
 
+//     Hue, saturation & value in one pass, along with the min, max & delta they are built from. This
+// is the reference version of the math: ConvertRGB2HLS() is built on it, & AnalyzeHLS() in
+// e1nColorKernels.h mirrors it for the batch functions, so a change here needs repeating there.
+e1nHLS e1nColor::GetHLS()
+{
+    e1nHLS hls;
+    
+    // Find Min, Max, & Delta, once:
+    hls.max   = GetMaxRGB();
+    hls.min   = GetMinRGB();
+    hls.delta = hls.max - hls.min;
+    
+    // Invert the color into its complement. A gray has max == r == g == b, so dividing its zero
+    // numerators by one gives zeroed complements without a branch.
+    float div = hls.delta == 0.0f ? 1.0f : hls.delta;
+    
+    float Rc = (hls.max - r) / div;
+    float Gc = (hls.max - g) / div;
+    float Bc = (hls.max - b) / div;
+    
+    // Calculate the 0-1 floating-point brightness Value & Saturation.
+    hls.val = (hls.max + hls.min) / 2.0f;
+    hls.sat = hls.delta;
+    
+    // Calculate the color's 0-360º floating-point Hue.
+    float h;
+    
+    if      (r == hls.max) {h = 60.0f * (Bc - Gc);}
+    else if (g == hls.max) {h = 60.0f * (2.0f + Rc - Bc);}
+    else                   {h = 60.0f * (4.0f + Gc - Rc);}
+    
+    // Correct for negative results in the 300º - 359.9º (Magenta to Red) range.
+    if (h < 0.0f){h = h + 360.0f;}
+    
+    // And reduce the 0-360º hue range to 0-1.
+    hls.hue = h / 360.0f;
+    
+    return hls;
+}
+
 //----------------------------------------------------------------------------------------------------
 // Hue, Saturation, and Value Assignment Functions:
 //----------------------------------------------------------------------------------------------------
 
+//     Each of these takes the color through HLS & back, swapping in the new component on the way.
+// The adjustment kernels shared with the batch functions do the swap, so hue wraps around into 0-1,
+// value clamps to 0-1, & saturation clamps to what the lightness can hold (2 * min(l, 1 - l)).
+// Setting the hue of a gray leaves it gray. Alpha is untouched.
+
+template <int Op> static void AdjustColor(float &c0, float &c1, float &c2, const float amount)
+{
+    e1nF32x1 h = c0;
+    e1nF32x1 l = c1;
+    e1nF32x1 s = c2;
+
+    AdjustHLS<Op>(h, l, s, e1nF32x1(amount));
+
+    c0 = h.v;
+    c1 = l.v;
+    c2 = s.v;
+}
+
 void e1nColor::SetHue(const float newHue)
 {
-    // ToDo
+    ConvertRGB2HLS();
+    AdjustColor<E1N_ADJUST_SET_HUE>(r, g, b, newHue);
+    ConvertHLS2RGB();
 }
 
 void e1nColor::SetSat(const float newSat)
 {
-    // ToDo
+    ConvertRGB2HLS();
+    AdjustColor<E1N_ADJUST_SET_SAT>(r, g, b, newSat);
+    ConvertHLS2RGB();
 }
 
-
-void e1nColor::SetVal(float newVal)
+void e1nColor::SetVal(const float newVal)
 {
-    // ToDo
+    ConvertRGB2HLS();
+    AdjustColor<E1N_ADJUST_SET_VAL>(r, g, b, newVal);
+    ConvertHLS2RGB();
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -215,9 +242,9 @@ void e1nColor::SetVal(float newVal)
 
 Vec3b e1nColor::GetVec3b()                      // Reads in a 3-byte OpenCV color from a Mat image.
 {
-    return { (unsigned char) (round(r * 255.0)),
-             (unsigned char) (round(g * 255.0)),
-             (unsigned char) (round(b * 255.0))} ;
+    return { e1nFloatToByte(r),
+             e1nFloatToByte(g),
+             e1nFloatToByte(b)} ;
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -229,52 +256,12 @@ Vec3b e1nColor::GetVec3b()                      // Reads in a 3-byte OpenCV colo
 
 void e1nColor::ConvertRGB2HLS()
 {
-    // Find Min, Max, & Delta:
-    float max = GetMaxRGB();
-    float min = GetMinRGB();
-    float del = max - min;
-    
-    // Invert the color into its complement.
-    float Rc;
-    float Gc;
-    float Bc;
-    
-    if (del == 0.0f)
-    {
-        Rc = 0.0f;
-        Gc = 0.0f;
-        Bc = 0.0f;
-    }
-    else
-    {
-        Rc = (max - r) / del;
-        Gc = (max - g) / del;
-        Bc = (max - b) / del;
-    }
-    
-    // Calculate the 0-1 floating-point brightness Value.
-    float v = ((max + min) / 2.0f);
-    
-    // Calculate the 0-1 floating-point Saturation.
-    float s = del;
-    
-    // Calculate the color's 0-360º floating-point Hue.
-    float h;
-    
-    if      (r == max) {h = 60.0f * (Bc - Gc);}
-    else if (g == max) {h = 60.0f * (2.0 + Rc - Bc);}
-    else               {h = 60.0f * (4.0 + Gc - Rc);}
-    
-    // Correct for negative results in the 300º - 359.9º (Magenta to Red) range.
-    if (h < 0.0f){h = h + 360.0f;}
-    
-    // And reduce the 0-360º hue range to 0-1.
-    h = h / 360.0f;
+    e1nHLS hls = GetHLS();
     
     // Assign the Value, Saturation, and Hue to the Red, Green, and Blue channels respectively.
-    r = h;
-    g = v;
-    b = s;
+    r = hls.hue;
+    g = hls.val;
+    b = hls.sat;
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -372,26 +359,55 @@ void e1nColor::NormalizeRGB()
 }
 
 //----------------------------------------------------------------------------------------------------
-// Color Blending Functions:
+// Power & transfer curves:
 //----------------------------------------------------------------------------------------------------
 
-// Todo: Masked blending functions that encapsulate Photoshop-like blending modes.
-//
-//      1) Opacity Blending
-//      2) Alpha Blending
-//      3) Color Multiplication
-//      4) Color Screening
-//      5) Overlay Blending
-//      6) Hue Blending
-//      7) Saturation Blending
-//      8) Lighten Blending
-//      9) Darken Blending
-//
-// These functions may also end up as part of a future e1nImage class.
+// Runs r, g & b through one of the curve kernels as single lanes.
+template <int Curve> static void TransferRGB(float &r, float &g, float &b, const float exponent = 1.0f)
+{
+    e1nOpTransfer<Curve> op(exponent);
+    e1nF32x1             c0 = r;
+    e1nF32x1             c1 = g;
+    e1nF32x1             c2 = b;
 
+    op(c0, c1, c2);
 
+    r = c0.v;
+    g = c1.v;
+    b = c2.v;
+}
 
+void e1nColor::PowRGB(const float exponent)
+{
+    TransferRGB<E1N_CURVE_POW>(r, g, b, exponent);
+}
 
+void e1nColor::ToLinear(const e1nTransferCurve curve, const float gamma)
+{
+    switch (curve)
+    {
+        case E1N_TRANSFER_LINEAR:                                                          break;
+        case E1N_TRANSFER_SRGB:   TransferRGB<E1N_CURVE_SRGB_TO_LINEAR>  (r, g, b);        break;
+        case E1N_TRANSFER_REC709: TransferRGB<E1N_CURVE_REC709_TO_LINEAR>(r, g, b);        break;
+        case E1N_TRANSFER_GAMMA:  TransferRGB<E1N_CURVE_POW>             (r, g, b, gamma); break;
+    }
+}
 
+void e1nColor::FromLinear(const e1nTransferCurve curve, const float gamma)
+{
+    switch (curve)
+    {
+        case E1N_TRANSFER_LINEAR:                                                                 break;
+        case E1N_TRANSFER_SRGB:   TransferRGB<E1N_CURVE_LINEAR_TO_SRGB>  (r, g, b);               break;
+        case E1N_TRANSFER_REC709: TransferRGB<E1N_CURVE_LINEAR_TO_REC709>(r, g, b);               break;
+        case E1N_TRANSFER_GAMMA:  TransferRGB<E1N_CURVE_POW>             (r, g, b, 1.0f / gamma); break;
+    }
+}
 
+//----------------------------------------------------------------------------------------------------
+// Color Blending Functions:
+//----------------------------------------------------------------------------------------------------
 
+// Masked blending functions that encapsulate Photoshop-like blending modes (opacity, alpha,
+// multiply, screen, overlay, hue, saturation, lighten & darken) are implemented as whole-image batch
+// functions rather than per-color members. See e1nBlend.h.
@@ -10,6 +10,7 @@
 
 #include "lib/stdafx.h"                 // Precompiled headers.
 #include <opencv2/opencv.hpp>           // OpenCV library.
+#include "lib/e1nColor/e1nColorLUT.h"   // Byte <-> float tables.
 #include <istream>
 #include <ostream>
 #include <cmath>
@@ -20,6 +21,35 @@ using namespace cv;
 // Constants:
 #define PI 3.1415927f
 
+//====================================================================================================
+//     e1nHLS - Everything GetHLS() works out about a color in its one pass: hue, saturation & value
+// (as GetHue(), GetSat() & GetVal() return them), plus the min, max & delta of the RGB channels they
+// are derived from.
+//====================================================================================================
+
+struct e1nHLS
+{
+    float hue;          // 0-1 position on the hue wheel.
+    float sat;          // max - min.
+    float val;          // (max + min) / 2.
+    float min;          // Smallest of r, g & b.
+    float max;          // Largest of r, g & b.
+    float delta;        // max - min, kept under its own name for the hue math.
+};
+
+//====================================================================================================
+//     e1nTransferCurve - The encodings ToLinear() & FromLinear() (& their batch forms in e1nTransfer.h)
+// convert between. E1N_TRANSFER_GAMMA is a plain power curve: linear = encoded ^ gamma.
+//====================================================================================================
+
+enum e1nTransferCurve
+{
+    E1N_TRANSFER_LINEAR,                // Already linear; nothing to do.
+    E1N_TRANSFER_SRGB,                  // IEC 61966-2-1, the piecewise sRGB curve.
+    E1N_TRANSFER_REC709,                // ITU-R BT.709 camera curve.
+    E1N_TRANSFER_GAMMA                  // Pure power law.
+};
+
 //====================================================================================================
 // e1nColor - A floating point RGB Color class focused on Hue, Saturation & Value Functionality:
 //====================================================================================================
@@ -82,17 +112,17 @@ public:
     // Red, Blue, and Green channel access functions:
     //----------------------------------------------------------------------------------------------------
 
-    float         GetRedFloat();
-    unsigned char GetRedByte();
+    float         GetRedFloat() const;
+    unsigned char GetRedByte() const;
 	
-    float         GetGreenFloat();
-    unsigned char GetGreenByte();
+    float         GetGreenFloat() const;
+    unsigned char GetGreenByte() const;
 	
-    float         GetBlueFloat();
-    unsigned char GetBlueByte();
+    float         GetBlueFloat() const;
+    unsigned char GetBlueByte() const;
     
-    float         GetAlphaFloat();
-    unsigned char GetAlphaByte();
+    float         GetAlphaFloat() const;
+    unsigned char GetAlphaByte() const;
     
     //----------------------------------------------------------------------------------------------------
     // Red, Blue, Green & Alpha channel assignment functions:
@@ -117,6 +147,9 @@ public:
 	float GetHue();
 	float GetSat();
 	float GetVal();
+
+    // All of the above, & the min/max they come from, for the price of one.
+    e1nHLS GetHLS();
 	
     //----------------------------------------------------------------------------------------------------
     // Hue, Saturation, and Value assignment functions:
@@ -138,9 +171,17 @@ public:
     //----------------------------------------------------------------------------------------------------
 
     void NormalizeRGB();
-    void PowRGB();
+    void PowRGB(const float exponent);                                  // r, g & b to a power; alpha untouched.
     void CopyAlphaToRGB();
 
+    //----------------------------------------------------------------------------------------------------
+    //     Transfer curves. Same polynomial math as the batch forms in e1nTransfer.h, so a color comes out
+    // the same either way. gamma is only used by E1N_TRANSFER_GAMMA.
+    //----------------------------------------------------------------------------------------------------
+
+    void ToLinear  (const e1nTransferCurve curve, const float gamma = 2.2f);
+    void FromLinear(const e1nTransferCurve curve, const float gamma = 2.2f);
+
     //----------------------------------------------------------------------------------------------------
     // Interoperability with OpenCV:
     //----------------------------------------------------------------------------------------------------
@@ -189,33 +230,33 @@ const{
 // Channel Access Functions:
 //----------------------------------------------------------------------------------------------------
 
-inline float 	     e1nColor::GetRedFloat()    {return (float) r;}
-inline unsigned char e1nColor::GetRedByte()     {return (unsigned char) (round(r * 255.0));}
+inline float 	     e1nColor::GetRedFloat() const    {return (float) r;}
+inline unsigned char e1nColor::GetRedByte() const     {return e1nFloatToByte(r);}
 
-inline float	     e1nColor::GetGreenFloat()  {return (float) g;}
-inline unsigned char e1nColor::GetGreenByte()   {return (unsigned char) (round(g * 255.0));}
+inline float	     e1nColor::GetGreenFloat() const  {return (float) g;}
+inline unsigned char e1nColor::GetGreenByte() const   {return e1nFloatToByte(g);}
 
-inline float 	     e1nColor::GetBlueFloat()   {return (float) b;}
-inline unsigned char e1nColor::GetBlueByte()    {return (unsigned char) (round(b * 255.0));}
+inline float 	     e1nColor::GetBlueFloat() const   {return (float) b;}
+inline unsigned char e1nColor::GetBlueByte() const    {return e1nFloatToByte(b);}
 
-inline float         e1nColor::GetAlphaFloat()  {return (float) a;}
-inline unsigned char e1nColor::GetAlphaByte()   {return (unsigned char) (round(a * 255.0));}
+inline float         e1nColor::GetAlphaFloat() const  {return (float) a;}
+inline unsigned char e1nColor::GetAlphaByte() const   {return e1nFloatToByte(a);}
 
 //----------------------------------------------------------------------------------------------------
 // Channel Assignment Functions:
 //----------------------------------------------------------------------------------------------------
 
 inline void e1nColor::SetRed   (const float someFloat)        {r = someFloat;}
-inline void e1nColor::SetRed   (const unsigned char someByte) {r = (float) someByte / 255.0;}
+inline void e1nColor::SetRed   (const unsigned char someByte) {r = e1nByteToFloat(someByte);}
 
 inline void e1nColor::SetGreen (const float someFloat)        {g = someFloat;}
-inline void e1nColor::SetGreen (const unsigned char someByte) {g = (float) someByte / 255.0;}
+inline void e1nColor::SetGreen (const unsigned char someByte) {g = e1nByteToFloat(someByte);}
 
 inline void e1nColor::SetBlue  (const float someFloat)        {b = someFloat;}
-inline void e1nColor::SetBlue  (const unsigned char someByte) {b = (float) someByte / 255.0;}
+inline void e1nColor::SetBlue  (const unsigned char someByte) {b = e1nByteToFloat(someByte);}
 
 inline void e1nColor::SetAlpha (const float someFloat)        {a = someFloat;}
-inline void e1nColor::SetAlpha (const unsigned char someByte) {a = (float) someByte / 255.0;}
+inline void e1nColor::SetAlpha (const unsigned char someByte) {a = e1nByteToFloat(someByte);}
 
 //----------------------------------------------------------------------------------------------------
 // Misc.
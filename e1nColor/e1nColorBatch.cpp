@@ -0,0 +1,500 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nColorBatch.cpp - Implementation file for the e1nColor batch functions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Row unpacking & packing:
+//====================================================================================================
+
+// A chunk's worth of 0.5s: the offset that makes quantizeOffset16 plain rounding.
+static const float *GetHalfOffsets()
+{
+    struct Table
+    {
+        float values[E1N_BATCH_CHUNK];
+
+        Table()
+        {
+            for (int i = 0; i < E1N_BATCH_CHUNK; ++i) {values[i] = 0.5f;}
+        }
+    };
+
+    static const Table table;
+
+    return table.values;
+}
+
+// Unpacks a run of pixels from one row of an interleaved Mat into float planes.
+void e1nUnpackRow(const Mat &image, const int row, const int col, const int count, float *c0, float *c1, float *c2, float *c3)
+{
+    int cn = image.channels();
+
+    if (image.depth() == CV_8U)
+    {
+        const float         *decode = e1nGetByteDecodeTable();
+        const unsigned char *p      = image.ptr<unsigned char>(row) + col * cn;
+
+        for (int i = 0; i < count; ++i, p += cn)
+        {
+            c0[i] = decode[p[0]];
+            c1[i] = decode[p[1]];
+            c2[i] = decode[p[2]];
+        }
+
+        if (c3 && cn == 4)
+        {
+            p = image.ptr<unsigned char>(row) + col * cn;
+
+            for (int i = 0; i < count; ++i, p += cn) {c3[i] = decode[p[3]];}
+        }
+    }
+    else if (image.depth() == CV_16U)
+    {
+        const float           scale = 1.0f / 65535.0f;
+        const unsigned short *p     = image.ptr<unsigned short>(row) + col * cn;
+
+        for (int i = 0; i < count; ++i, p += cn)
+        {
+            c0[i] = p[0] * scale;
+            c1[i] = p[1] * scale;
+            c2[i] = p[2] * scale;
+        }
+
+        if (c3 && cn == 4)
+        {
+            p = image.ptr<unsigned short>(row) + col * cn;
+
+            for (int i = 0; i < count; ++i, p += cn) {c3[i] = p[3] * scale;}
+        }
+    }
+    else
+    {
+        const float *p = image.ptr<float>(row) + col * cn;
+
+        for (int i = 0; i < count; ++i, p += cn)
+        {
+            c0[i] = p[0];
+            c1[i] = p[1];
+            c2[i] = p[2];
+        }
+
+        if (c3 && cn == 4)
+        {
+            p = image.ptr<float>(row) + col * cn;
+
+            for (int i = 0; i < count; ++i, p += cn) {c3[i] = p[3];}
+        }
+    }
+
+    // No alpha channel in the image? Alpha defaults to white, as in the e1nColor constructors.
+    if (c3 && cn == 3)
+    {
+        for (int i = 0; i < count; ++i) {c3[i] = 1.0f;}
+    }
+}
+
+// Quantizes each plane a chunk at a time in SIMD, then interleaves the results into the row.
+template <typename T, class Quantize> static void PackQuantized(Mat &image, const int row, const int col, const int count,
+                                                                const float *const *c, const Quantize &quantize)
+{
+    int cn     = image.channels();
+    int planes = c[3] ? 4 : 3;
+
+    alignas(64) T q[4][E1N_BATCH_CHUNK];
+
+    for (int start = 0; start < count; start += E1N_BATCH_CHUNK)
+    {
+        int n = min(E1N_BATCH_CHUNK, count - start);
+        T  *p = image.ptr<T>(row) + (col + start) * cn;
+
+        for (int k = 0; k < planes; ++k) {quantize(c[k] + start, q[k], n);}
+
+        for (int i = 0; i < n; ++i, p += cn)
+        {
+            p[0] = q[0][i];
+            p[1] = q[1][i];
+            p[2] = q[2][i];
+        }
+
+        if (planes == 4)
+        {
+            p = image.ptr<T>(row) + (col + start) * cn;
+
+            for (int i = 0; i < n; ++i, p += cn) {p[3] = q[3][i];}
+        }
+    }
+}
+
+//     Packs float planes back into a run of pixels. Bytes are clamped & rounded exactly as GetVec3b()
+// does it, & 16-bit words likewise to 0-65535.
+void e1nPackRow(Mat &image, const int row, const int col, const int count, const float *c0, const float *c1, const float *c2, const float *c3)
+{
+    int          cn   = image.channels();
+    const float *c[4] = {c0, c1, c2, c3 && cn == 4 ? c3 : nullptr};
+
+    if (image.depth() == CV_8U)
+    {
+        PackQuantized<unsigned char>(image, row, col, count, c, e1nGetKernels().quantize8);
+    }
+    else if (image.depth() == CV_16U)
+    {
+        e1nKernelTable::QuantizeOffset16Fn quantize = e1nGetKernels().quantizeOffset16;
+        const float                       *half     = GetHalfOffsets();
+
+        PackQuantized<unsigned short>(image, row, col, count, c, [quantize, half](const float *x, unsigned short *out, const int n)
+        {
+            quantize(x, half, out, n);
+        });
+    }
+    else
+    {
+        float *p = image.ptr<float>(row) + col * cn;
+
+        for (int i = 0; i < count; ++i, p += cn)
+        {
+            p[0] = c0[i];
+            p[1] = c1[i];
+            p[2] = c2[i];
+        }
+
+        if (c[3])
+        {
+            p = image.ptr<float>(row) + col * cn;
+
+            for (int i = 0; i < count; ++i, p += cn) {p[3] = c3[i];}
+        }
+    }
+}
+
+//====================================================================================================
+// Masks:
+//====================================================================================================
+
+e1nMask::e1nMask() : bitCols(0), bitOffset(0)
+{
+}
+
+e1nMask::e1nMask(const Mat &maskImage) : bitCols(0), bitOffset(0)
+{
+    CV_Assert(maskImage.empty() || maskImage.type() == CV_8UC1 || maskImage.type() == CV_32FC1);
+
+    weights = maskImage;
+}
+
+e1nMask::e1nMask(const Mat &bits, const int numCols) : bitCols(numCols), bitOffset(0)
+{
+    CV_Assert(bits.type() == CV_8UC1 && numCols > 0 && bits.cols * 8 >= numCols);
+
+    weights = bits;
+}
+
+bool e1nMask::Empty() const
+{
+    return weights.empty();
+}
+
+Size e1nMask::GetSize() const
+{
+    return bitCols ? Size(bitCols, weights.rows) : weights.size();
+}
+
+e1nMask e1nMask::Region(const Rect &roi) const
+{
+    if (!bitCols) {return Empty() ? e1nMask() : e1nMask(weights(roi));}
+
+    CV_Assert(roi.x >= 0 && roi.width > 0 && roi.x + roi.width <= bitCols);
+
+    // Keep whole bytes, & remember how far into the first one the region starts.
+    int     first = bitOffset + roi.x;
+    int     last  = first + roi.width - 1;
+    e1nMask region(weights(Rect(first / 8, roi.y, last / 8 - first / 8 + 1, roi.height)), roi.width);
+
+    region.bitOffset = first % 8;
+
+    return region;
+}
+
+void e1nMask::UnpackRow(const int row, const int col, const int count, float *dst) const
+{
+    if (weights.empty())
+    {
+        for (int i = 0; i < count; ++i) {dst[i] = 1.0f;}
+    }
+    else if (bitCols)
+    {
+        const unsigned char *p   = weights.ptr<unsigned char>(row);
+        int                  bit = bitOffset + col;
+
+        for (int i = 0; i < count; ++i, ++bit) {dst[i] = (float) ((p[bit >> 3] >> (bit & 7)) & 1);}
+    }
+    else if (weights.depth() == CV_8U)
+    {
+        const unsigned char *p = weights.ptr<unsigned char>(row) + col;
+
+        for (int i = 0; i < count; ++i) {dst[i] = p[i] / 255.0f;}
+    }
+    else
+    {
+        const float *p = weights.ptr<float>(row) + col;
+
+        for (int i = 0; i < count; ++i) {dst[i] = p[i];}
+    }
+}
+
+//====================================================================================================
+// Kernel drivers:
+//====================================================================================================
+// Runs a three-plane kernel over every pixel of an interleaved image one chunk at a time, or straight
+// over the rows of a planar one. Kernels come from e1nGetKernels(), looked up once per call.
+//----------------------------------------------------------------------------------------------------
+
+static void RunInterleaved(Mat &image, const e1nConvertKernel kernel)
+{
+    CV_Assert(image.type() == CV_8UC3 || image.type() == CV_32FC3);
+
+    e1nKernelTable::ConvertFn convert = e1nGetKernels().convert[kernel];
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        for (int col = 0; col < image.cols; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, image.cols - col);
+
+            e1nUnpackRow(image, row, col, count, c0, c1, c2);
+            convert(c0, c1, c2, count);
+            e1nPackRow(image, row, col, count, c0, c1, c2);
+        }
+    }
+}
+
+static void RunPlanar(e1nColorPlanes &planes, const e1nConvertKernel kernel)
+{
+    e1nKernelTable::ConvertFn convert = e1nGetKernels().convert[kernel];
+
+    for (int row = 0; row < planes.Rows(); ++row)
+    {
+        convert(planes.Row(0, row), planes.Row(1, row), planes.Row(2, row), planes.Cols());
+    }
+}
+
+// Trace names for the adjustments, indexed by e1nAdjustKernel.
+static const char *const adjustNames[] =
+{
+    "e1nSetHue", "e1nShiftHue", "e1nSetSat", "e1nScaleSat", "e1nSetVal", "e1nShiftVal", "e1nScaleVal"
+};
+
+// The same for the HLS adjustments, which also take an amount & an optional mask.
+template <int Op> static void AdjustInterleaved(Mat &image, const float amount, const e1nMask &mask)
+{
+    CV_Assert(image.type() == CV_8UC3 || image.type() == CV_32FC3);
+    CV_Assert(mask.Empty() || mask.GetSize() == image.size());
+
+    E1N_TRACE_OP(adjustNames[Op], image.total(), image.total() * image.elemSize() * 2);
+
+    e1nKernelTable::AdjustFn adjust = e1nGetKernels().adjust[Op];
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+    alignas(64) float m [E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        for (int col = 0; col < image.cols; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, image.cols - col);
+
+            if (!mask.Empty()) {mask.UnpackRow(row, col, count, m);}
+
+            e1nUnpackRow(image, row, col, count, c0, c1, c2);
+            adjust(c0, c1, c2, mask.Empty() ? nullptr : m, count, amount);
+            e1nPackRow(image, row, col, count, c0, c1, c2);
+        }
+    }
+}
+
+template <int Op> static void AdjustPlanar(e1nColorPlanes &planes, const float amount, const e1nMask &mask)
+{
+    CV_Assert(mask.Empty() || mask.GetSize() == Size(planes.Cols(), planes.Rows()));
+
+    E1N_TRACE_OP(adjustNames[Op], (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    e1nKernelTable::AdjustFn adjust = e1nGetKernels().adjust[Op];
+
+    if (mask.Empty())
+    {
+        for (int row = 0; row < planes.Rows(); ++row)
+        {
+            adjust(planes.Row(0, row), planes.Row(1, row), planes.Row(2, row), nullptr, planes.Cols(), amount);
+        }
+
+        return;
+    }
+
+    alignas(64) float m[E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < planes.Rows(); ++row)
+    {
+        for (int col = 0; col < planes.Cols(); col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, planes.Cols() - col);
+
+            mask.UnpackRow(row, col, count, m);
+
+            adjust(planes.Row(0, row) + col, planes.Row(1, row) + col, planes.Row(2, row) + col, m, count, amount);
+        }
+    }
+}
+
+//====================================================================================================
+// Batch color space conversions:
+//====================================================================================================
+
+void e1nConvertRGB2HLS(Mat &image)
+{
+    E1N_TRACE_OP("e1nConvertRGB2HLS", image.total(), image.total() * image.elemSize() * 2);
+
+    RunInterleaved(image, E1N_CONVERT_RGB2HLS);
+}
+
+void e1nConvertHLS2RGB(Mat &image)
+{
+    E1N_TRACE_OP("e1nConvertHLS2RGB", image.total(), image.total() * image.elemSize() * 2);
+
+    RunInterleaved(image, E1N_CONVERT_HLS2RGB);
+}
+
+void e1nConvertRGB2HLS(e1nColorPlanes &planes)
+{
+    E1N_TRACE_OP("e1nConvertRGB2HLS", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    RunPlanar(planes, E1N_CONVERT_RGB2HLS);
+}
+
+void e1nConvertHLS2RGB(e1nColorPlanes &planes)
+{
+    E1N_TRACE_OP("e1nConvertHLS2RGB", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    RunPlanar(planes, E1N_CONVERT_HLS2RGB);
+}
+
+void e1nConvertRGB2HLS(float *c0, float *c1, float *c2, const size_t count)
+{
+    e1nGetKernels().convert[E1N_CONVERT_RGB2HLS](c0, c1, c2, count);
+}
+
+void e1nConvertHLS2RGB(float *c0, float *c1, float *c2, const size_t count)
+{
+    e1nGetKernels().convert[E1N_CONVERT_HLS2RGB](c0, c1, c2, count);
+}
+
+//====================================================================================================
+// Batch analysis:
+//====================================================================================================
+//     Outputs are indexed in the order the analysis kernel writes them: hue, value (lightness),
+// saturation, min, max, delta. Float outputs are written straight into their rows; byte outputs &
+// the ones nobody asked for go through scratch runs.
+//----------------------------------------------------------------------------------------------------
+
+template <class Source> static void AnalyzeImage(const Size size, Mat **outputs, const Source &source)
+{
+    for (int k = 0; k < 6; ++k)
+    {
+        if (outputs[k] && !(outputs[k]->type() == CV_8UC1 && outputs[k]->size() == size)) {outputs[k]->create(size, CV_32FC1);}
+    }
+
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    alignas(64) float rgb[3][E1N_BATCH_CHUNK];
+    alignas(64) float scratch[6][E1N_BATCH_CHUNK];
+
+    for (int row = 0; row < size.height; ++row)
+    {
+        for (int col = 0; col < size.width; col += E1N_BATCH_CHUNK)
+        {
+            int          count = min(E1N_BATCH_CHUNK, size.width - col);
+            const float *c[3]  = {rgb[0], rgb[1], rgb[2]};
+            float       *dst[6];
+
+            source(row, col, count, c);
+
+            for (int k = 0; k < 6; ++k)
+            {
+                dst[k] = outputs[k] && outputs[k]->depth() == CV_32F ? outputs[k]->ptr<float>(row) + col : scratch[k];
+            }
+
+            kernels.analyze[outputs[0] ? 1 : 0](c[0], c[1], c[2], dst[0], dst[1], dst[2], dst[3], dst[4], dst[5], count);
+
+            for (int k = 0; k < 6; ++k)
+            {
+                if (outputs[k] && outputs[k]->depth() == CV_8U) {kernels.quantize8(scratch[k], outputs[k]->ptr<unsigned char>(row) + col, count);}
+            }
+        }
+    }
+}
+
+void e1nAnalyzeHLS(const Mat &rgbImage, Mat *hue, Mat *sat, Mat *val, Mat *minimum, Mat *maximum, Mat *delta)
+{
+    CV_Assert(rgbImage.type() == CV_8UC3 || rgbImage.type() == CV_8UC4 || rgbImage.type() == CV_32FC3 || rgbImage.type() == CV_32FC4);
+
+    Mat  input      = rgbImage;         // Held in case an output shares its buffer.
+    Mat *outputs[6] = {hue, val, sat, minimum, maximum, delta};
+
+    E1N_TRACE_OP("e1nAnalyzeHLS", input.total(), input.total() * input.elemSize());
+
+    AnalyzeImage(input.size(), outputs, [&input](const int row, const int col, const int count, const float **c)
+    {
+        e1nUnpackRow(input, row, col, count, (float *) c[0], (float *) c[1], (float *) c[2]);
+    });
+}
+
+void e1nAnalyzeHLS(const e1nColorPlanes &rgbPlanes, Mat *hue, Mat *sat, Mat *val, Mat *minimum, Mat *maximum, Mat *delta)
+{
+    Mat *outputs[6] = {hue, val, sat, minimum, maximum, delta};
+
+    E1N_TRACE_OP("e1nAnalyzeHLS", (uint64_t) rgbPlanes.Rows() * rgbPlanes.Cols(), (uint64_t) rgbPlanes.Rows() * rgbPlanes.Cols() * 12);
+
+    AnalyzeImage(Size(rgbPlanes.Cols(), rgbPlanes.Rows()), outputs, [&rgbPlanes](const int row, const int col, const int, const float **c)
+    {
+        for (int k = 0; k < 3; ++k) {c[k] = rgbPlanes.Row(k, row) + col;}
+    });
+}
+
+//====================================================================================================
+// Batch hue, saturation & value adjustments:
+//====================================================================================================
+
+void e1nSetHue  (Mat &hlsImage, const float newHue, const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SET_HUE>  (hlsImage, newHue, mask);}
+void e1nShiftHue(Mat &hlsImage, const float delta,  const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SHIFT_HUE>(hlsImage, delta,  mask);}
+void e1nSetSat  (Mat &hlsImage, const float newSat, const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SET_SAT>  (hlsImage, newSat, mask);}
+void e1nScaleSat(Mat &hlsImage, const float factor, const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SCALE_SAT>(hlsImage, factor, mask);}
+void e1nSetVal  (Mat &hlsImage, const float newVal, const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SET_VAL>  (hlsImage, newVal, mask);}
+void e1nShiftVal(Mat &hlsImage, const float delta,  const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SHIFT_VAL>(hlsImage, delta,  mask);}
+void e1nScaleVal(Mat &hlsImage, const float factor, const e1nMask &mask) {AdjustInterleaved<E1N_ADJUST_SCALE_VAL>(hlsImage, factor, mask);}
+
+void e1nSetHue  (e1nColorPlanes &hlsPlanes, const float newHue, const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SET_HUE>  (hlsPlanes, newHue, mask);}
+void e1nShiftHue(e1nColorPlanes &hlsPlanes, const float delta,  const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SHIFT_HUE>(hlsPlanes, delta,  mask);}
+void e1nSetSat  (e1nColorPlanes &hlsPlanes, const float newSat, const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SET_SAT>  (hlsPlanes, newSat, mask);}
+void e1nScaleSat(e1nColorPlanes &hlsPlanes, const float factor, const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SCALE_SAT>(hlsPlanes, factor, mask);}
+void e1nSetVal  (e1nColorPlanes &hlsPlanes, const float newVal, const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SET_VAL>  (hlsPlanes, newVal, mask);}
+void e1nShiftVal(e1nColorPlanes &hlsPlanes, const float delta,  const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SHIFT_VAL>(hlsPlanes, delta,  mask);}
+void e1nScaleVal(e1nColorPlanes &hlsPlanes, const float factor, const e1nMask &mask) {AdjustPlanar<E1N_ADJUST_SCALE_VAL>(hlsPlanes, factor, mask);}
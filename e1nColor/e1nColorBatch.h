@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorBatch.h - Whole-image (batch) versions of the e1nColor operations.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORBATCH_H
+#define E1NCOLORBATCH_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     The batch functions apply one e1nColor operation to every pixel of an image in place, without
+// building an e1nColor per pixel. Channels are read in the same order as e1nColor(Vec3b &), i.e.
+// channel 0 is red (or hue, once converted), channel 1 green (lightness) & channel 2 blue
+// (saturation).
+//
+//     Every batch function comes in two flavors: one over an interleaved cv::Mat & one over an
+// e1nColorPlanes buffer, which skips the unpacking entirely & only touches the planes it needs.
+//
+//     Supported Mat types are CV_8UC3 & CV_32FC3. Byte images hold every channel, hue included,
+// as 0-255 for 0-1. Rows are processed in short runs that are unpacked into float planes, run
+// through a SIMD kernel & packed back, so ROIs & non-continuous Mats work as well. The kernels are
+// picked at runtime for the best instruction set the CPU has (scalar, SSE4, AVX2 or AVX-512, see
+// e1nGetKernels() in e1nCpuDispatch.h), or a lower one forced by e1nSetCpuLevel() or the
+// E1N_CPU_LEVEL environment variable.
+//
+// Accuracy against the scalar member functions:
+//
+//      CV_32FC3 - Bit-identical to ConvertRGB2HLS() / ConvertHLS2RGB(), since the kernels perform the
+//                 same float operations in the same order. The one exception is a compiler that is
+//                 allowed to fuse multiply-adds (e.g. -mfma with -ffp-contract=fast) doing so in
+//                 one build of the code but not the other, which can move a channel by 1 ulp.
+//      CV_8UC3  - Identical to e1nColor(Vec3b &) -> Convert*() -> GetVec3b() for all 16.7M 8-bit
+//                 inputs.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+//     e1nMask - An optional per-pixel weight for the masked batch functions. Wraps a CV_8UC1 (0-255)
+// or CV_32FC1 (0-1) Mat the same size as the image, without copying it. An empty mask means full
+// coverage everywhere, so masked functions can default their mask argument to e1nMask().
+//
+//     A mask can also wrap packed bits (as e1nKeyHLSBits() writes): a CV_8UC1 Mat of at least
+// (numCols + 7) / 8 bytes per row, pixel i in bit i % 8 (lowest first) of byte i / 8, a set bit
+// meaning full weight.
+//----------------------------------------------------------------------------------------------------
+
+class e1nMask
+{
+private:
+
+    Mat weights;                        // The wrapped mask, or an empty Mat.
+    int bitCols;                        // Width in pixels of a packed-bit mask, 0 for the other kinds.
+    int bitOffset;                      // Bit of the first byte that holds the mask's first column.
+
+public:
+
+    e1nMask();
+    e1nMask(const Mat &maskImage);      // Deliberately implicit, so a Mat can be passed directly.
+    e1nMask(const Mat &bits, const int numCols);
+
+    bool Empty() const;
+    Size GetSize() const;
+
+    e1nMask Region(const Rect &roi) const;
+
+    // Unpacks a run of mask values as 0-1 floats. An empty mask unpacks as all ones.
+    void UnpackRow(const int row, const int col, const int count, float *dst) const;
+};
+
+//----------------------------------------------------------------------------------------------------
+// Functions to convert a whole RGB image to the HLS color space, and back again.
+//----------------------------------------------------------------------------------------------------
+
+void e1nConvertRGB2HLS(Mat &image);
+void e1nConvertHLS2RGB(Mat &image);
+
+void e1nConvertRGB2HLS(e1nColorPlanes &planes);
+void e1nConvertHLS2RGB(e1nColorPlanes &planes);
+
+// The same over bare float planes of count pixels each, for callers that manage their own storage.
+void e1nConvertRGB2HLS(float *c0, float *c1, float *c2, const size_t count);
+void e1nConvertHLS2RGB(float *c0, float *c1, float *c2, const size_t count);
+
+//----------------------------------------------------------------------------------------------------
+//     The batch form of e1nColor::GetHLS(): analyzes an RGB image in one pass & writes any subset of
+// hue, saturation, value, min, max & delta to separate single-channel planes, leaving the image
+// alone. Pass null for the outputs you don't need. An output that is already a CV_8UC1 Mat of the
+// image's size is written as bytes (0-255 for 0-1, hue included); anything else becomes CV_32FC1.
+// Leaving out hue skips its divisions.
+//----------------------------------------------------------------------------------------------------
+
+void e1nAnalyzeHLS(const Mat &rgbImage, Mat *hue, Mat *sat, Mat *val,
+                   Mat *minimum = nullptr, Mat *maximum = nullptr, Mat *delta = nullptr);
+
+void e1nAnalyzeHLS(const e1nColorPlanes &rgbPlanes, Mat *hue, Mat *sat, Mat *val,
+                   Mat *minimum = nullptr, Mat *maximum = nullptr, Mat *delta = nullptr);
+
+//----------------------------------------------------------------------------------------------------
+//     Image-wide hue, saturation & value adjustments. These work on images that are already in HLS
+// (channel 0 hue, 1 lightness, 2 saturation), so a run of edits doesn't go back through RGB between
+// each one, & follow the same rules as e1nColor::SetHue() / SetSat() / SetVal(): hue wraps around,
+// lightness clamps to 0-1 & saturation to what the lightness can hold.
+//
+//     Set replaces the component, Shift adds to it & Scale multiplies it. With a mask the result is
+// mixed with the original per pixel by the mask weight (hue the short way round the wheel), so a
+// feathered mask gives a feathered edit.
+//----------------------------------------------------------------------------------------------------
+
+void e1nSetHue  (Mat &hlsImage, const float newHue, const e1nMask &mask = e1nMask());
+void e1nShiftHue(Mat &hlsImage, const float delta,  const e1nMask &mask = e1nMask());
+void e1nSetSat  (Mat &hlsImage, const float newSat, const e1nMask &mask = e1nMask());
+void e1nScaleSat(Mat &hlsImage, const float factor, const e1nMask &mask = e1nMask());
+void e1nSetVal  (Mat &hlsImage, const float newVal, const e1nMask &mask = e1nMask());
+void e1nShiftVal(Mat &hlsImage, const float delta,  const e1nMask &mask = e1nMask());
+void e1nScaleVal(Mat &hlsImage, const float factor, const e1nMask &mask = e1nMask());
+
+void e1nSetHue  (e1nColorPlanes &hlsPlanes, const float newHue, const e1nMask &mask = e1nMask());
+void e1nShiftHue(e1nColorPlanes &hlsPlanes, const float delta,  const e1nMask &mask = e1nMask());
+void e1nSetSat  (e1nColorPlanes &hlsPlanes, const float newSat, const e1nMask &mask = e1nMask());
+void e1nScaleSat(e1nColorPlanes &hlsPlanes, const float factor, const e1nMask &mask = e1nMask());
+void e1nSetVal  (e1nColorPlanes &hlsPlanes, const float newVal, const e1nMask &mask = e1nMask());
+void e1nShiftVal(e1nColorPlanes &hlsPlanes, const float delta,  const e1nMask &mask = e1nMask());
+void e1nScaleVal(e1nColorPlanes &hlsPlanes, const float factor, const e1nMask &mask = e1nMask());
+
+//----------------------------------------------------------------------------------------------------
+//     Row unpacking & packing between an interleaved CV_8UC3/4, CV_16UC3/4 or CV_32FC3/4 Mat & float
+// planes, with integer samples mapping 0-1 onto their full range. c3 (alpha) may be null. Unpacking
+// with one from a Mat without alpha fills it with 1.0; packing without one leaves the Mat's alpha as
+// it is, so in-place operations keep it.
+//----------------------------------------------------------------------------------------------------
+
+void e1nUnpackRow(const Mat &image, const int row, const int col, const int count,
+                  float *c0, float *c1, float *c2, float *c3 = nullptr);
+
+void e1nPackRow  (Mat &image, const int row, const int col, const int count,
+                  const float *c0, const float *c1, const float *c2, const float *c3 = nullptr);
+
+#endif     // E1NCOLORBATCH_H
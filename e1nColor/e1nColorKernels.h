@@ -0,0 +1,1231 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorKernels.h - Templated planar kernels behind the e1nColor batch functions.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORKERNELS_H
+#define E1NCOLORKERNELS_H
+
+#pragma once
+
+#include "lib/e1nColor/e1nSimd.h"
+#include <cstddef>
+
+// Number of pixels the batch functions unpack from an interleaved Mat into float planes at a time.
+// Small enough that a handful of planes stay in L1 cache, large enough that the unpack loops vectorize.
+#define E1N_BATCH_CHUNK 256
+
+//====================================================================================================
+//     These are the per-register bodies of the batch operations. Each one mirrors the matching
+// scalar member of e1nColor line for line, only with the branches turned into masks & selects, so
+// any change to the scalar math in e1nColor.cpp needs to be repeated here.
+//====================================================================================================
+
+namespace e1nSimd
+{
+
+//----------------------------------------------------------------------------------------------------
+//     Parameter blocks, declared outside the level's namespace so the same block can be handed to the
+// kernel of whichever level e1nGetKernels() picked. What the fields mean is described with the
+// kernels that use them, below.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nKeyKernel
+{
+    float hueCenter, hueHalf, invHueSoft;
+    float satLow, satHigh, invSatSoft;
+    float valLow, valHigh, invValSoft;
+    bool  invert;
+};
+
+struct e1nLUT3DKernel
+{
+    const float *plane[3];              // The lattice's r, g & b outputs.
+    float        scale[3];              // Input to lattice coordinates: x * scale + offset.
+    float        offset[3];
+    float        last;                  // size - 1, the highest lattice coordinate.
+    float        stride[3];             // 1, size & size^2.
+};
+
+struct e1nPaletteKernel
+{
+    const float *h, *l, *s;             // The centroids, as three planes.
+    int          count;
+    float        hueWeight;
+};
+
+inline namespace E1N_SIMD_ISA
+{
+
+//----------------------------------------------------------------------------------------------------
+//     RGB analysis. Mirrors e1nColor::GetHLS(): hue, lightness & saturation together with the min, max
+// & delta they're derived from, all from one pass over (r, g, b).
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void AnalyzeHLS(const V r, const V g, const V b, V &h, V &l, V &s, V &min, V &max, V &del)
+{
+    typedef typename V::Mask M;
+
+    // Find Min, Max, & Delta:
+    max = Max(r, Max(g, b));
+    min = Min(r, Min(g, b));
+    del = max - min;
+
+    // Invert the color into its complement. A zero delta means max == r == g == b, so the numerators
+    // are already zero & dividing them by one gives the scalar code's zeroed complements.
+    V div = Select(del == V(0.0f), V(1.0f), del);
+
+    V Rc = (max - r) / div;
+    V Gc = (max - g) / div;
+    V Bc = (max - b) / div;
+
+    // Calculate the 0-1 floating-point brightness Value & Saturation.
+    l = (max + min) * V(0.5f);
+    s = del;
+
+    // Calculate the color's 0-360º floating-point Hue.
+    M rMax = r == max;
+    M gMax = g == max;
+
+    h = Select(rMax, V(60.0f) * (Bc - Gc),
+        Select(gMax, V(60.0f) * (V(2.0f) + Rc - Bc),
+                     V(60.0f) * (V(4.0f) + Gc - Rc)));
+
+    // Correct for negative results in the 300º - 359.9º (Magenta to Red) range.
+    h = Select(h < V(0.0f), h + V(360.0f), h);
+
+    // And reduce the 0-360º hue range to 0-1.
+    h = h / V(360.0f);
+}
+
+//----------------------------------------------------------------------------------------------------
+// RGB to HLS. Mirrors e1nColor::ConvertRGB2HLS(); (c0, c1, c2) go in as (r, g, b) & come out as
+// (h, l, s).
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void RGB2HLS(V &c0, V &c1, V &c2)
+{
+    V min, max, del;
+
+    AnalyzeHLS(V(c0), V(c1), V(c2), c0, c1, c2, min, max, del);
+}
+
+//----------------------------------------------------------------------------------------------------
+// HLS to RGB. Mirrors e1nColor::ConvertHLS2RGB(). Every sextant of the hue wheel is either a rising
+// or a falling ramp between min & max, so the six branches reduce to one ramp & three selects.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void HLS2RGB(V &c0, V &c1, V &c2)
+{
+    typedef typename V::Mask M;
+
+    V h = c0 * V(360.0f);
+    V v = c1;
+    V s = c2;
+
+    V min = ((V(2.0f) * v) - s) * V(0.5f);
+    V max = s + min;
+
+    // Which sextant is the hue in? Anything outside 0-300º falls through to Magenta to Red, just as
+    // it does in the scalar else branch.
+    M in0 = (h >= V(  0.0f)) & (h < V( 60.0f));   // Red To Yellow.
+    M in1 = (h >= V( 60.0f)) & (h < V(120.0f));   // Yellow to Green.
+    M in2 = (h >= V(120.0f)) & (h < V(180.0f));   // Green to Cyan.
+    M in3 = (h >= V(180.0f)) & (h < V(240.0f));   // Cyan to Blue.
+    M in4 = (h >= V(240.0f)) & (h < V(300.0f));   // Blue to Magenta.
+
+    V base = Select(in0, V(  0.0f),
+             Select(in1, V( 60.0f),
+             Select(in2, V(120.0f),
+             Select(in3, V(180.0f),
+             Select(in4, V(240.0f), V(300.0f))))));
+
+    // Even sextants ramp up from min to max, odd ones ramp back down.
+    M rising = in0 | in2 | in4;
+
+    V t   = (h - base) / V(60.0f);
+    t     = Select(rising, t, V(1.0f) - t);
+    V mid = (t * s) + min;
+
+    // Each channel sits at max, min or the ramp depending on the sextant.
+    V r = Select(in2 | in3, min, Select(in1 | in4, mid, max));
+    V g = Select(in1 | in2, max, Select(in0 | in3, mid, min));
+    V b = Select(in3 | in4, max, Select(in0 | in1, min, mid));
+
+    // No Saturation? No Color.
+    M gray = s == V(0.0f);
+
+    c0 = Select(gray, v, r);
+    c1 = Select(gray, v, g);
+    c2 = Select(gray, v, b);
+}
+
+//----------------------------------------------------------------------------------------------------
+//     HLS adjustments, run on (h, l, s) in place. Hue is a position on a wheel, so it wraps around
+// into 0-1. Lightness clamps to 0-1. Saturation here is max - min, so the most a lightness l can hold
+// is 2 * min(l, 1 - l); anything more couldn't come back out of HLS2RGB() as a real color, so
+// saturation clamps to that, & is re-clamped whenever lightness moves.
+//----------------------------------------------------------------------------------------------------
+
+enum e1nAdjustKernel
+{
+    E1N_ADJUST_SET_HUE,                 // h = x.
+    E1N_ADJUST_SHIFT_HUE,               // h = h + x.
+    E1N_ADJUST_SET_SAT,                 // s = x.
+    E1N_ADJUST_SCALE_SAT,               // s = s * x.
+    E1N_ADJUST_SET_VAL,                 // l = x.
+    E1N_ADJUST_SHIFT_VAL,               // l = l + x.
+    E1N_ADJUST_SCALE_VAL                // l = l * x.
+};
+
+template <class V> inline V WrapHue(const V h)
+{
+    return h - Floor(h);
+}
+
+template <class V> inline V ClampSat(const V s, const V l)
+{
+    return Max(Min(s, V(2.0f) * Min(l, V(1.0f) - l)), V(0.0f));
+}
+
+template <class V> inline V Clamp01(const V x)
+{
+    return Max(Min(x, V(1.0f)), V(0.0f));
+}
+
+template <int Op, class V> inline void AdjustHLS(V &h, V &l, V &s, const V x)
+{
+    switch (Op)
+    {
+        case E1N_ADJUST_SET_HUE:   h = WrapHue(x);             break;
+        case E1N_ADJUST_SHIFT_HUE: h = WrapHue(h + x);         break;
+        case E1N_ADJUST_SET_SAT:   s = ClampSat(x, l);         break;
+        case E1N_ADJUST_SCALE_SAT: s = ClampSat(s * x, l);     break;
+        case E1N_ADJUST_SET_VAL:   l = Clamp01(x);             s = ClampSat(s, l); break;
+        case E1N_ADJUST_SHIFT_VAL: l = Clamp01(l + x);         s = ClampSat(s, l); break;
+        case E1N_ADJUST_SCALE_VAL: l = Clamp01(l * x);         s = ClampSat(s, l); break;
+    }
+}
+
+//     The masked form mixes the adjusted color with the original by a 0-1 weight m. Hue is mixed the
+// short way round the wheel, so a half-weighted shift from 0.95 to 0.05 lands on 0.0 rather than 0.5.
+// Saturation is mixed between two in-gamut values for lightnesses that are mixed alike, so it stays
+// in gamut.
+template <int Op, class V> inline void AdjustHLS(V &h, V &l, V &s, const V x, const V m)
+{
+    V h1 = h;
+    V l1 = l;
+    V s1 = s;
+
+    AdjustHLS<Op>(h1, l1, s1, x);
+
+    V turn = h1 - h;
+    turn   = turn - Floor(turn + V(0.5f));
+
+    h = WrapHue(h + turn * m);
+    l = l + (l1 - l) * m;
+    s = s + (s1 - s) * m;
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Runs one adjustment over three HLS planes in place, weighted per pixel by a mask plane, or
+// everywhere at full strength when the mask is null.
+//----------------------------------------------------------------------------------------------------
+
+template <int Op, class V> inline void AdjustStep(float *c0, float *c1, float *c2, const float *m, const size_t i, const float x)
+{
+    V h = V::Load(c0 + i);
+    V l = V::Load(c1 + i);
+    V s = V::Load(c2 + i);
+
+    if (m) {AdjustHLS<Op>(h, l, s, V(x), V::Load(m + i));}
+    else   {AdjustHLS<Op>(h, l, s, V(x));}
+
+    h.Store(c0 + i);
+    l.Store(c1 + i);
+    s.Store(c2 + i);
+}
+
+template <int Op, class V> inline void AdjustPlanes(float *c0, float *c1, float *c2, const float *m, const size_t count, const float x)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {AdjustStep<Op, V>       (c0, c1, c2, m, i, x);}
+    for (; i < count; ++i)           {AdjustStep<Op, e1nF32x1>(c0, c1, c2, m, i, x);}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Photoshop-style blend modes. Each one produces the fully blended color, which the driver then
+// mixes with the base by the coverage (opacity x mask x layer alpha).
+//----------------------------------------------------------------------------------------------------
+
+enum e1nBlendKernel
+{
+    E1N_KERNEL_NORMAL,
+    E1N_KERNEL_MULTIPLY,
+    E1N_KERNEL_SCREEN,
+    E1N_KERNEL_OVERLAY,
+    E1N_KERNEL_HUE,
+    E1N_KERNEL_SATURATION,
+    E1N_KERNEL_LIGHTEN,
+    E1N_KERNEL_DARKEN
+};
+
+template <int Mode, class V> inline V BlendChannel(const V b, const V l)
+{
+    switch (Mode)
+    {
+        case E1N_KERNEL_MULTIPLY: return b * l;
+        case E1N_KERNEL_SCREEN:   return V(1.0f) - (V(1.0f) - b) * (V(1.0f) - l);
+        case E1N_KERNEL_OVERLAY:  return Select(b < V(0.5f), V(2.0f) * b * l, V(1.0f) - V(2.0f) * (V(1.0f) - b) * (V(1.0f) - l));
+        case E1N_KERNEL_LIGHTEN:  return Max(b, l);
+        case E1N_KERNEL_DARKEN:   return Min(b, l);
+        default:                  return l;
+    }
+}
+
+//     The hue & saturation modes run both colors through the HLS kernels in registers, swap the one
+// component & come straight back, so no HLS copy of either image is ever written. A gray layer has
+// no hue to give, so the hue mode leaves those pixels alone; likewise a gray base has no hue to
+// saturate. The saturation mode clamps the layer's saturation to what the base lightness can hold,
+// keeping the result in gamut.
+template <int Mode, class V> inline void BlendPixel(V &b0, V &b1, V &b2, V l0, V l1, V l2)
+{
+    if (Mode == E1N_KERNEL_HUE || Mode == E1N_KERNEL_SATURATION)
+    {
+        RGB2HLS(b0, b1, b2);
+        RGB2HLS(l0, l1, l2);
+
+        if (Mode == E1N_KERNEL_HUE)
+        {
+            b0 = Select(l2 == V(0.0f), b0, l0);
+        }
+        else
+        {
+            V limit = V(2.0f) * Min(b1, V(1.0f) - b1);
+
+            b2 = Select(b2 == V(0.0f), b2, Max(Min(l2, limit), V(0.0f)));
+        }
+
+        HLS2RGB(b0, b1, b2);
+    }
+    else
+    {
+        b0 = BlendChannel<Mode>(b0, l0);
+        b1 = BlendChannel<Mode>(b1, l1);
+        b2 = BlendChannel<Mode>(b2, l2);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Blends three layer planes into three base planes in place, weighted per pixel by a coverage
+// plane: base = base + (blend(base, layer) - base) * coverage.
+//----------------------------------------------------------------------------------------------------
+
+template <int Mode, class V> inline void BlendStep(float *b0, float *b1, float *b2,
+                                                   const float *l0, const float *l1, const float *l2,
+                                                   const float *cov, const size_t i)
+{
+    V x0 = V::Load(b0 + i);
+    V x1 = V::Load(b1 + i);
+    V x2 = V::Load(b2 + i);
+
+    V y0 = x0;
+    V y1 = x1;
+    V y2 = x2;
+
+    BlendPixel<Mode>(y0, y1, y2, V::Load(l0 + i), V::Load(l1 + i), V::Load(l2 + i));
+
+    V c = V::Load(cov + i);
+
+    (x0 + (y0 - x0) * c).Store(b0 + i);
+    (x1 + (y1 - x1) * c).Store(b1 + i);
+    (x2 + (y2 - x2) * c).Store(b2 + i);
+}
+
+template <int Mode, class V> inline void BlendPlanes(float *b0, float *b1, float *b2,
+                                                     const float *l0, const float *l1, const float *l2,
+                                                     const float *cov, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {BlendStep<Mode, V>       (b0, b1, b2, l0, l1, l2, cov, i);}
+    for (; i < count; ++i)           {BlendStep<Mode, e1nF32x1>(b0, b1, b2, l0, l1, l2, cov, i);}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Transfer curves. Pow() is exp2(y * log2(x)) with both halves done as short polynomials on the
+// float's exponent & mantissa, so it runs at full register width with no pow() calls: log2 folds the
+// mantissa into [sqrt(1/2), sqrt(2)) & sums the atanh series to t^7, exp2 splits off the integer part
+// & runs exp() to the 6th power around 2^0.5. Against double-precision pow() the relative error is
+// within 3e-7 + 8e-8 * |y| * (1 + |log2(x)|), mostly the float rounding of the exponent itself: 1e-6
+// for the sRGB & Rec.709 curves below, a fifteenth of one 16-bit step.
+//
+//     x must be positive for Log2(); Pow() returns 0 for x <= 0, & its result bottoms out at the
+// smallest normal float instead of going denormal.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline V Log2(const V x)
+{
+    V e = Exponent(x);
+    V m = Mantissa(x);
+
+    typename V::Mask high = m > V(1.41421356f);
+
+    m = Select(high, m * V(0.5f), m);
+    e = Select(high, e + V(1.0f), e);
+
+    V t  = (m - V(1.0f)) / (m + V(1.0f));
+    V t2 = t * t;
+
+    // 2 / (k ln 2) for k = 1, 3, 5, 7.
+    return e + t * (V(2.88539008f) + t2 * (V(0.961796694f) + t2 * (V(0.577078016f) + t2 * V(0.412198583f))));
+}
+
+template <class V> inline V Exp2(const V y)
+{
+    V c = Max(Min(y, V(127.0f)), V(-126.0f));
+    V n = Floor(c);
+    V u = (c - n - V(0.5f)) * V(0.693147181f);
+
+    V p = V(1.0f) + u * (V(1.0f) + u * (V(0.5f) + u * (V(1.0f / 6.0f) + u * (V(1.0f / 24.0f)
+        + u * (V(1.0f / 120.0f) + u * V(1.0f / 720.0f))))));
+
+    return p * V(1.41421356f) * Pow2(n);
+}
+
+template <class V> inline V Pow(const V x, const V y)
+{
+    V r = Exp2(y * Log2(Max(x, V(1.17549435e-38f))));
+
+    return Select(x > V(0.0f), r, V(0.0f));
+}
+
+//     The curves themselves. Negative values, which wide-gamut & HDR math can produce, go through the
+// curve by their magnitude & keep their sign; values over 1 continue the curve.
+
+template <class V> inline V MirrorSign(const V x, const V y)
+{
+    return Select(x < V(0.0f), V(0.0f) - y, y);
+}
+
+template <class V> inline V SRGBToLinear(const V x)
+{
+    V a = Abs(x);
+    V y = Select(a <= V(0.04045f), a * V(1.0f / 12.92f), Pow((a + V(0.055f)) * V(1.0f / 1.055f), V(2.4f)));
+
+    return MirrorSign(x, y);
+}
+
+template <class V> inline V LinearToSRGB(const V x)
+{
+    V a = Abs(x);
+    V y = Select(a <= V(0.0031308f), a * V(12.92f), V(1.055f) * Pow(a, V(1.0f / 2.4f)) - V(0.055f));
+
+    return MirrorSign(x, y);
+}
+
+template <class V> inline V Rec709ToLinear(const V x)
+{
+    V a = Abs(x);
+    V y = Select(a < V(0.081f), a * V(1.0f / 4.5f), Pow((a + V(0.099f)) * V(1.0f / 1.099f), V(1.0f / 0.45f)));
+
+    return MirrorSign(x, y);
+}
+
+template <class V> inline V LinearToRec709(const V x)
+{
+    V a = Abs(x);
+    V y = Select(a < V(0.018f), a * V(4.5f), V(1.099f) * Pow(a, V(0.45f)) - V(0.099f));
+
+    return MirrorSign(x, y);
+}
+
+template <class V> inline V PowSigned(const V x, const V y)
+{
+    return MirrorSign(x, Pow(Abs(x), y));
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Perceptual spaces, from & to linear RGB (sRGB primaries, D65 white). XYZ is scaled so white has
+// Y = 1; CIE Lab has L* 0-100 & a*/b* roughly -128-128, as OpenCV's float Lab does; OKLab has L 0-1.
+//
+//     Cbrt() splits the float into 2^(3q + r) * m, seeds cbrt(m) with a quadratic (0.12% off on
+// [1, 2)) & takes one Halley step, which triples the correct digits for the same single division
+// as a Newton step, with no pow() or log anywhere. Denormals are scaled up by 2^48 first (& the
+// root back down by 2^16), since their exponent field doesn't hold their exponent. Checked against
+// a double cbrt() for every positive float: within 3e-7 relative, the worst cases just above the
+// smallest normal. Negative inputs keep their sign, as OKLab needs for out-of-gamut colors.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline V Cbrt(const V x)
+{
+    typename V::Mask tiny = Abs(x) < V(1.17549435e-38f);
+
+    V a = Max(Select(tiny, Abs(x) * V(281474976710656.0f), Abs(x)), V(1.17549435e-38f));
+    V e = Exponent(a);
+    V m = Mantissa(a);
+    V q = Floor((e + V(0.5f)) * V(1.0f / 3.0f));
+    V r = e - q * V(3.0f);
+
+    V y = V(0.624903025f) + m * (V(0.435570009f) + m * V(-0.0593042584f));
+
+    V y3 = y * y * y;
+
+    y = y * (y3 + m + m) / (y3 + y3 + m);
+    y = y * Select(r == V(1.0f), V(1.25992105f), Select(r == V(2.0f), V(1.58740105f), V(1.0f))) * Pow2(q);
+    y = Select(tiny, y * V(1.0f / 65536.0f), y);
+
+    return Select(x == V(0.0f), V(0.0f), MirrorSign(x, y));
+}
+
+// Row-major 3x3 matrix times (c0, c1, c2), in place.
+template <class V> inline void Transform3(V &c0, V &c1, V &c2, const float *m)
+{
+    V x = c0;
+    V y = c1;
+    V z = c2;
+
+    c0 = V(m[0]) * x + V(m[1]) * y + V(m[2]) * z;
+    c1 = V(m[3]) * x + V(m[4]) * y + V(m[5]) * z;
+    c2 = V(m[6]) * x + V(m[7]) * y + V(m[8]) * z;
+}
+
+static const float e1nRGB2XYZMatrix[9] = { 0.4124564f,  0.3575761f,  0.1804375f,
+                                           0.2126729f,  0.7151522f,  0.0721750f,
+                                           0.0193339f,  0.1191920f,  0.9503041f};
+
+static const float e1nXYZ2RGBMatrix[9] = { 3.2404542f, -1.5371385f, -0.4985314f,
+                                          -0.9692660f,  1.8760108f,  0.0415560f,
+                                           0.0556434f, -0.2040259f,  1.0572252f};
+
+// OKLab (Ottosson, 2020): linear RGB -> LMS, then cube-rooted LMS -> Lab. The inverses are the exact
+// inverses of these two, rather than the published ones, which only round-trip to 5e-5.
+static const float e1nRGB2LMSMatrix[9] = { 0.4122214708f,  0.5363325363f,  0.0514459929f,
+                                           0.2119034982f,  0.6806995451f,  0.1073969566f,
+                                           0.0883024619f,  0.2817188376f,  0.6299787005f};
+
+static const float e1nLMS2OKLabMatrix[9] = {0.2104542553f,  0.7936177850f, -0.0040720468f,
+                                            1.9779984951f, -2.4285922050f,  0.4505937099f,
+                                            0.0259040371f,  0.7827717662f, -0.8086757660f};
+
+static const float e1nOKLab2LMSMatrix[9] = {1.0f,  0.3963377922f,  0.2158037581f,
+                                            1.0f, -0.1055613423f, -0.0638541748f,
+                                            1.0f, -0.0894841821f, -1.2914855379f};
+
+static const float e1nLMS2RGBMatrix[9] = { 4.0767416613f, -3.3077115904f,  0.2309699287f,
+                                          -1.2684380041f,  2.6097574007f, -0.3413193963f,
+                                          -0.0041960865f, -0.7034186145f,  1.7076147009f};
+
+// CIE Lab's f(t) & its inverse, with the linear toe below (6/29)^3.
+template <class V> inline V LabF(const V t)
+{
+    return Select(t > V(0.00885645168f), Cbrt(t), t * V(7.78703704f) + V(4.0f / 29.0f));
+}
+
+template <class V> inline V LabFInv(const V f)
+{
+    return Select(f > V(6.0f / 29.0f), f * f * f, (f - V(4.0f / 29.0f)) * V(0.128418549f));
+}
+
+template <class V> inline void XYZ2Lab(V &c0, V &c1, V &c2)
+{
+    V fx = LabF(c0 * V(1.0f / 0.95047f));
+    V fy = LabF(c1);
+    V fz = LabF(c2 * V(1.0f / 1.08883f));
+
+    c0 = V(116.0f) * fy - V(16.0f);
+    c1 = V(500.0f) * (fx - fy);
+    c2 = V(200.0f) * (fy - fz);
+}
+
+template <class V> inline void Lab2XYZ(V &c0, V &c1, V &c2)
+{
+    V fy = (c0 + V(16.0f)) * V(1.0f / 116.0f);
+    V fx = fy + c1 * V(1.0f / 500.0f);
+    V fz = fy - c2 * V(1.0f / 200.0f);
+
+    c0 = LabFInv(fx) * V(0.95047f);
+    c1 = LabFInv(fy);
+    c2 = LabFInv(fz) * V(1.08883f);
+}
+
+template <class V> inline void RGB2OKLab(V &c0, V &c1, V &c2)
+{
+    Transform3(c0, c1, c2, e1nRGB2LMSMatrix);
+
+    c0 = Cbrt(c0);
+    c1 = Cbrt(c1);
+    c2 = Cbrt(c2);
+
+    Transform3(c0, c1, c2, e1nLMS2OKLabMatrix);
+}
+
+template <class V> inline void OKLab2RGB(V &c0, V &c1, V &c2)
+{
+    Transform3(c0, c1, c2, e1nOKLab2LMSMatrix);
+
+    c0 = c0 * c0 * c0;
+    c1 = c1 * c1 * c1;
+    c2 = c2 * c2 * c2;
+
+    Transform3(c0, c1, c2, e1nLMS2RGBMatrix);
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Analyzes three RGB planes into six output planes (hue, lightness, saturation, min, max, delta).
+// Every output is written, so unwanted ones need scratch space; without Hue the hue plane is left
+// alone & its divisions are skipped.
+//----------------------------------------------------------------------------------------------------
+
+template <bool Hue, class V> inline void AnalyzeStep(const float *c0, const float *c1, const float *c2,
+                                                     float *h, float *l, float *s, float *min, float *max, float *del,
+                                                     const size_t i)
+{
+    V r = V::Load(c0 + i);
+    V g = V::Load(c1 + i);
+    V b = V::Load(c2 + i);
+
+    V hh, ll, ss, lo, hi, dd;
+
+    if (Hue)
+    {
+        AnalyzeHLS(r, g, b, hh, ll, ss, lo, hi, dd);
+        hh.Store(h + i);
+    }
+    else
+    {
+        hi = Max(r, Max(g, b));
+        lo = Min(r, Min(g, b));
+        dd = hi - lo;
+        ll = (hi + lo) * V(0.5f);
+        ss = dd;
+    }
+
+    ll.Store(l + i);
+    ss.Store(s + i);
+    lo.Store(min + i);
+    hi.Store(max + i);
+    dd.Store(del + i);
+}
+
+template <bool Hue, class V> inline void AnalyzePlanes(const float *c0, const float *c1, const float *c2,
+                                                       float *h, float *l, float *s, float *min, float *max, float *del,
+                                                       const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {AnalyzeStep<Hue, V>       (c0, c1, c2, h, l, s, min, max, del, i);}
+    for (; i < count; ++i)           {AnalyzeStep<Hue, e1nF32x1>(c0, c1, c2, h, l, s, min, max, del, i);}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     HLS range keying, straight from RGB. Each of hue, saturation & lightness scores 1 inside its
+// range, falling smoothly (smoothstep) to 0 over softness beyond either end; the key is the product.
+// Hue is measured around the wheel from the range's center, so a range can wrap through red. The
+// limits come pre-digested as e1nKeyKernel, with softness as a reciprocal (huge for a hard edge); a
+// range that takes in every hue skips the hue math altogether (Hue = false).
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline V KeyFalloff(const V outside, const V invSoft)
+{
+    V t = Clamp01(V(1.0f) - outside * invSoft);
+
+    return t * t * (V(3.0f) - V(2.0f) * t);
+}
+
+template <class V> inline V KeyRange(const V x, const V lo, const V hi, const V invSoft)
+{
+    return KeyFalloff(Max(Max(lo - x, x - hi), V(0.0f)), invSoft);
+}
+
+template <bool Hue, class V> inline V KeyHLS(const V r, const V g, const V b, const e1nKeyKernel &k)
+{
+    V hi  = Max(r, Max(g, b));
+    V lo  = Min(r, Min(g, b));
+    V key = KeyRange(hi - lo, V(k.satLow), V(k.satHigh), V(k.invSatSoft)) *
+            KeyRange((hi + lo) * V(0.5f), V(k.valLow), V(k.valHigh), V(k.invValSoft));
+
+    if (Hue)
+    {
+        V h, l, s, mn, mx, del;
+
+        AnalyzeHLS(r, g, b, h, l, s, mn, mx, del);
+
+        // Signed distance from the center, folded into -0.5-0.5 turns, then its size.
+        V d = h - V(k.hueCenter);
+
+        d   = Abs(d - Floor(d + V(0.5f)));
+        key = key * KeyFalloff(Max(d - V(k.hueHalf), V(0.0f)), V(k.invHueSoft));
+    }
+
+    return k.invert ? V(1.0f) - key : key;
+}
+
+template <bool Hue, class V> inline void KeyPlanes(const float *c0, const float *c1, const float *c2, float *key,
+                                                   const size_t count, const e1nKeyKernel &k)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        KeyHLS<Hue>(V::Load(c0 + i), V::Load(c1 + i), V::Load(c2 + i), k).Store(key + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        key[i] = KeyHLS<Hue>(e1nF32x1(c0[i]), e1nF32x1(c1[i]), e1nF32x1(c2[i]), k).v;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Hue on the circle. Averaged as plain numbers, hues go wrong across red: 0.95 & 0.05 come out as
+// 0.5, cyan. Instead each hue becomes a vector at its angle, weighted by its saturation, the vectors
+// are averaged & the angle of the result is read back, so vivid colors decide the hue & grays (whose
+// hue means nothing) barely count. A small floor on the weight lets an area that's gray throughout
+// still come out with the circular mean of its hues. Angles are in turns (0-1) throughout.
+//
+//     SinTurns() folds its argument to within a quarter turn of 0 & takes an 11th-order Taylor
+// series (within 2e-7, float rounding included). Atan2Turns() divides the smaller coordinate by the
+// larger, takes Abramowitz & Stegun's 4.4.49 & unfolds the octant into 0-1 (within 1e-7 of a turn).
+//----------------------------------------------------------------------------------------------------
+
+#define E1N_HUE_WEIGHT_FLOOR 1.0e-4f
+
+template <class V> inline V SinTurns(const V t)
+{
+    V x = t - Floor(t + V(0.5f));
+
+    x = Select(x > V(0.25f), V(0.5f) - x, Select(x < V(-0.25f), V(-0.5f) - x, x));
+
+    V a  = x * V(6.28318531f);
+    V a2 = a * a;
+
+    return a * (V(1.0f) + a2 * (V(-1.0f / 6.0f) + a2 * (V(1.0f / 120.0f) + a2 * (V(-1.0f / 5040.0f)
+         + a2 * (V(1.0f / 362880.0f) + a2 * V(-1.0f / 39916800.0f))))));
+}
+
+template <class V> inline V CosTurns(const V t)
+{
+    return SinTurns(t + V(0.25f));
+}
+
+template <class V> inline V Atan2Turns(const V y, const V x)
+{
+    V ax = Abs(x);
+    V ay = Abs(y);
+    V hi = Max(ax, ay);
+    V z  = Min(ax, ay) / Select(hi == V(0.0f), V(1.0f), hi);
+    V z2 = z * z;
+
+    V r = z * (V(0.9999993329f) + z2 * (V(-0.3332985605f) + z2 * (V(0.1994653599f) + z2 * (V(-0.1390853351f)
+        + z2 * (V(0.0964200441f) + z2 * (V(-0.0559098861f) + z2 * (V(0.0218612288f) + z2 * V(-0.0040540580f))))))));
+
+    r = r * V(0.159154943f);
+    r = Select(ay > ax, V(0.25f) - r, r);
+    r = Select(x < V(0.0f), V(0.5f) - r, r);
+    r = Select(y < V(0.0f), V(0.0f) - r, r);
+    r = Select(r < V(0.0f), r + V(1.0f), r);
+
+    return Select(r >= V(1.0f), r - V(1.0f), r);
+}
+
+// (h, s) to a weighted vector (x, y); x is written over h.
+template <class V> inline void HueToVectorStep(float *h, float *y, const float *s, const size_t i)
+{
+    V t = V::Load(h + i);
+    V w = Max(V::Load(s + i), V(0.0f)) + V(E1N_HUE_WEIGHT_FLOOR);
+
+    (w * CosTurns(t)).Store(h + i);
+    (w * SinTurns(t)).Store(y + i);
+}
+
+template <class V> inline void HueToVector(float *h, float *y, const float *s, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {HueToVectorStep<V>(h, y, s, i);}
+    for (; i < count; ++i)           {HueToVectorStep<e1nF32x1>(h, y, s, i);}
+}
+
+template <class V> inline void VectorToHue(const float *x, const float *y, float *h, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {Atan2Turns(V::Load(y + i), V::Load(x + i)).Store(h + i);}
+    for (; i < count; ++i)           {h[i] = Atan2Turns(e1nF32x1(y[i]), e1nF32x1(x[i])).v;}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     2:1 reductions of one plane, for pyramids: a 2 x 2 box, or the 5 x 5 binomial (1 4 6 4 1) / 16
+// that cv::pyrDown() uses, each split into a pass down the rows & one across. The row passes combine
+// whole rows; the column passes make out[j] from in[2j] & in[2j + 1], or from in[2j - 2] to
+// in[2j + 2], with the caller padding the row so those all exist (& leaving room for a full register
+// past the end).
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void ReduceRows2Step(const float *a, const float *b, float *out, const size_t i)
+{
+    ((V::Load(a + i) + V::Load(b + i)) * V(0.5f)).Store(out + i);
+}
+
+template <class V> inline void ReduceRows5Step(const float *const *r, float *out, const size_t i)
+{
+    V outer = V::Load(r[0] + i) + V::Load(r[4] + i);
+    V inner = V::Load(r[1] + i) + V::Load(r[3] + i);
+
+    ((outer + V(4.0f) * inner + V(6.0f) * V::Load(r[2] + i)) * V(1.0f / 16.0f)).Store(out + i);
+}
+
+template <class V> inline void ReduceCols2Step(const float *in, float *out, const size_t j)
+{
+    V even, odd;
+
+    Deinterleave2(in + 2 * j, even, odd);
+
+    ((even + odd) * V(0.5f)).Store(out + j);
+}
+
+// in points at in[-2].
+template <class V> inline void ReduceCols5Step(const float *in, float *out, const size_t j)
+{
+    V e0, o0, e1, o1, e2, o2;
+
+    Deinterleave2(in + 2 * j,     e0, o0);
+    Deinterleave2(in + 2 * j + 2, e1, o1);
+    Deinterleave2(in + 2 * j + 4, e2, o2);
+
+    ((e0 + e2 + V(4.0f) * (o0 + o1) + V(6.0f) * e1) * V(1.0f / 16.0f)).Store(out + j);
+}
+
+template <class V> inline void ReduceRows2(const float *a, const float *b, float *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {ReduceRows2Step<V>(a, b, out, i);}
+    for (; i < count; ++i)           {ReduceRows2Step<e1nF32x1>(a, b, out, i);}
+}
+
+template <class V> inline void ReduceRows5(const float *const *r, float *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {ReduceRows5Step<V>(r, out, i);}
+    for (; i < count; ++i)           {ReduceRows5Step<e1nF32x1>(r, out, i);}
+}
+
+template <class V> inline void ReduceCols2(const float *in, float *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t j     = 0;
+
+    for (; j < whole; j += V::Width) {ReduceCols2Step<V>(in, out, j);}
+    for (; j < count; ++j)           {ReduceCols2Step<e1nF32x1>(in, out, j);}
+}
+
+template <class V> inline void ReduceCols5(const float *in, float *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t j     = 0;
+
+    for (; j < whole; j += V::Width) {ReduceCols5Step<V>(in, out, j);}
+    for (; j < count; ++j)           {ReduceCols5Step<e1nF32x1>(in, out, j);}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     3D LUT lookup with tetrahedral interpolation. The lattice is stored as three planes of size^3
+// floats, red varying fastest, so a lattice point's offset (r + g * size + b * size^2) is a whole
+// number a float holds exactly & the same offset indexes every plane. Inputs are mapped onto the
+// lattice by scale & offset, clamped (NaN to the low end), & the cell's corner found with the top
+// corner pulled in by one so the far faces interpolate too.
+//
+//     The cell is split into six tetrahedra along its gray diagonal; which one a pixel falls in is
+// given by the order of its fractions. Walking from the low corner along the axis with the largest
+// fraction, then the middle one, then the last reaches the high corner through the two other
+// vertices, weighted by the sorted fractions, so each channel costs four lookups whatever the cell.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void LUT3D(V &c0, V &c1, V &c2, const e1nLUT3DKernel &k)
+{
+    typedef typename V::Mask M;
+
+    V last = V(k.last);
+    V x[3] = {c0, c1, c2};
+    V f[3];
+    V base = V(0.0f);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        V t = Min(last, Max(V(0.0f), x[i] * V(k.scale[i]) + V(k.offset[i])));
+        V n = Min(last - V(1.0f), Floor(t));
+
+        f[i] = t - n;
+        base = base + n * V(k.stride[i]);
+    }
+
+    // Sort the fractions, & find which axes they belong to (ties go to r first, b last).
+    V hi  = Max(f[0], Max(f[1], f[2]));
+    V lo  = Min(f[0], Min(f[1], f[2]));
+    V mid = Max(Min(f[0], f[1]), Min(Max(f[0], f[1]), f[2]));
+
+    M rHi = (f[0] >= f[1]) & (f[0] >= f[2]);
+    M gHi = AndNot(f[1] >= f[2], rHi);
+    M bLo = (f[2] <= f[0]) & (f[2] <= f[1]);
+    M gLo = AndNot(f[1] <= f[0], bLo);
+
+    V sr = V(k.stride[0]);
+    V sg = V(k.stride[1]);
+    V sb = V(k.stride[2]);
+    V v1 = base + Select(rHi, sr, Select(gHi, sg, sb));
+    V v3 = base + sr + sg + sb;
+    V v2 = v3 - Select(bLo, sb, Select(gLo, sg, sr));
+
+    V *c[3] = {&c0, &c1, &c2};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        V p0 = Gather(k.plane[i], base);
+        V p1 = Gather(k.plane[i], v1);
+        V p2 = Gather(k.plane[i], v2);
+        V p3 = Gather(k.plane[i], v3);
+
+        *c[i] = p0 + hi * (p1 - p0) + mid * (p2 - p1) + lo * (p3 - p2);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// Operation functors, so one driver loop can serve every three-plane kernel.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nOpRGB2HLS
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {RGB2HLS(c0, c1, c2);}
+};
+
+struct e1nOpHLS2RGB
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {HLS2RGB(c0, c1, c2);}
+};
+
+template <int Op> struct e1nOpAdjust
+{
+    float x;
+
+    e1nOpAdjust(const float amount) : x(amount) {}
+
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {AdjustHLS<Op>(c0, c1, c2, V(x));}
+};
+
+struct e1nOpLUT3D
+{
+    const e1nLUT3DKernel &k;
+
+    e1nOpLUT3D(const e1nLUT3DKernel &kernel) : k(kernel) {}
+
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {LUT3D(c0, c1, c2, k);}
+};
+
+struct e1nOpRGB2XYZ
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {Transform3(c0, c1, c2, e1nRGB2XYZMatrix);}
+};
+
+struct e1nOpXYZ2RGB
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {Transform3(c0, c1, c2, e1nXYZ2RGBMatrix);}
+};
+
+struct e1nOpRGB2Lab
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {Transform3(c0, c1, c2, e1nRGB2XYZMatrix); XYZ2Lab(c0, c1, c2);}
+};
+
+struct e1nOpLab2RGB
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {Lab2XYZ(c0, c1, c2); Transform3(c0, c1, c2, e1nXYZ2RGBMatrix);}
+};
+
+struct e1nOpRGB2OKLab
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {RGB2OKLab(c0, c1, c2);}
+};
+
+struct e1nOpOKLab2RGB
+{
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const {OKLab2RGB(c0, c1, c2);}
+};
+
+//     Transfer curve functors, for one plane (operator ()(V &)) or three (operator ()(V &, V &, V &)).
+// The exponent is only used by the power curve.
+
+enum e1nTransferKernel
+{
+    E1N_CURVE_SRGB_TO_LINEAR,
+    E1N_CURVE_LINEAR_TO_SRGB,
+    E1N_CURVE_REC709_TO_LINEAR,
+    E1N_CURVE_LINEAR_TO_REC709,
+    E1N_CURVE_POW
+};
+
+template <int Curve> struct e1nOpTransfer
+{
+    float y;
+
+    e1nOpTransfer(const float exponent = 1.0f) : y(exponent) {}
+
+    template <class V> void operator ()(V &x) const
+    {
+        switch (Curve)
+        {
+            case E1N_CURVE_SRGB_TO_LINEAR:   x = SRGBToLinear(x);     break;
+            case E1N_CURVE_LINEAR_TO_SRGB:   x = LinearToSRGB(x);     break;
+            case E1N_CURVE_REC709_TO_LINEAR: x = Rec709ToLinear(x);   break;
+            case E1N_CURVE_LINEAR_TO_REC709: x = LinearToRec709(x);   break;
+            case E1N_CURVE_POW:              x = PowSigned(x, V(y));  break;
+        }
+    }
+
+    template <class V> void operator ()(V &c0, V &c1, V &c2) const
+    {
+        (*this)(c0);
+        (*this)(c1);
+        (*this)(c2);
+    }
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Runs an operation in place over three float planes, V::Width pixels at a time, finishing any
+// leftover pixels with the scalar wrapper.
+//----------------------------------------------------------------------------------------------------
+
+template <class V, class Op> inline void ForEachPixel3(float *c0, float *c1, float *c2, const size_t count, const Op &op)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        V a = V::Load(c0 + i);
+        V b = V::Load(c1 + i);
+        V c = V::Load(c2 + i);
+
+        op(a, b, c);
+
+        a.Store(c0 + i);
+        b.Store(c1 + i);
+        c.Store(c2 + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        e1nF32x1 a = c0[i];
+        e1nF32x1 b = c1[i];
+        e1nF32x1 c = c2[i];
+
+        op(a, b, c);
+
+        c0[i] = a.v;
+        c1[i] = b.v;
+        c2[i] = c.v;
+    }
+}
+
+// The same over a single plane, for operations that treat every channel alike.
+template <class V, class Op> inline void ForEachValue(float *x, const size_t count, const Op &op)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        V a = V::Load(x + i);
+
+        op(a);
+
+        a.Store(x + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        e1nF32x1 a = x[i];
+
+        op(a);
+
+        x[i] = a.v;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+//     e1nPalette's assignment step: the nearest centroid (as a float index) to each HLS pixel of a
+// run, & its distance, as described in e1nPalette.h. Ties go to the lower index.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline V PaletteDistance(const V h, const V l, const V s,
+                                            const float ch, const float cl, const float cs, const float hueWeight)
+{
+    V dh = Abs(h - V(ch));
+    dh   = Min(dh, V(1.0f) - dh);
+
+    V dw = Min(s, V(cs)) * V(hueWeight) * dh;
+    V dl = l - V(cl);
+    V ds = s - V(cs);
+
+    return dw * dw + dl * dl + ds * ds;
+}
+
+template <class V> inline void NearestCentroidStep(const float *h, const float *l, const float *s, const e1nPaletteKernel &k,
+                                                   float *index, float *dist, const size_t i)
+{
+    V ph = V::Load(h + i);
+    V pl = V::Load(l + i);
+    V ps = V::Load(s + i);
+
+    V best  = V(HUGE_VALF);
+    V which = V(0.0f);
+
+    for (int c = 0; c < k.count; ++c)
+    {
+        V d = PaletteDistance(ph, pl, ps, k.h[c], k.l[c], k.s[c], k.hueWeight);
+
+        typename V::Mask closer = d < best;
+
+        best  = Select(closer, d, best);
+        which = Select(closer, V((float) c), which);
+    }
+
+    which.Store(index + i);
+    best.Store(dist + i);
+}
+
+template <class V> inline void NearestCentroid(const float *h, const float *l, const float *s, const size_t count,
+                                               const e1nPaletteKernel &k, float *index, float *dist)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width) {NearestCentroidStep<V>(h, l, s, k, index, dist, i);}
+    for (; i < count; ++i)           {NearestCentroidStep<e1nF32x1>(h, l, s, k, index, dist, i);}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     e1nColorStats' moments: adds a run's sum & sum of squares to the running totals & widens the
+// min & max to cover it. Each lane keeps its own float partial sums until the end of the run, so the
+// totals differ in their last bits from level to level.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void Moments(const float *x, const size_t count, double &sum, double &sumSq, float &lo, float &hi)
+{
+    V      s     = V(0.0f);
+    V      s2    = V(0.0f);
+    V      mn    = V(HUGE_VALF);
+    V      mx    = V(-HUGE_VALF);
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        V v = V::Load(x + i);
+
+        s  = s + v;
+        s2 = s2 + v * v;
+        mn = Min(mn, v);
+        mx = Max(mx, v);
+    }
+
+    alignas(64) float lanes[4][V::Width];
+
+    s.Store(lanes[0]);
+    s2.Store(lanes[1]);
+    mn.Store(lanes[2]);
+    mx.Store(lanes[3]);
+
+    for (int k = 0; k < V::Width; ++k)
+    {
+        sum   += lanes[0][k];
+        sumSq += lanes[1][k];
+        lo     = lanes[2][k] < lo ? lanes[2][k] : lo;
+        hi     = lanes[3][k] > hi ? lanes[3][k] : hi;
+    }
+
+    for (; i < count; ++i)
+    {
+        sum   += x[i];
+        sumSq += (double) x[i] * x[i];
+        lo     = x[i] < lo ? x[i] : lo;
+        hi     = x[i] > hi ? x[i] : hi;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Byte encoding, as e1nFloatToByte(): clamped to 0-1 (NaN to 0), scaled to 0-255 & rounded half up.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void QuantizeBytes(const float *x, unsigned char *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        StoreBytes(Min(V(1.0f), Max(V(0.0f), V::Load(x + i))) * V(255.0f) + V(0.5f), out + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        StoreBytes(Min(e1nF32x1(1.0f), Max(e1nF32x1(0.0f), e1nF32x1(x[i]))) * e1nF32x1(255.0f) + e1nF32x1(0.5f), out + i);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+//     The same with a per-value offset in place of the 0.5 that rounds, for ordered dithering (offsets
+// in 0-1 averaging 0.5 trade banding for fine noise), to bytes or to 16-bit words. An offset of 0.5
+// everywhere gives exactly QuantizeBytes(). The result is held to the top code, since an offset near
+// 1 on a full-scale value would otherwise round up past it.
+//----------------------------------------------------------------------------------------------------
+
+template <class V> inline void QuantizeOffsetBytes(const float *x, const float *offset, unsigned char *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        StoreBytes(Min(V(255.0f), Min(V(1.0f), Max(V(0.0f), V::Load(x + i))) * V(255.0f) + V::Load(offset + i)), out + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        StoreBytes(Min(e1nF32x1(255.0f), Min(e1nF32x1(1.0f), Max(e1nF32x1(0.0f), e1nF32x1(x[i]))) * e1nF32x1(255.0f) +
+                   e1nF32x1(offset[i])), out + i);
+    }
+}
+
+template <class V> inline void QuantizeOffsetWords(const float *x, const float *offset, unsigned short *out, const size_t count)
+{
+    size_t whole = count - count % V::Width;
+    size_t i     = 0;
+
+    for (; i < whole; i += V::Width)
+    {
+        StoreWords(Min(V(65535.0f), Min(V(1.0f), Max(V(0.0f), V::Load(x + i))) * V(65535.0f) + V::Load(offset + i)), out + i);
+    }
+
+    for (; i < count; ++i)
+    {
+        StoreWords(Min(e1nF32x1(65535.0f), Min(e1nF32x1(1.0f), Max(e1nF32x1(0.0f), e1nF32x1(x[i]))) * e1nF32x1(65535.0f) +
+                   e1nF32x1(offset[i])), out + i);
+    }
+}
+
+}   // inline namespace E1N_SIMD_ISA
+}   // namespace e1nSimd
+
+#endif     // E1NCOLORKERNELS_H
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nColorLUT.cpp - Lookup tables for e1nColor's 8-bit input & output paths.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorLUT.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <mutex>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+// Entries in a full 24-bit table.
+#define E1N_TABLE_SIZE (1 << 24)
+
+//====================================================================================================
+// Table construction:
+//====================================================================================================
+//     Both tables are built the same way: each run of 256 entries shares its top two bytes & walks
+// the bottom one, which is exactly one batch chunk, so it goes through the same kernel & the same
+// byte encoding as the batch conversions do.
+//----------------------------------------------------------------------------------------------------
+
+static void BuildTable(vector<uint32_t> &table, const e1nConvertKernel kernel)
+{
+    table.resize(E1N_TABLE_SIZE);
+
+    const float               *decode  = e1nGetByteDecodeTable();
+    e1nKernelTable::ConvertFn  convert = e1nGetKernels().convert[kernel];
+
+    e1nTileScheduler::Default().ParallelFor(E1N_TABLE_SIZE / 256, [&](const int run, const int)
+    {
+        alignas(64) float c0[256];
+        alignas(64) float c1[256];
+        alignas(64) float c2[256];
+
+        for (int i = 0; i < 256; ++i)
+        {
+            c0[i] = decode[run >> 8];
+            c1[i] = decode[run & 255];
+            c2[i] = decode[i];
+        }
+
+        convert(c0, c1, c2, 256);
+
+        uint32_t *out = &table[(size_t) run << 8];
+
+        for (int i = 0; i < 256; ++i)
+        {
+            out[i] = (uint32_t) e1nFloatToByte(c0[i])
+                   | (uint32_t) e1nFloatToByte(c1[i]) << 8
+                   | (uint32_t) e1nFloatToByte(c2[i]) << 16;
+        }
+    });
+}
+
+const uint32_t *e1nGetRGB2HLSTable()
+{
+    static vector<uint32_t> table;
+    static once_flag        built;
+
+    call_once(built, [] {BuildTable(table, E1N_CONVERT_RGB2HLS);});
+
+    return table.data();
+}
+
+const uint32_t *e1nGetHLS2RGBTable()
+{
+    static vector<uint32_t> table;
+    static once_flag        built;
+
+    call_once(built, [] {BuildTable(table, E1N_CONVERT_HLS2RGB);});
+
+    return table.data();
+}
+
+//====================================================================================================
+// Table-driven conversions:
+//====================================================================================================
+
+// Replaces every pixel p with table[p], optionally running the curves in between.
+static void LookupInPlace(Mat &image, const uint32_t *first, const unsigned char *map0,
+                          const unsigned char *map1, const unsigned char *map2, const uint32_t *second)
+{
+    CV_Assert(image.type() == CV_8UC3);
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        unsigned char *p = image.ptr<unsigned char>(row);
+
+        for (int col = 0; col < image.cols; ++col, p += 3)
+        {
+            uint32_t v = first[(uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | p[2]];
+
+            if (second)
+            {
+                uint32_t c0 = v & 255;
+                uint32_t c1 = (v >> 8) & 255;
+                uint32_t c2 = (v >> 16) & 255;
+
+                if (map0) {c0 = map0[c0];}
+                if (map1) {c1 = map1[c1];}
+                if (map2) {c2 = map2[c2];}
+
+                v = second[c0 << 16 | c1 << 8 | c2];
+            }
+
+            p[0] = (unsigned char) v;
+            p[1] = (unsigned char) (v >> 8);
+            p[2] = (unsigned char) (v >> 16);
+        }
+    }
+}
+
+void e1nConvertRGB2HLSTable(Mat &image)
+{
+    E1N_TRACE_OP("e1nConvertRGB2HLSTable", image.total(), image.total() * 6);
+
+    LookupInPlace(image, e1nGetRGB2HLSTable(), nullptr, nullptr, nullptr, nullptr);
+}
+
+void e1nConvertHLS2RGBTable(Mat &image)
+{
+    E1N_TRACE_OP("e1nConvertHLS2RGBTable", image.total(), image.total() * 6);
+
+    LookupInPlace(image, e1nGetHLS2RGBTable(), nullptr, nullptr, nullptr, nullptr);
+}
+
+void e1nAdjustHLS8(Mat &image, const unsigned char *hueMap, const unsigned char *lightMap, const unsigned char *satMap)
+{
+    E1N_TRACE_OP("e1nAdjustHLS8", image.total(), image.total() * 6);
+
+    LookupInPlace(image, e1nGetRGB2HLSTable(), hueMap, lightMap, satMap, e1nGetHLS2RGBTable());
+}
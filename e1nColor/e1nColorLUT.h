@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorLUT.h - Lookup tables for e1nColor's 8-bit input & output paths.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORLUT_H
+#define E1NCOLORLUT_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdint>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+// Byte <-> float conversion:
+//====================================================================================================
+//     Decoding goes through a 256-entry table holding exactly the value byte / 255.0f that the byte
+// constructors used to compute. Encoding clamps to 0-1 & rounds to nearest in single precision,
+// replacing the old double-precision round(x * 255.0) (which let out-of-range values wrap around).
+// The table is built on first use by whichever thread gets there first.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nByteDecodeTable
+{
+    float values[256];
+
+    e1nByteDecodeTable()
+    {
+        for (int i = 0; i < 256; ++i) {values[i] = i / 255.0f;}
+    }
+};
+
+inline const float *e1nGetByteDecodeTable()
+{
+    static const e1nByteDecodeTable table;
+
+    return table.values;
+}
+
+inline float e1nByteToFloat(const unsigned char someByte)
+{
+    return e1nGetByteDecodeTable()[someByte];
+}
+
+inline unsigned char e1nFloatToByte(const float someFloat)
+{
+    // Written so that NaN falls through to zero.
+    float clamped = someFloat > 0.0f ? (someFloat < 1.0f ? someFloat : 1.0f) : 0.0f;
+
+    return (unsigned char) (clamped * 255.0f + 0.5f);
+}
+
+//====================================================================================================
+//     Quantized HLS tables. For 8-bit work the whole RGB <-> HLS conversion can be precomputed: one
+// table maps every RGB888 value to its byte-encoded HLS, the other maps every HLS888 value back.
+// Entries are packed as c0 | c1 << 8 | c2 << 16 & are bit-identical to what e1nConvertRGB2HLS() /
+// e1nConvertHLS2RGB() produce for a CV_8UC3 image.
+//
+//     Each table is 64MB & takes a few tens of milliseconds to build across all cores, so they are
+// only built (once, lazily & thread-safely) when first asked for. They pay off for large images; on
+// small ones the SIMD conversions are cheaper than the cache misses.
+//====================================================================================================
+
+const uint32_t *e1nGetRGB2HLSTable();
+const uint32_t *e1nGetHLS2RGBTable();
+
+//----------------------------------------------------------------------------------------------------
+// Table-driven conversions of CV_8UC3 images, in place.
+//----------------------------------------------------------------------------------------------------
+
+void e1nConvertRGB2HLSTable(Mat &image);
+void e1nConvertHLS2RGBTable(Mat &image);
+
+//----------------------------------------------------------------------------------------------------
+//     A complete 8-bit RGB -> HLS -> adjust -> RGB round trip of a CV_8UC3 image, in place, as three
+// table lookups per pixel. The adjustment is given as one 256-entry curve per HLS component (byte in,
+// byte out); e.g. hueMap[h] = (h + 16) & 255 rotates every hue by 16/255ths of the wheel. A null map
+// leaves that component unchanged.
+//----------------------------------------------------------------------------------------------------
+
+void e1nAdjustHLS8(Mat &image, const unsigned char *hueMap, const unsigned char *lightMap, const unsigned char *satMap);
+
+#endif     // E1NCOLORLUT_H
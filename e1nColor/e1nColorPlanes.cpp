@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nColorPlanes.cpp - Implementation file for the e1nColorPlanes planar image buffer.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+// Floats per alignment unit.
+#define E1N_PLANE_ALIGN_FLOATS (E1N_PLANE_ALIGN / sizeof(float))
+
+//====================================================================================================
+// Constructors:
+//====================================================================================================
+
+// Default
+e1nColorPlanes::e1nColorPlanes()
+{
+    planes[0] = planes[1] = planes[2] = planes[3] = nullptr;
+    rows   = 0;
+    cols   = 0;
+    stride = 0;
+}
+
+// Uninitialized planes of the given size.
+e1nColorPlanes::e1nColorPlanes(const int numRows, const int numCols, const bool withAlpha)
+{
+    planes[0] = planes[1] = planes[2] = planes[3] = nullptr;
+    rows   = 0;
+    cols   = 0;
+    stride = 0;
+
+    Create(numRows, numCols, withAlpha);
+}
+
+// Unpacked from an OpenCV Mat.
+e1nColorPlanes::e1nColorPlanes(const Mat &image)
+{
+    planes[0] = planes[1] = planes[2] = planes[3] = nullptr;
+    rows   = 0;
+    cols   = 0;
+    stride = 0;
+
+    FromMat(image);
+}
+
+//====================================================================================================
+// Allocation & views:
+//====================================================================================================
+
+void e1nColorPlanes::Create(const int numRows, const int numCols, const bool withAlpha)
+{
+    CV_Assert(numRows >= 0 && numCols >= 0);
+
+    // Keep the existing planes if they already fit.
+    if (rows == numRows && cols == numCols && HasAlpha() == withAlpha && block) {return;}
+
+    int    numPlanes  = withAlpha ? 4 : 3;
+    size_t rowStride  = (numCols + E1N_PLANE_ALIGN_FLOATS - 1) / E1N_PLANE_ALIGN_FLOATS * E1N_PLANE_ALIGN_FLOATS;
+    size_t planeSize  = rowStride * numRows;
+
+    // One block for all of the planes, padded so the first one can be moved up to the alignment.
+    block.reset(new float[planeSize * numPlanes + E1N_PLANE_ALIGN_FLOATS], default_delete<float[]>());
+
+    uintptr_t address = (uintptr_t) block.get();
+    float    *aligned = (float *) ((address + E1N_PLANE_ALIGN - 1) & ~(uintptr_t) (E1N_PLANE_ALIGN - 1));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        planes[i] = i < numPlanes ? aligned + planeSize * i : nullptr;
+    }
+
+    rows   = numRows;
+    cols   = numCols;
+    stride = (int) rowStride;
+}
+
+//----------------------------------------------------------------------------------------------------
+//     A view of part of the buffer. Rows of the view are only 64-byte aligned when roi.x is a
+// multiple of 16; the batch kernels don't depend on it, but it's worth knowing when tiling.
+//----------------------------------------------------------------------------------------------------
+
+e1nColorPlanes e1nColorPlanes::Region(const Rect &roi) const
+{
+    CV_Assert(roi.x >= 0 && roi.y >= 0 && roi.x + roi.width <= cols && roi.y + roi.height <= rows);
+
+    e1nColorPlanes view(*this);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (planes[i]) {view.planes[i] = planes[i] + (size_t) roi.y * stride + roi.x;}
+    }
+
+    view.rows = roi.height;
+    view.cols = roi.width;
+
+    return view;
+}
+
+//====================================================================================================
+// Interoperability with OpenCV & e1nColor:
+//====================================================================================================
+
+void e1nColorPlanes::FromMat(const Mat &image)
+{
+    CV_Assert(image.type() == CV_8UC3 || image.type() == CV_8UC4 || image.type() == CV_32FC3 || image.type() == CV_32FC4);
+
+    Create(image.rows, image.cols, image.channels() == 4);
+
+    for (int row = 0; row < rows; ++row)
+    {
+        e1nUnpackRow(image, row, 0, cols, Row(0, row), Row(1, row), Row(2, row), HasAlpha() ? Row(3, row) : nullptr);
+    }
+}
+
+void e1nColorPlanes::ToMat(Mat &image, const int type) const
+{
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_32FC3 || type == CV_32FC4);
+
+    image.create(rows, cols, type);
+
+    // e1nPackRow() leaves alpha alone without a plane for it, so planes without alpha going out to a
+    // 4-channel Mat are given an opaque one, as e1nUnpackRow() does the other way.
+    vector<float> opaque(!HasAlpha() && CV_MAT_CN(type) == 4 ? cols : 0, 1.0f);
+
+    for (int row = 0; row < rows; ++row)
+    {
+        e1nPackRow(image, row, 0, cols, Row(0, row), Row(1, row), Row(2, row), HasAlpha() ? Row(3, row) : opaque.empty() ? nullptr : opaque.data());
+    }
+}
+
+e1nColor e1nColorPlanes::GetColor(const int row, const int col) const
+{
+    return e1nColor(Row(0, row)[col], Row(1, row)[col], Row(2, row)[col], HasAlpha() ? Row(3, row)[col] : 1.0f);
+}
+
+void e1nColorPlanes::SetColor(const int row, const int col, const e1nColor &someColor)
+{
+    Row(0, row)[col] = someColor.GetRedFloat();
+    Row(1, row)[col] = someColor.GetGreenFloat();
+    Row(2, row)[col] = someColor.GetBlueFloat();
+
+    if (HasAlpha()) {Row(3, row)[col] = someColor.GetAlphaFloat();}
+}
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorPlanes.h - Interface definition file for the e1nColorPlanes planar image buffer.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORPLANES_H
+#define E1NCOLORPLANES_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <memory>
+
+using namespace std;
+using namespace cv;
+
+// Plane alignment in bytes. Every row of every plane starts on this boundary.
+#define E1N_PLANE_ALIGN 64
+
+//====================================================================================================
+//     e1nColorPlanes - A structure-of-arrays image. Where an array of e1nColor interleaves r, g, b &
+// a, this keeps each channel in its own 64-byte aligned float plane, so an operation that only
+// touches one channel (a hue shift, an alpha fade) only streams that plane through memory.
+//
+//     Like e1nColor itself the planes don't care what they hold: after e1nConvertRGB2HLS() planes
+// 0, 1 & 2 are hue, lightness & saturation instead of red, green & blue. The alpha plane is optional.
+//
+//     Copies & Region() views share the underlying memory, the same way cv::Mat headers do.
+//====================================================================================================
+
+class e1nColorPlanes
+{
+private:
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    shared_ptr<float> block;            // The allocation backing all of the planes.
+    float *planes[4];                   // First pixel of each plane; planes[3] is null without alpha.
+    int    rows;                        // Height in pixels.
+    int    cols;                        // Width in pixels.
+    int    stride;                      // Distance between rows, in floats. A multiple of the alignment.
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    // Default constructor. An empty buffer.
+    e1nColorPlanes();
+
+    // Allocates uninitialized planes.
+    e1nColorPlanes(const int numRows, const int numCols, const bool withAlpha = true);
+
+    // Unpacks a CV_8UC3, CV_8UC4, CV_32FC3 or CV_32FC4 Mat.
+    explicit e1nColorPlanes(const Mat &image);
+
+    //----------------------------------------------------------------------------------------------------
+    // Allocation & views:
+    //----------------------------------------------------------------------------------------------------
+
+    void Create(const int numRows, const int numCols, const bool withAlpha = true);
+
+    e1nColorPlanes Region(const Rect &roi) const;                       // Shares memory, like Mat(roi).
+
+    //----------------------------------------------------------------------------------------------------
+    // Geometry & raw plane access:
+    //----------------------------------------------------------------------------------------------------
+
+    int  Rows()     const;
+    int  Cols()     const;
+    int  Stride()   const;
+    bool HasAlpha() const;
+    bool Empty()    const;
+
+    float       *Row(const int plane, const int row);
+    const float *Row(const int plane, const int row) const;
+
+    //----------------------------------------------------------------------------------------------------
+    // Interoperability with OpenCV & e1nColor:
+    //----------------------------------------------------------------------------------------------------
+
+    void FromMat(const Mat &image);                                     // Reallocates to fit the Mat.
+    void ToMat(Mat &image, const int type) const;                       // CV_8UC3/4 or CV_32FC3/4.
+
+    e1nColor GetColor(const int row, const int col) const;
+    void     SetColor(const int row, const int col, const e1nColor &someColor);
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline int  e1nColorPlanes::Rows()     const {return rows;}
+inline int  e1nColorPlanes::Cols()     const {return cols;}
+inline int  e1nColorPlanes::Stride()   const {return stride;}
+inline bool e1nColorPlanes::HasAlpha() const {return planes[3] != nullptr;}
+inline bool e1nColorPlanes::Empty()    const {return rows == 0 || cols == 0;}
+
+inline float       *e1nColorPlanes::Row(const int plane, const int row)       {return planes[plane] + (size_t) row * stride;}
+inline const float *e1nColorPlanes::Row(const int plane, const int row) const {return planes[plane] + (size_t) row * stride;}
+
+#endif     // E1NCOLORPLANES_H
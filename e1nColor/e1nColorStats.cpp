@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nColorStats.cpp - Implementation file for e1nColor's HLS histograms & image statistics.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorStats.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+// Resolution of the cosine & sine tables behind the circular hue sums. 4096 steps round the wheel put
+// the circular mean within 0.0002 of exact.
+#define E1N_HUE_TABLE_SIZE 4096
+
+//====================================================================================================
+// Accumulation:
+//====================================================================================================
+
+// One thread's private running totals. Components are indexed hue, lightness, saturation.
+struct e1nStatsAccumulator
+{
+    vector<uint64_t> hist[3];
+    uint64_t         pixels;
+    uint64_t         grays;
+    double           sum[3];
+    double           sumSq[3];
+    float            lo[3];
+    float            hi[3];
+    double           cosSum;
+    double           sinSum;
+
+    void Reset(const e1nStatsOptions &options)
+    {
+        hist[0].assign(options.hueBins, 0);
+        hist[1].assign(options.valBins, 0);
+        hist[2].assign(options.satBins, 0);
+
+        pixels = 0;
+        grays  = 0;
+        cosSum = 0.0;
+        sinSum = 0.0;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            sum[k]   = 0.0;
+            sumSq[k] = 0.0;
+            lo[k]    = HUGE_VALF;
+            hi[k]    = -HUGE_VALF;
+        }
+    }
+
+    void Merge(const e1nStatsAccumulator &other)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            for (size_t i = 0; i < hist[k].size(); ++i) {hist[k][i] += other.hist[k][i];}
+
+            sum[k]   += other.sum[k];
+            sumSq[k] += other.sumSq[k];
+            lo[k]     = min(lo[k], other.lo[k]);
+            hi[k]     = max(hi[k], other.hi[k]);
+        }
+
+        pixels += other.pixels;
+        grays  += other.grays;
+        cosSum += other.cosSum;
+        sinSum += other.sinSum;
+    }
+};
+
+// Cosines & sines of the hue wheel, interleaved.
+static const float *GetHueTable()
+{
+    struct Table
+    {
+        float values[E1N_HUE_TABLE_SIZE * 2];
+
+        Table()
+        {
+            for (int i = 0; i < E1N_HUE_TABLE_SIZE; ++i)
+            {
+                double angle = 2.0 * PI * i / E1N_HUE_TABLE_SIZE;
+
+                values[i * 2]     = (float) cos(angle);
+                values[i * 2 + 1] = (float) sin(angle);
+            }
+        }
+    };
+
+    static const Table table;
+
+    return table.values;
+}
+
+static inline int BinOf(const float x, const int bins)
+{
+    int bin = (int) (x * bins);
+
+    return bin < 0 ? 0 : (bin >= bins ? bins - 1 : bin);
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Adds a run of HLS pixels to an accumulator. Lightness & saturation moments go through the
+// kernel table; the bins & the hue sums, which depend on each pixel's saturation, are scalar.
+//----------------------------------------------------------------------------------------------------
+
+static void AccumulateRun(e1nStatsAccumulator &acc, const e1nStatsOptions &options,
+                          const float *h, const float *l, const float *s, const int count)
+{
+    const float *trig     = GetHueTable();
+    uint64_t    *hueHist  = acc.hist[0].data();
+    uint64_t    *valHist  = acc.hist[1].data();
+    uint64_t    *satHist  = acc.hist[2].data();
+    int          hueBins  = options.hueBins;
+    int          valBins  = options.valBins;
+    int          satBins  = options.satBins;
+
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    kernels.moments(l, count, acc.sum[1], acc.sumSq[1], acc.lo[1], acc.hi[1]);
+    kernels.moments(s, count, acc.sum[2], acc.sumSq[2], acc.lo[2], acc.hi[2]);
+
+    float  hueSum   = 0.0f;
+    float  hueSumSq = 0.0f;
+    float  cosSum   = 0.0f;
+    float  sinSum   = 0.0f;
+    int    grays    = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ++valHist[BinOf(l[i], valBins)];
+        ++satHist[BinOf(s[i], satBins)];
+
+        if (s[i] <= options.grayThreshold)
+        {
+            ++grays;
+            continue;
+        }
+
+        float hue = h[i];
+        int   at  = (int) (hue * E1N_HUE_TABLE_SIZE + 0.5f) & (E1N_HUE_TABLE_SIZE - 1);
+
+        ++hueHist[BinOf(hue, hueBins)];
+
+        hueSum   += hue;
+        hueSumSq += hue * hue;
+        cosSum   += trig[at * 2];
+        sinSum   += trig[at * 2 + 1];
+
+        acc.lo[0] = min(acc.lo[0], hue);
+        acc.hi[0] = max(acc.hi[0], hue);
+    }
+
+    // Runs are short, so float partials lose nothing that matters before going into the doubles.
+    acc.sum[0]   += hueSum;
+    acc.sumSq[0] += hueSumSq;
+    acc.cosSum   += cosSum;
+    acc.sinSum   += sinSum;
+    acc.grays    += grays;
+    acc.pixels   += count;
+}
+
+// Drops the pixels under a zero mask weight, packing the rest to the front of the run.
+static int CompactRun(float *c0, float *c1, float *c2, const float *weights, const int count)
+{
+    int kept = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (weights[i] > 0.0f)
+        {
+            c0[kept] = c0[i];
+            c1[kept] = c1[i];
+            c2[kept] = c2[i];
+            ++kept;
+        }
+    }
+
+    return kept;
+}
+
+//====================================================================================================
+// Drivers:
+//====================================================================================================
+//     Both inputs come down to "fill three runs of floats for (row, col, count)", after which the
+// path is the same: mask, convert, accumulate into the running thread's own totals.
+//----------------------------------------------------------------------------------------------------
+
+template <class Source> static e1nHLSStats ComputeStats(const Size size, const e1nStatsOptions &options, const e1nMask &mask,
+                                                        e1nTileScheduler *scheduler, const Source &source)
+{
+    CV_Assert(options.hueBins > 0 && options.satBins > 0 && options.valBins > 0);
+    CV_Assert(mask.Empty() || mask.GetSize() == size);
+
+    e1nTileScheduler &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+
+    vector<e1nStatsAccumulator> totals(pool.GetThreadCount());
+
+    for (size_t t = 0; t < totals.size(); ++t) {totals[t].Reset(options);}
+
+    pool.ForEachTile(size, [&](const Rect &tile, const int thread)
+    {
+        e1nStatsAccumulator &acc = totals[thread];
+
+        alignas(64) float c0[E1N_BATCH_CHUNK];
+        alignas(64) float c1[E1N_BATCH_CHUNK];
+        alignas(64) float c2[E1N_BATCH_CHUNK];
+        alignas(64) float m [E1N_BATCH_CHUNK];
+
+        for (int row = tile.y; row < tile.y + tile.height; ++row)
+        {
+            for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+                source(row, col, count, c0, c1, c2);
+
+                if (!mask.Empty())
+                {
+                    mask.UnpackRow(row, col, count, m);
+                    count = CompactRun(c0, c1, c2, m, count);
+                }
+
+                if (!options.inputIsHLS) {e1nGetKernels().convert[E1N_CONVERT_RGB2HLS](c0, c1, c2, count);}
+
+                AccumulateRun(acc, options, c0, c1, c2, count);
+            }
+        }
+    });
+
+    for (size_t t = 1; t < totals.size(); ++t) {totals[0].Merge(totals[t]);}
+
+    // Turn the totals into statistics.
+    const e1nStatsAccumulator &acc = totals[0];
+    e1nHLSStats                stats;
+    e1nChannelStats           *channels[3] = {&stats.hue, &stats.val, &stats.sat};
+    uint64_t                   counts[3]   = {acc.pixels - acc.grays, acc.pixels, acc.pixels};
+
+    stats.pixels     = acc.pixels;
+    stats.grayPixels = acc.grays;
+    stats.hueHist    = acc.hist[0];
+    stats.valHist    = acc.hist[1];
+    stats.satHist    = acc.hist[2];
+
+    for (int k = 0; k < 3; ++k)
+    {
+        double n    = (double) max(counts[k], (uint64_t) 1);
+        double mean = acc.sum[k] / n;
+
+        channels[k]->mean     = mean;
+        channels[k]->variance = max(acc.sumSq[k] / n - mean * mean, 0.0);
+        channels[k]->min      = counts[k] ? acc.lo[k] : 0.0f;
+        channels[k]->max      = counts[k] ? acc.hi[k] : 0.0f;
+    }
+
+    double chromatic = (double) counts[0];
+    double length    = chromatic > 0.0 ? sqrt(acc.cosSum * acc.cosSum + acc.sinSum * acc.sinSum) / chromatic : 0.0;
+    double angle     = atan2(acc.sinSum, acc.cosSum) / (2.0 * PI);
+
+    stats.hueMean          = (float) (angle < 0.0 ? angle + 1.0 : angle);
+    stats.hueConcentration = (float) min(length, 1.0);
+    stats.hueSpread        = (float) (sqrt(-2.0 * log(max(length, 1.0e-12))) / (2.0 * PI));
+
+    size_t peak = max_element(stats.hueHist.begin(), stats.hueHist.end()) - stats.hueHist.begin();
+
+    stats.dominantHue = chromatic > 0.0 ? (float) ((peak + 0.5) / options.hueBins) : 0.0f;
+
+    return stats;
+}
+
+e1nHLSStats e1nComputeStats(const Mat &image, const e1nStatsOptions &options, const e1nMask &mask, e1nTileScheduler *scheduler)
+{
+    CV_Assert(image.type() == CV_8UC3 || image.type() == CV_8UC4 || image.type() == CV_32FC3 || image.type() == CV_32FC4);
+
+    E1N_TRACE_OP("e1nComputeStats", image.total(), image.total() * image.elemSize());
+
+    return ComputeStats(image.size(), options, mask, scheduler,
+                        [&image](const int row, const int col, const int count, float *c0, float *c1, float *c2)
+    {
+        e1nUnpackRow(image, row, col, count, c0, c1, c2);
+    });
+}
+
+e1nHLSStats e1nComputeStats(const e1nColorPlanes &planes, const e1nStatsOptions &options, const e1nMask &mask, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nComputeStats", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 12);
+
+    return ComputeStats(Size(planes.Cols(), planes.Rows()), options, mask, scheduler,
+                        [&planes](const int row, const int col, const int count, float *c0, float *c1, float *c2)
+    {
+        // Copied, since the conversion & masking work in place.
+        memcpy(c0, planes.Row(0, row) + col, count * sizeof(float));
+        memcpy(c1, planes.Row(1, row) + col, count * sizeof(float));
+        memcpy(c2, planes.Row(2, row) + col, count * sizeof(float));
+    });
+}
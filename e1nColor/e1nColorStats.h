@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorStats.h - Interface definition file for e1nColor's HLS histograms & image statistics.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORSTATS_H
+#define E1NCOLORSTATS_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Histograms & summary statistics of an image's hue, saturation & value, computed with the same
+// HLS math as e1nColor in one read-only pass: nothing is written back to the image. Tiles are spread
+// across the tile scheduler, each thread filling its own private bins & sums, which are merged once
+// at the end, so threads never contend.
+//
+//     Hue is an angle, so besides the plain (linear) moments it gets circular ones: the mean
+// direction of the hues as unit vectors, & how tightly they cluster around it. A red image whose hues
+// straddle 0 & 1 has a circular mean of ~0 (red), where the linear mean would say ~0.5 (cyan). A gray
+// has no hue at all, so pixels whose saturation is at or below the gray threshold are left out of
+// every hue statistic & counted separately.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// What to compute.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nStatsOptions
+{
+    int   hueBins;                      // Histogram bins across 0-1 for each component.
+    int   satBins;
+    int   valBins;
+    float grayThreshold;                // Saturations at or below this count as gray.
+    bool  inputIsHLS;                   // The image is already HLS; skip the conversion.
+
+    e1nStatsOptions() : hueBins(360), satBins(256), valBins(256), grayThreshold(0.0f), inputIsHLS(false) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+// Linear moments of one component.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nChannelStats
+{
+    double mean;
+    double variance;
+    float  min;
+    float  max;
+};
+
+//----------------------------------------------------------------------------------------------------
+// The results.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nHLSStats
+{
+    uint64_t pixels;                    // Pixels counted (those under a non-zero mask weight).
+    uint64_t grayPixels;                // Of those, the ones with no usable hue.
+
+    vector<uint64_t> hueHist;           // Chromatic pixels only.
+    vector<uint64_t> satHist;
+    vector<uint64_t> valHist;
+
+    e1nChannelStats hue;                // Linear hue moments, chromatic pixels only.
+    e1nChannelStats sat;
+    e1nChannelStats val;
+
+    float hueMean;                      // Circular mean hue, 0-1.
+    float hueConcentration;             // Mean resultant length: 1 all one hue, 0 evenly spread.
+    float hueSpread;                    // Circular standard deviation, as a fraction of the wheel.
+    float dominantHue;                  // Center of the fullest hue bin, 0-1.
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Statistics of a CV_8UC3/4 or CV_32FC3/4 image or an e1nColorPlanes buffer, RGB unless the
+// options say HLS. With a mask, only pixels of non-zero weight are counted. A null scheduler means
+// e1nTileScheduler::Default().
+//----------------------------------------------------------------------------------------------------
+
+e1nHLSStats e1nComputeStats(const Mat &image, const e1nStatsOptions &options = e1nStatsOptions(),
+                            const e1nMask &mask = e1nMask(), e1nTileScheduler *scheduler = nullptr);
+
+e1nHLSStats e1nComputeStats(const e1nColorPlanes &planes, const e1nStatsOptions &options = e1nStatsOptions(),
+                            const e1nMask &mask = e1nMask(), e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NCOLORSTATS_H
@@ -0,0 +1,356 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorT.h - Compact, templated pixel types for the e1nColor library.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORT_H
+#define E1NCOLORT_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nColor is four 32-bit floats, 16 bytes a pixel, which is what the HLS math wants but far more
+// than an image needs in memory. e1nColorT stores a pixel in whatever channel type the image is
+// actually kept in (uint8_t, uint16_t, e1nHalf or float), with or without alpha, & widens to float
+// only while doing math. The channel type is a template parameter, so every conversion is picked at
+// compile time & the batch loops carry no per-pixel type checks.
+//
+//     Channels are normalized: 0-255, 0-65535, & 0.0-1.0 all mean 0-1, the same as e1nColor's bytes.
+//====================================================================================================
+
+//====================================================================================================
+// e1nHalf - IEEE 754 half-precision storage. Arithmetic is done after widening to float.
+//====================================================================================================
+
+struct e1nHalf
+{
+    uint16_t bits;
+
+    e1nHalf() {}
+    explicit e1nHalf(const float someFloat) : bits(FromFloat(someFloat)) {}
+
+    operator float() const {return ToFloat(bits);}
+
+    //----------------------------------------------------------------------------------------------------
+    //     Round-to-nearest-even conversions. F16C does them in hardware; the fallbacks are bit-exact
+    // equivalents, overflow to infinity & NaN propagation included.
+    //----------------------------------------------------------------------------------------------------
+
+    static uint16_t FromFloat(const float someFloat)
+    {
+#if defined(__F16C__)
+        return (uint16_t) _cvtss_sh(someFloat, 0);
+#else
+        uint32_t x;
+        memcpy(&x, &someFloat, 4);
+
+        uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t mag  = x & 0x7FFFFFFF;
+
+        if (mag >= 0x7F800000) {return (uint16_t) (sign | 0x7C00 | (mag > 0x7F800000 ? 0x200 | (mag >> 13 & 0x3FF) : 0));}   // Inf & NaN.
+        if (mag >= 0x477FF000) {return (uint16_t) (sign | 0x7C00);}                                     // Rounds past 65504.
+
+        // Subnormal halves are just the value in units of 2^-24, which float math rounds for us.
+        if (mag < 0x38800000)
+        {
+            float f;
+            memcpy(&f, &mag, 4);
+
+            return (uint16_t) (sign | (uint32_t) nearbyintf(f * 16777216.0f));
+        }
+
+        // Rebias the exponent (127 -> 15) & round the 23-bit mantissa to 10 bits, ties to even.
+        return (uint16_t) (sign | ((mag + 0xC8000FFF + ((mag >> 13) & 1)) >> 13));
+#endif
+    }
+
+    static float ToFloat(const uint16_t someBits)
+    {
+#if defined(__F16C__)
+        return _cvtsh_ss(someBits);
+#else
+        uint32_t sign = (uint32_t) (someBits & 0x8000) << 16;
+        uint32_t exp  = (someBits >> 10) & 0x1F;
+        uint32_t mant = someBits & 0x3FF;
+        uint32_t x;
+
+        if (exp == 0)
+        {
+            float f = mant * (1.0f / 16777216.0f);      // Zero & subnormals, exactly.
+            memcpy(&x, &f, 4);
+            x |= sign;
+        }
+        else if (exp == 31) {x = sign | 0x7F800000 | mant << 13 | (mant ? 0x400000 : 0);}   // NaNs come out quiet.
+        else                {x = sign | (exp + 112) << 23 | mant << 13;}
+
+        float result;
+        memcpy(&result, &x, 4);
+
+        return result;
+#endif
+    }
+};
+
+//====================================================================================================
+// Channel traits - How each storage type maps to & from the 0-1 floats the math runs on.
+//====================================================================================================
+
+template <typename T> struct e1nChannelTraits;
+
+template <> struct e1nChannelTraits<uint8_t>
+{
+    static const int Depth = CV_8U;
+
+    static float   ToFloat  (const uint8_t v) {return e1nByteToFloat(v);}
+    static uint8_t FromFloat(const float f)   {return e1nFloatToByte(f);}
+};
+
+template <> struct e1nChannelTraits<uint16_t>
+{
+    static const int Depth = CV_16U;
+
+    static float    ToFloat  (const uint16_t v) {return v * (1.0f / 65535.0f);}
+    static uint16_t FromFloat(const float f)    {return (uint16_t) ((f > 0.0f ? (f < 1.0f ? f : 1.0f) : 0.0f) * 65535.0f + 0.5f);}
+};
+
+template <> struct e1nChannelTraits<e1nHalf>
+{
+    static const int Depth = CV_16F;
+
+    static float   ToFloat  (const e1nHalf v) {return (float) v;}
+    static e1nHalf FromFloat(const float f)   {return e1nHalf(f);}
+};
+
+template <> struct e1nChannelTraits<float>
+{
+    static const int Depth = CV_32F;
+
+    static float ToFloat  (const float v) {return v;}
+    static float FromFloat(const float f) {return f;}
+};
+
+//====================================================================================================
+// Storage - Three or four channels, nothing else, so arrays of pixels match OpenCV's Mat layout.
+//====================================================================================================
+
+template <typename T, bool Alpha> struct e1nPixelStorage
+{
+    T r;
+    T g;
+    T b;
+    T a;
+};
+
+template <typename T> struct e1nPixelStorage<T, false>
+{
+    T r;
+    T g;
+    T b;
+};
+
+//====================================================================================================
+// e1nColorT - A color stored as T per channel, with or without alpha:
+//====================================================================================================
+
+template <typename T, bool Alpha = false> class e1nColorT : public e1nPixelStorage<T, Alpha>
+{
+public:
+
+    typedef T                   Channel;
+    typedef e1nChannelTraits<T> Traits;
+
+    static const bool HasAlpha = Alpha;
+    static const int  Channels = Alpha ? 4 : 3;
+    static const int  CvType   = CV_MAKETYPE(e1nChannelTraits<T>::Depth, Alpha ? 4 : 3);
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nColorT() {}
+
+    // From 0-1 floats. Alpha defaults to white, as it does for e1nColor.
+    e1nColorT(const float rVal, const float gVal, const float bVal, const float aVal = 1.0f)
+    {
+        SetFloats(rVal, gVal, bVal, aVal);
+    }
+
+    // Narrowing from, & widening to, the full-precision class.
+    explicit e1nColorT(const e1nColor &someColor)
+    {
+        SetFloats(someColor.GetRedFloat(), someColor.GetGreenFloat(), someColor.GetBlueFloat(), someColor.GetAlphaFloat());
+    }
+
+    e1nColor ToColor() const
+    {
+        return e1nColor(GetRedFloat(), GetGreenFloat(), GetBlueFloat(), GetAlphaFloat());
+    }
+
+    //----------------------------------------------------------------------------------------------------
+    // Channel access, as 0-1 floats:
+    //----------------------------------------------------------------------------------------------------
+
+    float GetRedFloat()   const {return Traits::ToFloat(this->r);}
+    float GetGreenFloat() const {return Traits::ToFloat(this->g);}
+    float GetBlueFloat()  const {return Traits::ToFloat(this->b);}
+    float GetAlphaFloat() const {return GetAlpha(*this);}
+
+    void SetFloats(const float rVal, const float gVal, const float bVal, const float aVal = 1.0f)
+    {
+        this->r = Traits::FromFloat(rVal);
+        this->g = Traits::FromFloat(gVal);
+        this->b = Traits::FromFloat(bVal);
+
+        SetAlpha(*this, aVal);
+    }
+
+    //----------------------------------------------------------------------------------------------------
+    // Hue, Saturation, and Value, computed with the same math as e1nColor:
+    //----------------------------------------------------------------------------------------------------
+
+    float GetHue() const {float h, l, s; GetHLS(h, l, s); return h;}
+    float GetSat() const {float h, l, s; GetHLS(h, l, s); return s;}
+    float GetVal() const {float h, l, s; GetHLS(h, l, s); return l;}
+
+    void ConvertRGB2HLS()
+    {
+        float h, l, s;
+
+        GetHLS(h, l, s);
+        SetFloats(h, l, s, GetAlphaFloat());
+    }
+
+    void ConvertHLS2RGB()
+    {
+        e1nSimd::e1nF32x1 c0 = GetRedFloat(), c1 = GetGreenFloat(), c2 = GetBlueFloat();
+
+        e1nSimd::HLS2RGB(c0, c1, c2);
+        SetFloats(c0.v, c1.v, c2.v, GetAlphaFloat());
+    }
+
+private:
+
+    void GetHLS(float &h, float &l, float &s) const
+    {
+        e1nSimd::e1nF32x1 c0 = GetRedFloat(), c1 = GetGreenFloat(), c2 = GetBlueFloat();
+
+        e1nSimd::RGB2HLS(c0, c1, c2);
+
+        h = c0.v;
+        l = c1.v;
+        s = c2.v;
+    }
+
+    // Alpha access that compiles away for the alpha-less storage.
+    static float GetAlpha(const e1nPixelStorage<T, true>  &p) {return Traits::ToFloat(p.a);}
+    static float GetAlpha(const e1nPixelStorage<T, false> &)  {return 1.0f;}
+
+    static void  SetAlpha(e1nPixelStorage<T, true>  &p, const float aVal) {p.a = Traits::FromFloat(aVal);}
+    static void  SetAlpha(e1nPixelStorage<T, false> &,  const float)      {}
+};
+
+//----------------------------------------------------------------------------------------------------
+// The common pixel formats:
+//----------------------------------------------------------------------------------------------------
+
+typedef e1nColorT<uint8_t,  false> e1nRGB8;
+typedef e1nColorT<uint8_t,  true>  e1nRGBA8;
+typedef e1nColorT<uint16_t, false> e1nRGB16;
+typedef e1nColorT<uint16_t, true>  e1nRGBA16;
+typedef e1nColorT<e1nHalf,  false> e1nRGBh;
+typedef e1nColorT<e1nHalf,  true>  e1nRGBAh;
+typedef e1nColorT<float,    false> e1nRGB32f;
+typedef e1nColorT<float,    true>  e1nRGBA32f;
+
+static_assert(sizeof(e1nRGB8)  == 3 && sizeof(e1nRGBA8)  == 4,  "e1nColorT must not be padded");
+static_assert(sizeof(e1nRGB16) == 6 && sizeof(e1nRGBA16) == 8,  "e1nColorT must not be padded");
+static_assert(sizeof(e1nRGBh)  == 6 && sizeof(e1nRGBAh)  == 8,  "e1nColorT must not be padded");
+static_assert(sizeof(e1nRGB32f) == 12 && sizeof(e1nRGBA32f) == 16, "e1nColorT must not be padded");
+
+//====================================================================================================
+// Batch functions over arrays of e1nColorT:
+//====================================================================================================
+//     Pixels are widened a chunk at a time into float planes, run through the same SIMD kernels as
+// the Mat & e1nColorPlanes batch functions, & narrowed back in place. Alpha is left alone.
+//----------------------------------------------------------------------------------------------------
+
+template <typename T, bool Alpha, class Convert>
+inline void e1nConvertPixels(e1nColorT<T, Alpha> *pixels, const size_t count, const Convert convert)
+{
+    typedef e1nChannelTraits<T> Traits;
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+
+    for (size_t first = 0; first < count; first += E1N_BATCH_CHUNK)
+    {
+        size_t               n = min((size_t) E1N_BATCH_CHUNK, count - first);
+        e1nColorT<T, Alpha> *p = pixels + first;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            c0[i] = Traits::ToFloat(p[i].r);
+            c1[i] = Traits::ToFloat(p[i].g);
+            c2[i] = Traits::ToFloat(p[i].b);
+        }
+
+        convert(c0, c1, c2, n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            p[i].r = Traits::FromFloat(c0[i]);
+            p[i].g = Traits::FromFloat(c1[i]);
+            p[i].b = Traits::FromFloat(c2[i]);
+        }
+    }
+}
+
+template <typename T, bool Alpha> inline void e1nConvertRGB2HLS(e1nColorT<T, Alpha> *pixels, const size_t count)
+{
+    e1nConvertPixels(pixels, count, static_cast<void (*)(float *, float *, float *, const size_t)>(e1nConvertRGB2HLS));
+}
+
+template <typename T, bool Alpha> inline void e1nConvertHLS2RGB(e1nColorT<T, Alpha> *pixels, const size_t count)
+{
+    e1nConvertPixels(pixels, count, static_cast<void (*)(float *, float *, float *, const size_t)>(e1nConvertHLS2RGB));
+}
+
+//----------------------------------------------------------------------------------------------------
+// Typed access to the rows of a Mat whose type matches the pixel format (checked once, per call).
+//----------------------------------------------------------------------------------------------------
+
+template <class Pixel> inline Pixel *e1nPixelRow(Mat &image, const int row)
+{
+    CV_Assert(image.type() == Pixel::CvType);
+
+    return image.ptr<Pixel>(row);
+}
+
+// Converts every row of a Mat stored as e1nColorT pixels, e.g. e1nConvertRGB2HLS<e1nRGBh>(image).
+template <class Pixel> inline void e1nConvertRGB2HLS(Mat &image)
+{
+    for (int row = 0; row < image.rows; ++row) {e1nConvertRGB2HLS(e1nPixelRow<Pixel>(image, row), (size_t) image.cols);}
+}
+
+template <class Pixel> inline void e1nConvertHLS2RGB(Mat &image)
+{
+    for (int row = 0; row < image.rows; ++row) {e1nConvertHLS2RGB(e1nPixelRow<Pixel>(image, row), (size_t) image.cols);}
+}
+
+#endif     // E1NCOLORT_H
@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nColorView.h - Zero-copy typed views over cv::Mat memory for the e1nColor library.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCOLORVIEW_H
+#define E1NCOLORVIEW_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorT.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstddef>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nColorView<Pixel> looks at a Mat's pixels as e1nColorT values in place. It is just a pointer,
+// a row step & a size: nothing is copied or converted until a pixel is read, & writes land directly in
+// the Mat. ROIs & non-continuous Mats work, since every row is found through the Mat's own step.
+//
+//     The view doesn't own the memory or hold a reference to it, so the Mat (or whatever it shares its
+// data with) has to outlive the view. Like a Mat header, a view over a const Mat can still write;
+// view it as e1nColorView<const Pixel> to keep it read-only.
+//
+//     for (e1nPixelSpan<e1nRGBA8> row : e1nColorView<e1nRGBA8>(image))
+//     {
+//         for (e1nRGBA8 &pixel : row) {pixel.SetFloats(pixel.GetBlueFloat(), pixel.GetGreenFloat(), pixel.GetRedFloat(), 1.0f);}
+//     }
+//
+//     Vec3b / Vec4b / Vec4f images are e1nRGB8 / e1nRGBA8 / e1nRGBA32f, channel 0 read as red, as
+// e1nColor(Vec3b &) does.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// e1nPixelSpan - One run of contiguous pixels (typically a row), usable as a range.
+//----------------------------------------------------------------------------------------------------
+
+template <class Pixel> class e1nPixelSpan
+{
+private:
+
+    Pixel *pixels;
+    int    count;
+
+public:
+
+    e1nPixelSpan() : pixels(nullptr), count(0) {}
+    e1nPixelSpan(Pixel *data, const int numPixels) : pixels(data), count(numPixels) {}
+
+    Pixel *Data()  const {return pixels;}
+    int    Size()  const {return count;}
+    bool   Empty() const {return count == 0;}
+
+    Pixel &operator [](const int i) const {return pixels[i];}
+
+    Pixel *begin() const {return pixels;}
+    Pixel *end()   const {return pixels + count;}
+
+    // A sub-run, sharing memory.
+    e1nPixelSpan Sub(const int first, const int numPixels) const {return e1nPixelSpan(pixels + first, numPixels);}
+};
+
+//----------------------------------------------------------------------------------------------------
+// e1nColorView - A typed 2D view.
+//----------------------------------------------------------------------------------------------------
+
+template <class Pixel> class e1nColorView
+{
+private:
+
+    unsigned char *data;                // First pixel of row 0.
+    size_t         step;                // Bytes from one row to the next.
+    int            rows;
+    int            cols;
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Row iterator, so a view can be walked with a range-based for. Dereferences to a row's span.
+    //----------------------------------------------------------------------------------------------------
+
+    class RowIterator
+    {
+    private:
+
+        const e1nColorView *view;
+        int                 row;
+
+    public:
+
+        RowIterator(const e1nColorView *someView, const int someRow) : view(someView), row(someRow) {}
+
+        e1nPixelSpan<Pixel> operator *() const {return view->Row(row);}
+
+        RowIterator &operator ++()                            {++row; return *this;}
+        bool         operator !=(const RowIterator &other) const {return row != other.row;}
+        bool         operator ==(const RowIterator &other) const {return row == other.row;}
+    };
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nColorView() : data(nullptr), step(0), rows(0), cols(0) {}
+
+    // Over a Mat (or ROI) of exactly Pixel's type; anything else is an error.
+    explicit e1nColorView(const Mat &image) : data(image.data), step(image.step[0]), rows(image.rows), cols(image.cols)
+    {
+        CV_Assert(image.type() == Pixel::CvType);
+        CV_Assert(image.dims <= 2);
+    }
+
+    // Over raw memory; the step is in bytes & defaults to tightly packed rows.
+    e1nColorView(Pixel *pixels, const int numRows, const int numCols, const size_t rowStep = 0)
+        : data((unsigned char *) pixels), step(rowStep ? rowStep : numCols * sizeof(Pixel)), rows(numRows), cols(numCols) {}
+
+    //----------------------------------------------------------------------------------------------------
+    // Access:
+    //----------------------------------------------------------------------------------------------------
+
+    int    Rows()  const {return rows;}
+    int    Cols()  const {return cols;}
+    size_t Step()  const {return step;}
+    bool   Empty() const {return rows == 0 || cols == 0;}
+    bool   IsContinuous() const {return step == cols * sizeof(Pixel) || rows == 1;}
+
+    Pixel *RowPtr(const int row) const {return (Pixel *) (data + row * step);}
+
+    e1nPixelSpan<Pixel> Row(const int row) const {return e1nPixelSpan<Pixel>(RowPtr(row), cols);}
+
+    Pixel &operator ()(const int row, const int col) const {return RowPtr(row)[col];}
+
+    // The whole view as one span, when the rows are back to back.
+    e1nPixelSpan<Pixel> Continuous() const
+    {
+        CV_Assert(IsContinuous());
+
+        return e1nPixelSpan<Pixel>(RowPtr(0), rows * cols);
+    }
+
+    RowIterator begin() const {return RowIterator(this, 0);}
+    RowIterator end()   const {return RowIterator(this, rows);}
+
+    //----------------------------------------------------------------------------------------------------
+    // Sub-views & interop, all sharing memory:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nColorView Region(const Rect &roi) const
+    {
+        CV_Assert(roi.x >= 0 && roi.y >= 0 && roi.x + roi.width <= cols && roi.y + roi.height <= rows);
+
+        return e1nColorView(RowPtr(roi.y) + roi.x, roi.height, roi.width, step);
+    }
+
+    // A Mat header over the view's memory (no copy, no reference count), for handing back to OpenCV.
+    Mat ToMat() const {return Mat(rows, cols, Pixel::CvType, (void *) data, step);}
+};
+
+//----------------------------------------------------------------------------------------------------
+// The formats OpenCV images usually come in:
+//----------------------------------------------------------------------------------------------------
+
+typedef e1nColorView<e1nRGB8>    e1nViewRGB8;         // CV_8UC3  / Vec3b
+typedef e1nColorView<e1nRGBA8>   e1nViewRGBA8;        // CV_8UC4  / Vec4b
+typedef e1nColorView<e1nRGB16>   e1nViewRGB16;        // CV_16UC3 / Vec3w
+typedef e1nColorView<e1nRGBA16>  e1nViewRGBA16;       // CV_16UC4 / Vec4w
+typedef e1nColorView<e1nRGB32f>  e1nViewRGB32f;       // CV_32FC3 / Vec3f
+typedef e1nColorView<e1nRGBA32f> e1nViewRGBA32f;      // CV_32FC4 / Vec4f
+
+//====================================================================================================
+// Batch functions over views:
+//====================================================================================================
+//     Rows are spread across the tile scheduler (a null scheduler means e1nTileScheduler::Default())
+// & handed to func as spans, so any operation on a run of e1nColorT pixels, including the e1nColorT
+// batch conversions, reads & writes the Mat memory directly.
+//----------------------------------------------------------------------------------------------------
+
+template <class Pixel, class Func>
+inline void e1nForEachRow(const e1nColorView<Pixel> &view, const Func &func, e1nTileScheduler *scheduler = nullptr)
+{
+    e1nTileScheduler &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+
+    pool.ParallelFor(view.Rows(), [&](const int row, const int) {func(view.Row(row));});
+}
+
+template <class Pixel> inline void e1nConvertRGB2HLS(const e1nColorView<Pixel> &view, e1nTileScheduler *scheduler = nullptr)
+{
+    e1nForEachRow(view, [](const e1nPixelSpan<Pixel> &row) {e1nConvertRGB2HLS(row.Data(), (size_t) row.Size());}, scheduler);
+}
+
+template <class Pixel> inline void e1nConvertHLS2RGB(const e1nColorView<Pixel> &view, e1nTileScheduler *scheduler = nullptr)
+{
+    e1nForEachRow(view, [](const e1nPixelSpan<Pixel> &row) {e1nConvertHLS2RGB(row.Data(), (size_t) row.Size());}, scheduler);
+}
+
+#endif     // E1NCOLORVIEW_H
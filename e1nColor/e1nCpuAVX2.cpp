@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nCpuAVX2.cpp - e1nColor's batch kernels, built for AVX2 (eight lanes).
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+
+#if defined(E1N_CPU_X86)
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// Preprocessor directives:
+#if defined(E1NSIMD_H)
+#error "e1nCpuAVX2.cpp: e1nSimd.h was included before E1N_SIMD_LEVEL was set."
+#endif
+
+// AVX2 doesn't imply FMA, & fp-contract=off keeps the compiler from using it if it does get enabled.
+#if   defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx2")
+#endif
+
+#define E1N_SIMD_LEVEL E1N_SIMD_AVX2
+
+#include "lib/e1nColor/e1nCpuKernels.h"
+
+void e1nFillKernelsAVX2(e1nKernelTable &table)
+{
+    e1nSimd::FillKernelTable(table, E1N_CPU_AVX2);
+}
+
+#if   defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif  // E1N_CPU_X86
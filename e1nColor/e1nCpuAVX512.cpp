@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nCpuAVX512.cpp - e1nColor's batch kernels, built for AVX-512F (sixteen lanes).
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+
+#if defined(E1N_CPU_X86)
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// GCC's _mm512_undefined_ps() trips -Wmaybe-uninitialized wherever it's inlined; quiet the header.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Preprocessor directives:
+#if defined(E1NSIMD_H)
+#error "e1nCpuAVX512.cpp: e1nSimd.h was included before E1N_SIMD_LEVEL was set."
+#endif
+
+// AVX-512F brings FMA with it, so fp-contract=off is what keeps its products unfused.
+#if   defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx512f")
+#endif
+
+#define E1N_SIMD_LEVEL E1N_SIMD_AVX512
+
+#include "lib/e1nColor/e1nCpuKernels.h"
+
+void e1nFillKernelsAVX512(e1nKernelTable &table)
+{
+    e1nSimd::FillKernelTable(table, E1N_CPU_AVX512);
+}
+
+#if   defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif  // E1N_CPU_X86
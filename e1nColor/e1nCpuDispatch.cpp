@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nCpuDispatch.cpp - Implementation file for e1nColor's runtime CPU detection & kernel dispatch.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if defined(E1N_CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(E1N_CPU_X86)
+#include <cpuid.h>
+#endif
+
+// Preprocessor directives:
+using namespace std;
+
+// Defined by the per-level kernel files.
+void e1nFillKernelsScalar(e1nKernelTable &table);
+
+#if defined(E1N_CPU_X86)
+void e1nFillKernelsSSE4(e1nKernelTable &table);
+void e1nFillKernelsAVX2(e1nKernelTable &table);
+void e1nFillKernelsAVX512(e1nKernelTable &table);
+#endif
+
+//====================================================================================================
+// Detection:
+//====================================================================================================
+
+#if defined(E1N_CPU_X86)
+
+// Registers a, b, c & d of cpuid leaf / subleaf; zeros if the leaf is past the highest the CPU has.
+static void CpuId(const unsigned leaf, const unsigned subleaf, uint32_t *r)
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+
+    if ((unsigned) info[0] < leaf) {memset(r, 0, 4 * sizeof(uint32_t)); return;}
+
+    __cpuidex(info, (int) leaf, (int) subleaf);
+
+    for (int k = 0; k < 4; ++k) {r[k] = (uint32_t) info[k];}
+#else
+    unsigned a, b, c, d;
+
+    if (!__get_cpuid_count(leaf, subleaf, &a, &b, &c, &d)) {memset(r, 0, 4 * sizeof(uint32_t)); return;}
+
+    r[0] = a;
+    r[1] = b;
+    r[2] = c;
+    r[3] = d;
+#endif
+}
+
+// Which register states the OS saves on a context switch (XCR0). Only valid with OSXSAVE set.
+static uint64_t ReadXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+
+    __asm__ volatile ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+
+    return ((uint64_t) hi << 32) | lo;
+#endif
+}
+
+#endif  // E1N_CPU_X86
+
+static e1nCpuLevel Detect()
+{
+#if defined(E1N_CPU_X86)
+    uint32_t leaf1[4], leaf7[4];
+
+    CpuId(1, 0, leaf1);
+    CpuId(7, 0, leaf7);
+
+    bool sse41   = (leaf1[2] >> 19) & 1;
+    bool sse42   = (leaf1[2] >> 20) & 1;
+    bool osxsave = (leaf1[2] >> 27) & 1;
+    bool avx     = (leaf1[2] >> 28) & 1;
+    bool avx2    = (leaf7[1] >>  5) & 1;
+    bool avx512f = (leaf7[1] >> 16) & 1;
+
+    if (!sse41 || !sse42) {return E1N_CPU_SCALAR;}
+
+    // The instructions are no use unless the OS preserves the registers they work in: XMM & YMM
+    // (bits 1-2) for AVX2, & the opmask & both halves of ZMM as well (bits 5-7) for AVX-512.
+    uint64_t xcr0 = osxsave ? ReadXCR0() : 0;
+
+    if (!avx || !avx2 || (xcr0 & 0x06) != 0x06) {return E1N_CPU_SSE4;}
+    if (!avx512f || (xcr0 & 0xE6) != 0xE6)      {return E1N_CPU_AVX2;}
+
+    return E1N_CPU_AVX512;
+#else
+    return E1N_CPU_SCALAR;
+#endif
+}
+
+//====================================================================================================
+// Kernel tables:
+//====================================================================================================
+
+static e1nKernelTable                 e1nTables[E1N_CPU_LEVEL_COUNT];
+static e1nCpuLevel                    e1nSupported = E1N_CPU_SCALAR;
+static atomic<const e1nKernelTable *> e1nActive(nullptr);
+static once_flag                      e1nTablesBuilt;
+
+// E1N_CPU_LEVEL, if it names a level; -1 otherwise.
+static int GetLevelOverride()
+{
+    const char *name = getenv("E1N_CPU_LEVEL");
+
+    if (!name) {return -1;}
+
+    for (int level = 0; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (strcmp(name, e1nGetCpuLevelName((e1nCpuLevel) level)) == 0) {return level;}
+    }
+
+    return -1;
+}
+
+//     Fills a table for every level the CPU supports (only those, since a table can't be built
+// without touching code compiled for its level) & starts at the highest, or at E1N_CPU_LEVEL if that
+// asks for less.
+static void BuildTables()
+{
+    e1nSupported = Detect();
+
+    e1nFillKernelsScalar(e1nTables[E1N_CPU_SCALAR]);
+
+#if defined(E1N_CPU_X86)
+    if (e1nSupported >= E1N_CPU_SSE4)   {e1nFillKernelsSSE4  (e1nTables[E1N_CPU_SSE4]);}
+    if (e1nSupported >= E1N_CPU_AVX2)   {e1nFillKernelsAVX2  (e1nTables[E1N_CPU_AVX2]);}
+    if (e1nSupported >= E1N_CPU_AVX512) {e1nFillKernelsAVX512(e1nTables[E1N_CPU_AVX512]);}
+#endif
+
+    int level = GetLevelOverride();
+
+    if (level < 0 || level > e1nSupported) {level = e1nSupported;}
+
+    e1nActive.store(&e1nTables[level], memory_order_release);
+}
+
+//====================================================================================================
+// Public functions:
+//====================================================================================================
+
+e1nCpuLevel e1nDetectCpuLevel()
+{
+    call_once(e1nTablesBuilt, BuildTables);
+
+    return e1nSupported;
+}
+
+e1nCpuLevel e1nGetCpuLevel()
+{
+    return (e1nCpuLevel) e1nGetKernels().level;
+}
+
+bool e1nSetCpuLevel(const e1nCpuLevel level)
+{
+    if (level < E1N_CPU_SCALAR || level > e1nDetectCpuLevel()) {return false;}
+
+    e1nActive.store(&e1nTables[level], memory_order_release);
+
+    return true;
+}
+
+const char *e1nGetCpuLevelName(const e1nCpuLevel level)
+{
+    switch (level)
+    {
+        case E1N_CPU_SCALAR: return "scalar";
+        case E1N_CPU_SSE4:   return "sse4";
+        case E1N_CPU_AVX2:   return "avx2";
+        case E1N_CPU_AVX512: return "avx512";
+        default:             return "unknown";
+    }
+}
+
+const e1nKernelTable &e1nGetKernels()
+{
+    const e1nKernelTable *table = e1nActive.load(memory_order_acquire);
+
+    if (!table)
+    {
+        call_once(e1nTablesBuilt, BuildTables);
+
+        table = e1nActive.load(memory_order_acquire);
+    }
+
+    return *table;
+}
@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nCpuDispatch.h - Interface definition file for e1nColor's runtime CPU detection & kernel dispatch.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCPUDISPATCH_H
+#define E1NCPUDISPATCH_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define E1N_CPU_X86
+#endif
+
+//====================================================================================================
+//     The batch kernels are built four times over, once per instruction set level (e1nCpuScalar.cpp,
+// e1nCpuSSE4.cpp, e1nCpuAVX2.cpp & e1nCpuAVX512.cpp, each compiled for its level by a target pragma,
+// whatever the rest of the library was compiled for), & the CPU is asked at runtime which ones it can
+// run. Every batch function then goes through a table of function pointers for the best level, so
+// one build runs AVX-512 kernels on the nodes that have it & SSE4 on the ones that don't:
+//
+//     e1nGetKernels().adjust[E1N_ADJUST_SHIFT_HUE](h, l, s, nullptr, count, 0.1f);
+//
+//     The library itself should be compiled for the oldest CPU it has to run on (no -m flags, or
+// -msse4.2); only the four kernel files reach past that, & only once the CPU has been checked. None
+// of them use FMA, so every level gives bit-identical results (moments' sums excepted, since they're
+// added up a lane at a time).
+//
+//     For tests & benchmarks, a level can be forced with e1nSetCpuLevel(), or for a whole run with the
+// environment variable E1N_CPU_LEVEL (scalar, sse4, avx2 or avx512). Neither goes above what the CPU
+// supports. Changing the level while batch work is running is safe, but a job may run partly on each.
+// Non-x86 builds only have the scalar level.
+//====================================================================================================
+
+namespace e1nSimd
+{
+    struct e1nKeyKernel;
+    struct e1nLUT3DKernel;
+    struct e1nPaletteKernel;
+}
+
+enum e1nCpuLevel
+{
+    E1N_CPU_SCALAR,                     // Plain C++; any CPU.
+    E1N_CPU_SSE4,                       // SSE4.1 & 4.2, four lanes.
+    E1N_CPU_AVX2,                       // AVX2, eight lanes; needs the OS to save the 256-bit registers.
+    E1N_CPU_AVX512,                     // AVX-512F, sixteen lanes; needs the OS to save the 512-bit state.
+    E1N_CPU_LEVEL_COUNT
+};
+
+// The three-plane conversions in the table, in place.
+enum e1nConvertKernel
+{
+    E1N_CONVERT_RGB2HLS,
+    E1N_CONVERT_HLS2RGB,
+    E1N_CONVERT_RGB2XYZ,
+    E1N_CONVERT_XYZ2RGB,
+    E1N_CONVERT_RGB2LAB,
+    E1N_CONVERT_LAB2RGB,
+    E1N_CONVERT_RGB2OKLAB,
+    E1N_CONVERT_OKLAB2RGB,
+    E1N_CONVERT_COUNT
+};
+
+//----------------------------------------------------------------------------------------------------
+//     One level's kernels. Each entry is the matching template in e1nColorKernels.h, instantiated for
+// the level's widest register; arrays are indexed by the kernel enums there (e1nAdjustKernel,
+// e1nBlendKernel, e1nTransferKernel) or by e1nConvertKernel.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nKernelTable
+{
+    typedef void (*ConvertFn)(float *c0, float *c1, float *c2, const size_t count);
+    typedef void (*AdjustFn)(float *c0, float *c1, float *c2, const float *m, const size_t count, const float x);
+    typedef void (*BlendFn)(float *b0, float *b1, float *b2, const float *l0, const float *l1, const float *l2,
+                            const float *cov, const size_t count);
+    typedef void (*AnalyzeFn)(const float *c0, const float *c1, const float *c2,
+                              float *h, float *l, float *s, float *min, float *max, float *del, const size_t count);
+    typedef void (*KeyFn)(const float *c0, const float *c1, const float *c2, float *key, const size_t count,
+                          const e1nSimd::e1nKeyKernel &k);
+    typedef void (*LUT3DFn)(float *c0, float *c1, float *c2, const size_t count, const e1nSimd::e1nLUT3DKernel &k);
+    typedef void (*TransferFn)(float *x, const size_t count, const float exponent);
+    typedef void (*Reduce2Fn)(const float *a, const float *b, float *out, const size_t count);
+    typedef void (*Reduce5Fn)(const float *const *r, float *out, const size_t count);
+    typedef void (*ReduceColsFn)(const float *in, float *out, const size_t count);
+    typedef void (*HueToVectorFn)(float *h, float *y, const float *s, const size_t count);
+    typedef void (*VectorToHueFn)(const float *x, const float *y, float *h, const size_t count);
+    typedef void (*QuantizeFn)(const float *x, unsigned char *out, const size_t count);
+    typedef void (*QuantizeOffset8Fn)(const float *x, const float *offset, unsigned char *out, const size_t count);
+    typedef void (*QuantizeOffset16Fn)(const float *x, const float *offset, unsigned short *out, const size_t count);
+    typedef void (*NearestFn)(const float *h, const float *l, const float *s, const size_t count,
+                              const e1nSimd::e1nPaletteKernel &k, float *index, float *dist);
+    typedef void (*MomentsFn)(const float *x, const size_t count, double &sum, double &sumSq, float &lo, float &hi);
+
+    int           level;                // The e1nCpuLevel these were built for.
+
+    ConvertFn     convert[E1N_CONVERT_COUNT];
+    AdjustFn      adjust[7];            // By e1nAdjustKernel.
+    BlendFn       blend[8];             // By e1nBlendKernel.
+    AnalyzeFn     analyze[2];           // [0] without hue, [1] with it.
+    KeyFn         key[2];               // [0] ignoring hue, [1] keying it too.
+    LUT3DFn       lut3D;
+    TransferFn    transfer[5];          // By e1nTransferKernel; the exponent is for E1N_CURVE_POW only.
+
+    Reduce2Fn     reduceRows2;          // The pyramid filters (ReduceRows2() & co.).
+    Reduce5Fn     reduceRows5;
+    ReduceColsFn  reduceCols2;
+    ReduceColsFn  reduceCols5;
+    HueToVectorFn hueToVector;
+    VectorToHueFn vectorToHue;
+
+    QuantizeFn         quantize8;       // Floats to bytes, exactly as e1nFloatToByte().
+    QuantizeOffset8Fn  quantizeOffset8; // The same with a rounding offset per value (e1nPack()'s dithers).
+    QuantizeOffset16Fn quantizeOffset16;
+
+    NearestFn     nearestCentroid;      // e1nPalette's assignment step.
+    MomentsFn     moments;              // e1nColorStats' sums, min & max.
+};
+
+//----------------------------------------------------------------------------------------------------
+// Public functions:
+//----------------------------------------------------------------------------------------------------
+
+// The highest level this CPU (& OS) supports, detected once.
+e1nCpuLevel e1nDetectCpuLevel();
+
+// The level the batch functions are running at.
+e1nCpuLevel e1nGetCpuLevel();
+
+//     Forces a level, for testing & benchmarks. Returns false, leaving the level as it was, if the
+// CPU can't run it.
+bool e1nSetCpuLevel(const e1nCpuLevel level);
+
+// "scalar", "sse4", "avx2" or "avx512".
+const char *e1nGetCpuLevelName(const e1nCpuLevel level);
+
+// The current level's kernels.
+const e1nKernelTable &e1nGetKernels();
+
+#endif     // E1NCPUDISPATCH_H
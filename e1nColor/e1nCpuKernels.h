@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nCpuKernels.h - Kernel table construction shared by e1nColor's per-level kernel files.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NCPUKERNELS_H
+#define E1NCPUKERNELS_H
+
+#pragma once
+
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+
+//====================================================================================================
+//     Only for e1nCpuScalar.cpp, e1nCpuSSE4.cpp, e1nCpuAVX2.cpp & e1nCpuAVX512.cpp, each of which sets
+// E1N_SIMD_LEVEL (& the compiler's target) before including this, so that e1nF32xN & every template
+// instantiated below are that level's. Everything here is static: each file gets its own copy.
+//
+//     The x86 files include the standard headers & <immintrin.h> before they raise the target, so
+// none of the code outside the kernels gets built with instructions the CPU may not have. They also
+// turn fp-contract off: products are never fused into FMAs, so every level matches the others bit
+// for bit & the dispatcher's choice never shows in the output.
+//====================================================================================================
+
+namespace e1nSimd
+{
+inline namespace E1N_SIMD_ISA
+{
+
+// Adapters giving the functor-driven kernels the table's plain signatures.
+template <class Op> static void ConvertKernel(float *c0, float *c1, float *c2, const size_t count)
+{
+    ForEachPixel3<e1nF32xN>(c0, c1, c2, count, Op());
+}
+
+template <int Curve> static void TransferKernel(float *x, const size_t count, const float exponent)
+{
+    ForEachValue<e1nF32xN>(x, count, e1nOpTransfer<Curve>(exponent));
+}
+
+static void LUT3DKernel(float *c0, float *c1, float *c2, const size_t count, const e1nLUT3DKernel &k)
+{
+    ForEachPixel3<e1nF32xN>(c0, c1, c2, count, e1nOpLUT3D(k));
+}
+
+static void FillKernelTable(e1nKernelTable &table, const e1nCpuLevel level)
+{
+    table.level = level;
+
+    table.convert[E1N_CONVERT_RGB2HLS]   = ConvertKernel<e1nOpRGB2HLS>;
+    table.convert[E1N_CONVERT_HLS2RGB]   = ConvertKernel<e1nOpHLS2RGB>;
+    table.convert[E1N_CONVERT_RGB2XYZ]   = ConvertKernel<e1nOpRGB2XYZ>;
+    table.convert[E1N_CONVERT_XYZ2RGB]   = ConvertKernel<e1nOpXYZ2RGB>;
+    table.convert[E1N_CONVERT_RGB2LAB]   = ConvertKernel<e1nOpRGB2Lab>;
+    table.convert[E1N_CONVERT_LAB2RGB]   = ConvertKernel<e1nOpLab2RGB>;
+    table.convert[E1N_CONVERT_RGB2OKLAB] = ConvertKernel<e1nOpRGB2OKLab>;
+    table.convert[E1N_CONVERT_OKLAB2RGB] = ConvertKernel<e1nOpOKLab2RGB>;
+
+    table.adjust[E1N_ADJUST_SET_HUE]     = AdjustPlanes<E1N_ADJUST_SET_HUE,   e1nF32xN>;
+    table.adjust[E1N_ADJUST_SHIFT_HUE]   = AdjustPlanes<E1N_ADJUST_SHIFT_HUE, e1nF32xN>;
+    table.adjust[E1N_ADJUST_SET_SAT]     = AdjustPlanes<E1N_ADJUST_SET_SAT,   e1nF32xN>;
+    table.adjust[E1N_ADJUST_SCALE_SAT]   = AdjustPlanes<E1N_ADJUST_SCALE_SAT, e1nF32xN>;
+    table.adjust[E1N_ADJUST_SET_VAL]     = AdjustPlanes<E1N_ADJUST_SET_VAL,   e1nF32xN>;
+    table.adjust[E1N_ADJUST_SHIFT_VAL]   = AdjustPlanes<E1N_ADJUST_SHIFT_VAL, e1nF32xN>;
+    table.adjust[E1N_ADJUST_SCALE_VAL]   = AdjustPlanes<E1N_ADJUST_SCALE_VAL, e1nF32xN>;
+
+    table.blend[E1N_KERNEL_NORMAL]       = BlendPlanes<E1N_KERNEL_NORMAL,     e1nF32xN>;
+    table.blend[E1N_KERNEL_MULTIPLY]     = BlendPlanes<E1N_KERNEL_MULTIPLY,   e1nF32xN>;
+    table.blend[E1N_KERNEL_SCREEN]       = BlendPlanes<E1N_KERNEL_SCREEN,     e1nF32xN>;
+    table.blend[E1N_KERNEL_OVERLAY]      = BlendPlanes<E1N_KERNEL_OVERLAY,    e1nF32xN>;
+    table.blend[E1N_KERNEL_HUE]          = BlendPlanes<E1N_KERNEL_HUE,        e1nF32xN>;
+    table.blend[E1N_KERNEL_SATURATION]   = BlendPlanes<E1N_KERNEL_SATURATION, e1nF32xN>;
+    table.blend[E1N_KERNEL_LIGHTEN]      = BlendPlanes<E1N_KERNEL_LIGHTEN,    e1nF32xN>;
+    table.blend[E1N_KERNEL_DARKEN]       = BlendPlanes<E1N_KERNEL_DARKEN,     e1nF32xN>;
+
+    table.analyze[0] = AnalyzePlanes<false, e1nF32xN>;
+    table.analyze[1] = AnalyzePlanes<true,  e1nF32xN>;
+    table.key[0]     = KeyPlanes<false, e1nF32xN>;
+    table.key[1]     = KeyPlanes<true,  e1nF32xN>;
+    table.lut3D      = LUT3DKernel;
+
+    table.transfer[E1N_CURVE_SRGB_TO_LINEAR]   = TransferKernel<E1N_CURVE_SRGB_TO_LINEAR>;
+    table.transfer[E1N_CURVE_LINEAR_TO_SRGB]   = TransferKernel<E1N_CURVE_LINEAR_TO_SRGB>;
+    table.transfer[E1N_CURVE_REC709_TO_LINEAR] = TransferKernel<E1N_CURVE_REC709_TO_LINEAR>;
+    table.transfer[E1N_CURVE_LINEAR_TO_REC709] = TransferKernel<E1N_CURVE_LINEAR_TO_REC709>;
+    table.transfer[E1N_CURVE_POW]              = TransferKernel<E1N_CURVE_POW>;
+
+    table.reduceRows2 = ReduceRows2<e1nF32xN>;
+    table.reduceRows5 = ReduceRows5<e1nF32xN>;
+    table.reduceCols2 = ReduceCols2<e1nF32xN>;
+    table.reduceCols5 = ReduceCols5<e1nF32xN>;
+    table.hueToVector = HueToVector<e1nF32xN>;
+    table.vectorToHue = VectorToHue<e1nF32xN>;
+
+    table.quantize8        = QuantizeBytes<e1nF32xN>;
+    table.quantizeOffset8  = QuantizeOffsetBytes<e1nF32xN>;
+    table.quantizeOffset16 = QuantizeOffsetWords<e1nF32xN>;
+
+    table.nearestCentroid = NearestCentroid<e1nF32xN>;
+    table.moments         = Moments<e1nF32xN>;
+}
+
+}   // inline namespace E1N_SIMD_ISA
+}   // namespace e1nSimd
+
+#endif     // E1NCPUKERNELS_H
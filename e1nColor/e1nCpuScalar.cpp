@@ -0,0 +1,23 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nCpuScalar.cpp - e1nColor's batch kernels, built one lane at a time for any CPU.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+
+// Preprocessor directives:
+#if defined(E1NSIMD_H)
+#error "e1nCpuScalar.cpp: e1nSimd.h was included before E1N_SIMD_LEVEL was set."
+#endif
+
+#define E1N_SIMD_LEVEL E1N_SIMD_SCALAR
+
+#include "lib/e1nColor/e1nCpuKernels.h"
+
+void e1nFillKernelsScalar(e1nKernelTable &table)
+{
+    e1nSimd::FillKernelTable(table, E1N_CPU_SCALAR);
+}
@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nIncremental.cpp - Implementation file for e1nColor's dirty-tile tracking & incremental
+//                       recomputation of adjustment chains.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nIncremental.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <cstring>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// e1nDirtyTiles:
+//====================================================================================================
+
+e1nDirtyTiles::e1nDirtyTiles() : tilesAcross(0), tilesDown(0)
+{
+}
+
+void e1nDirtyTiles::Reset(const Size &image, const Size &tiles, const uint8_t initial)
+{
+    CV_Assert(tiles.width > 0 && tiles.height > 0);
+
+    imageSize   = image;
+    tileSize    = tiles;
+    tilesAcross = (image.width  + tiles.width  - 1) / tiles.width;
+    tilesDown   = (image.height + tiles.height - 1) / tiles.height;
+
+    flags.assign((size_t) tilesAcross * tilesDown, initial);
+}
+
+Rect e1nDirtyTiles::TileRect(const int tile) const
+{
+    Rect rect((tile % tilesAcross) * tileSize.width, (tile / tilesAcross) * tileSize.height, tileSize.width, tileSize.height);
+
+    return rect & Rect(0, 0, imageSize.width, imageSize.height);
+}
+
+vector<int> e1nDirtyTiles::Overlapping(const Rect &region) const
+{
+    Rect        clipped = region & Rect(0, 0, imageSize.width, imageSize.height);
+    vector<int> tiles;
+
+    if (clipped.empty()) {return tiles;}
+
+    int x0 = clipped.x / tileSize.width;
+    int y0 = clipped.y / tileSize.height;
+    int x1 = (clipped.x + clipped.width  - 1) / tileSize.width;
+    int y1 = (clipped.y + clipped.height - 1) / tileSize.height;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x) {tiles.push_back(y * tilesAcross + x);}
+    }
+
+    return tiles;
+}
+
+void e1nDirtyTiles::Mark(const Rect &region, const uint8_t bits)
+{
+    for (int tile : Overlapping(region)) {flags[tile] |= bits;}
+}
+
+void e1nDirtyTiles::MarkAll(const uint8_t bits)
+{
+    for (uint8_t &f : flags) {f |= bits;}
+}
+
+void e1nDirtyTiles::Unmark(const int tile, const uint8_t bits)
+{
+    flags[tile] &= (uint8_t) ~bits;
+}
+
+vector<int> e1nDirtyTiles::Collect(const uint8_t bits) const
+{
+    vector<int> tiles;
+
+    for (size_t i = 0; i < flags.size(); ++i)
+    {
+        if (flags[i] & bits) {tiles.push_back((int) i);}
+    }
+
+    return tiles;
+}
+
+int e1nDirtyTiles::Count(const uint8_t bits) const
+{
+    int count = 0;
+
+    for (uint8_t f : flags) {count += (f & bits) != 0;}
+
+    return count;
+}
+
+//====================================================================================================
+// Step kernels:
+//====================================================================================================
+
+static e1nKernelTable::AdjustFn GetAdjustKernel(const e1nPipeline::StepType type)
+{
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    switch (type)
+    {
+        case e1nPipeline::E1N_STEP_SET_HUE:   return kernels.adjust[E1N_ADJUST_SET_HUE];
+        case e1nPipeline::E1N_STEP_SHIFT_HUE: return kernels.adjust[E1N_ADJUST_SHIFT_HUE];
+        case e1nPipeline::E1N_STEP_SET_SAT:   return kernels.adjust[E1N_ADJUST_SET_SAT];
+        case e1nPipeline::E1N_STEP_SCALE_SAT: return kernels.adjust[E1N_ADJUST_SCALE_SAT];
+        case e1nPipeline::E1N_STEP_SET_VAL:   return kernels.adjust[E1N_ADJUST_SET_VAL];
+        case e1nPipeline::E1N_STEP_SHIFT_VAL: return kernels.adjust[E1N_ADJUST_SHIFT_VAL];
+        case e1nPipeline::E1N_STEP_SCALE_VAL: return kernels.adjust[E1N_ADJUST_SCALE_VAL];
+        default:                              break;
+    }
+
+    CV_Error(Error::StsBadArg, "e1nIncrementalChain: steps must be HLS adjustments");
+}
+
+//====================================================================================================
+// Constructors & the chain:
+//====================================================================================================
+
+e1nIncrementalChain::e1nIncrementalChain(const Mat &rgbSource, const int outputType, e1nTileScheduler *tileScheduler)
+{
+    int type = outputType < 0 ? rgbSource.type() : outputType;
+
+    CV_Assert(rgbSource.type() == CV_8UC3 || rgbSource.type() == CV_8UC4 || rgbSource.type() == CV_32FC3 || rgbSource.type() == CV_32FC4);
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_32FC3 || type == CV_32FC4);
+    CV_Assert(CV_MAT_CN(type) == rgbSource.channels());
+
+    source       = rgbSource;
+    scheduler    = tileScheduler ? tileScheduler : &e1nTileScheduler::Default();
+    lastRendered = 0;
+
+    output.create(source.size(), type);
+    hls.Create(source.rows, source.cols, source.channels() == 4);
+    dirty.Reset(source.size(), scheduler->GetTileSize(), E1N_TILE_STALE_HLS | E1N_TILE_STALE_OUTPUT);
+}
+
+int e1nIncrementalChain::AddStep(const e1nPipeline::StepType type, const float amount, const e1nMask &mask)
+{
+    GetAdjustKernel(type);
+    CV_Assert(mask.Empty() || mask.GetSize() == source.size());
+
+    Step step;
+
+    step.type   = type;
+    step.amount = amount;
+    step.mask   = mask;
+
+    step.covers.assign(dirty.TileCount(), 1);
+    UpdateCoverage(step, Rect(0, 0, source.cols, source.rows));
+
+    steps.push_back(step);
+    MarkStep(steps.back(), Rect(0, 0, source.cols, source.rows));
+
+    return (int) steps.size() - 1;
+}
+
+void e1nIncrementalChain::SetAmount(const int step, const float amount)
+{
+    CV_Assert(step >= 0 && step < (int) steps.size());
+
+    if (steps[step].amount == amount) {return;}
+
+    steps[step].amount = amount;
+
+    MarkStep(steps[step], Rect(0, 0, source.cols, source.rows));
+}
+
+void e1nIncrementalChain::SetMask(const int step, const e1nMask &mask)
+{
+    CV_Assert(step >= 0 && step < (int) steps.size());
+    CV_Assert(mask.Empty() || mask.GetSize() == source.size());
+
+    Rect all(0, 0, source.cols, source.rows);
+
+    // Whatever the old mask touched goes back to unmasked, & whatever the new one touches changes.
+    MarkStep(steps[step], all);
+
+    steps[step].mask = mask;
+
+    UpdateCoverage(steps[step], all);
+    MarkStep(steps[step], all);
+}
+
+//====================================================================================================
+// Edits:
+//====================================================================================================
+
+void e1nIncrementalChain::SourceChanged(const Rect &region)
+{
+    dirty.Mark(region, E1N_TILE_STALE_HLS | E1N_TILE_STALE_OUTPUT);
+}
+
+void e1nIncrementalChain::MaskChanged(const int step, const Rect &region)
+{
+    CV_Assert(step >= 0 && step < (int) steps.size());
+
+    // Paint may have cleared the mask as well as set it, so every tile under it changes either way.
+    dirty.Mark(region, E1N_TILE_STALE_OUTPUT);
+
+    UpdateCoverage(steps[step], region);
+}
+
+// Rescans the mask over the tiles a region touches. Without a mask a step covers everything.
+void e1nIncrementalChain::UpdateCoverage(Step &step, const Rect &region)
+{
+    vector<int> tiles = dirty.Overlapping(region);
+
+    if (step.mask.Empty())
+    {
+        for (int tile : tiles) {step.covers[tile] = 1;}
+        return;
+    }
+
+    scheduler->ParallelFor((int) tiles.size(), [&](const int i, const int)
+    {
+        alignas(64) float m[E1N_BATCH_CHUNK];
+
+        Rect    rect   = dirty.TileRect(tiles[i]);
+        uint8_t covers = 0;
+
+        for (int row = rect.y; row < rect.y + rect.height && !covers; ++row)
+        {
+            for (int col = rect.x; col < rect.x + rect.width && !covers; col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, rect.x + rect.width - col);
+
+                step.mask.UnpackRow(row, col, count, m);
+
+                for (int k = 0; k < count; ++k) {covers |= m[k] != 0.0f;}
+            }
+        }
+
+        step.covers[tiles[i]] = covers;
+    });
+}
+
+// Marks the output of the tiles in a region that a step actually touches.
+void e1nIncrementalChain::MarkStep(const Step &step, const Rect &region)
+{
+    for (int tile : dirty.Overlapping(region))
+    {
+        if (step.covers[tile]) {dirty.Mark(dirty.TileRect(tile), E1N_TILE_STALE_OUTPUT);}
+    }
+}
+
+//====================================================================================================
+// Rendering:
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+//     A tile whose source changed is unpacked straight into the cache & converted there. Its output
+// is then rebuilt a chunk at a time from a copy of the cache, skipping steps whose mask misses the
+// tile, & packed with the cached alpha.
+//----------------------------------------------------------------------------------------------------
+
+void e1nIncrementalChain::RenderTile(const int tile, const uint8_t stale)
+{
+    Rect                  rect    = dirty.TileRect(tile);
+    bool                  alpha   = hls.HasAlpha();
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+    alignas(64) float m [E1N_BATCH_CHUNK];
+
+    for (int row = rect.y; row < rect.y + rect.height; ++row)
+    {
+        for (int col = rect.x; col < rect.x + rect.width; col += E1N_BATCH_CHUNK)
+        {
+            int    count = min(E1N_BATCH_CHUNK, rect.x + rect.width - col);
+            float *h     = hls.Row(0, row) + col;
+            float *l     = hls.Row(1, row) + col;
+            float *s     = hls.Row(2, row) + col;
+            float *a     = alpha ? hls.Row(3, row) + col : nullptr;
+
+            if (stale & E1N_TILE_STALE_HLS)
+            {
+                e1nUnpackRow(source, row, col, count, h, l, s, a);
+                kernels.convert[E1N_CONVERT_RGB2HLS](h, l, s, count);
+            }
+
+            memcpy(c0, h, count * sizeof(float));
+            memcpy(c1, l, count * sizeof(float));
+            memcpy(c2, s, count * sizeof(float));
+
+            for (const Step &step : steps)
+            {
+                if (!step.covers[tile]) {continue;}
+
+                if (!step.mask.Empty()) {step.mask.UnpackRow(row, col, count, m);}
+
+                GetAdjustKernel(step.type)(c0, c1, c2, step.mask.Empty() ? nullptr : m, count, step.amount);
+            }
+
+            kernels.convert[E1N_CONVERT_HLS2RGB](c0, c1, c2, count);
+            e1nPackRow(output, row, col, count, c0, c1, c2, a);
+        }
+    }
+}
+
+const Mat &e1nIncrementalChain::Render()
+{
+    vector<int>     tiles = dirty.Collect(E1N_TILE_STALE_HLS | E1N_TILE_STALE_OUTPUT);
+    vector<uint8_t> stale(tiles.size());
+
+    for (size_t i = 0; i < tiles.size(); ++i) {stale[i] = dirty.Get(tiles[i]);}
+
+    uint64_t pixels = 0;
+
+    for (int tile : tiles) {pixels += dirty.TileRect(tile).area();}
+
+    E1N_TRACE_OP("e1nIncrementalChain::Render", pixels, pixels * (source.elemSize() + output.elemSize()));
+
+    scheduler->ParallelFor((int) tiles.size(), [&](const int i, const int)
+    {
+        RenderTile(tiles[i], stale[i]);
+    });
+
+    for (int tile : tiles) {dirty.Unmark(tile, E1N_TILE_STALE_HLS | E1N_TILE_STALE_OUTPUT);}
+
+    lastRendered = (int) tiles.size();
+
+    return output;
+}
+
+int e1nIncrementalChain::GetStaleTileCount() const
+{
+    return dirty.Count(E1N_TILE_STALE_HLS | E1N_TILE_STALE_OUTPUT);
+}
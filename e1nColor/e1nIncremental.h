@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nIncremental.h - Interface definition file for e1nColor's dirty-tile tracking & incremental
+//                    recomputation of adjustment chains.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NINCREMENTAL_H
+#define E1NINCREMENTAL_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nPipeline.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nDirtyTiles - Which tiles of an image are out of date, & with respect to what. Each tile
+// carries a few flag bits; marking a rectangle sets them on every tile it touches, & Collect() lists
+// the tiles that have any of the asked-for bits set, in row-major order.
+//====================================================================================================
+
+class e1nDirtyTiles
+{
+private:
+
+    Size            imageSize;
+    Size            tileSize;
+    int             tilesAcross;
+    int             tilesDown;
+    vector<uint8_t> flags;              // One byte per tile, row-major.
+
+public:
+
+    e1nDirtyTiles();
+
+    // Sizes the grid & sets every tile's flags to initial.
+    void Reset(const Size &image, const Size &tiles, const uint8_t initial);
+
+    int  TileCount() const;
+    Rect TileRect(const int tile) const;                    // Clipped to the image.
+
+    // The tiles a region touches, clipped to the image.
+    vector<int> Overlapping(const Rect &region) const;
+
+    void    Mark(const Rect &region, const uint8_t bits);
+    void    MarkAll(const uint8_t bits);
+    void    Unmark(const int tile, const uint8_t bits);
+    uint8_t Get(const int tile) const;
+
+    vector<int> Collect(const uint8_t bits) const;
+    int         Count(const uint8_t bits) const;
+};
+
+//====================================================================================================
+//     e1nIncrementalChain - An HLS adjustment chain kept live over one image, for interactive work.
+// The image's HLS form is cached, tile by tile, along with the RGB output; moving a slider or painting
+// into a mask only marks the tiles that change, & Render() recomputes just those:
+//
+//      Source pixels edited     - the tiles' HLS cache is rebuilt, then their output.
+//      Step amount changed      - the output of every tile the step's mask touches (all of them
+//                                 without a mask), straight from the cache.
+//      Mask painted or replaced - the output of the tiles under the painted area.
+//
+// so an edit costs time in proportion to the area it changes, not the size of the image.
+//
+//     Steps are the e1nPipeline adjustments (E1N_STEP_SET_HUE to E1N_STEP_SCALE_VAL) with an
+// optional e1nMask each, run in order on the cached HLS & converted back to RGB. The source isn't
+// copied: the chain holds a Mat header on it, & whoever edits the source or a mask in place says where
+// through SourceChanged() / MaskChanged(). The cache costs 12 bytes per pixel (16 with alpha) on top of
+// the output.
+//
+//     Supported types: CV_8UC3/4 & CV_32FC3/4 in & out, alpha passed through. A null scheduler means
+// e1nTileScheduler::Default(); tiles are its tile size.
+//====================================================================================================
+
+class e1nIncrementalChain
+{
+private:
+
+    // Tile flag bits.
+    enum
+    {
+        E1N_TILE_STALE_HLS    = 1,      // The HLS cache no longer matches the source.
+        E1N_TILE_STALE_OUTPUT = 2       // The output no longer matches the cache & chain.
+    };
+
+    struct Step
+    {
+        e1nPipeline::StepType type;
+        float                 amount;
+        e1nMask               mask;
+        vector<uint8_t>       covers;   // Per tile: whether the mask is non-zero anywhere in it.
+    };
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    Mat               source;           // The RGB source (a header, sharing the caller's pixels).
+    Mat               output;           // The rendered RGB result.
+    e1nColorPlanes    hls;              // The source in HLS, with its alpha.
+    vector<Step>      steps;            // The chain, in order.
+    e1nDirtyTiles     dirty;
+    e1nTileScheduler *scheduler;
+    int               lastRendered;     // Tiles recomputed by the last Render().
+
+    void UpdateCoverage(Step &step, const Rect &region);
+    void MarkStep(const Step &step, const Rect &region);
+    void RenderTile(const int tile, const uint8_t stale);
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    // The output is created as outputType (default: the source's type) with the source's channels.
+    e1nIncrementalChain(const Mat &rgbSource, const int outputType = -1, e1nTileScheduler *tileScheduler = nullptr);
+
+    //----------------------------------------------------------------------------------------------------
+    // The chain. Step indices are in the order steps were added.
+    //----------------------------------------------------------------------------------------------------
+
+    int  AddStep(const e1nPipeline::StepType type, const float amount, const e1nMask &mask = e1nMask());
+    int  StepCount() const;
+
+    void SetAmount(const int step, const float amount);
+    void SetMask  (const int step, const e1nMask &mask);
+
+    //----------------------------------------------------------------------------------------------------
+    // Edits made in place, outside the chain:
+    //----------------------------------------------------------------------------------------------------
+
+    void SourceChanged(const Rect &region);
+    void MaskChanged(const int step, const Rect &region);
+
+    //----------------------------------------------------------------------------------------------------
+    // Rendering:
+    //----------------------------------------------------------------------------------------------------
+
+    // Brings every stale tile up to date & returns the output.
+    const Mat &Render();
+
+    const Mat &GetOutput() const;                           // As of the last Render().
+    int        GetStaleTileCount() const;                   // Tiles the next Render() will recompute.
+    int        GetLastRenderTileCount() const;
+    const e1nDirtyTiles &GetDirtyTiles() const;
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline int     e1nDirtyTiles::TileCount() const          {return (int) flags.size();}
+inline uint8_t e1nDirtyTiles::Get(const int tile) const  {return flags[tile];}
+
+inline int                  e1nIncrementalChain::StepCount() const              {return (int) steps.size();}
+inline const Mat           &e1nIncrementalChain::GetOutput() const              {return output;}
+inline int                  e1nIncrementalChain::GetLastRenderTileCount() const {return lastRendered;}
+inline const e1nDirtyTiles &e1nIncrementalChain::GetDirtyTiles() const          {return dirty;}
+
+#endif     // E1NINCREMENTAL_H
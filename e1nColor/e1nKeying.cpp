@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nKeying.cpp - Implementation file for e1nColor's HLS range keying (selection masks).
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nKeying.h"
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Setting up:
+//====================================================================================================
+
+// Reciprocal falloff width; a hard edge gets one so large any distance past the range scores 0.
+static float InverseSoftness(const float specific, const float shared)
+{
+    float softness = specific >= 0.0f ? specific : shared;
+
+    return softness > 0.0f ? 1.0f / softness : 1.0e30f;
+}
+
+// Turns a range into kernel constants. Returns whether the hue part is needed at all.
+static bool MakeKernel(const e1nKeyRange &range, e1nKeyKernel &k)
+{
+    CV_Assert(range.satLow <= range.satHigh && range.valLow <= range.valHigh);
+
+    float span = range.hueHigh - range.hueLow;
+    bool  hue  = span < 1.0f;
+
+    // A low end above the high end wraps through red.
+    if (span < 0.0f) {span += 1.0f;}
+
+    k.hueCenter  = range.hueLow + span * 0.5f;
+    k.hueHalf    = span * 0.5f;
+    k.invHueSoft = InverseSoftness(range.hueSoftness, range.softness);
+    k.satLow     = range.satLow;
+    k.satHigh    = range.satHigh;
+    k.invSatSoft = InverseSoftness(range.satSoftness, range.softness);
+    k.valLow     = range.valLow;
+    k.valHigh    = range.valHigh;
+    k.invValSoft = InverseSoftness(range.valSoftness, range.softness);
+    k.invert     = range.invert;
+
+    return hue;
+}
+
+//====================================================================================================
+// Driver:
+//====================================================================================================
+//     Rows are independent, so they're what gets spread across the scheduler; that also keeps a
+// packed-bit row's bytes on one thread. Each row goes a chunk at a time: source() points c at the
+// chunk's r, g & b (unpacking into the scratch runs it's handed if it has to), the key is computed
+// into a float run, & sink() writes it out.
+//----------------------------------------------------------------------------------------------------
+
+template <class Source, class Sink> static void KeyImage(const Size size, const e1nKeyRange &range, e1nTileScheduler *scheduler,
+                                                          const Source &source, const Sink &sink)
+{
+    e1nKeyKernel           k;
+    bool                   hue  = MakeKernel(range, k);
+    e1nKernelTable::KeyFn  key  = e1nGetKernels().key[hue ? 1 : 0];
+    e1nTileScheduler      &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+
+    pool.ParallelFor(size.height, [&](const int row, const int)
+    {
+        alignas(64) float rgb[3][E1N_BATCH_CHUNK];
+        alignas(64) float values[E1N_BATCH_CHUNK];
+
+        for (int col = 0; col < size.width; col += E1N_BATCH_CHUNK)
+        {
+            int          count = min(E1N_BATCH_CHUNK, size.width - col);
+            const float *c[3]  = {rgb[0], rgb[1], rgb[2]};
+
+            source(row, col, count, c);
+
+            key(c[0], c[1], c[2], values, count, k);
+            sink(row, col, count, values);
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+// Sources & sinks:
+//----------------------------------------------------------------------------------------------------
+
+struct e1nMatSource
+{
+    const Mat &image;
+
+    void operator ()(const int row, const int col, const int count, const float **c) const
+    {
+        e1nUnpackRow(image, row, col, count, (float *) c[0], (float *) c[1], (float *) c[2]);
+    }
+};
+
+struct e1nPlanesSource
+{
+    const e1nColorPlanes &planes;
+
+    void operator ()(const int row, const int col, const int, const float **c) const
+    {
+        for (int k = 0; k < 3; ++k) {c[k] = planes.Row(k, row) + col;}
+    }
+};
+
+struct e1nByteSink
+{
+    Mat &mask;
+
+    void operator ()(const int row, const int col, const int count, const float *key) const
+    {
+        e1nGetKernels().quantize8(key, mask.ptr<unsigned char>(row) + col, count);
+    }
+};
+
+// Chunks start on multiples of E1N_BATCH_CHUNK, so always on a byte boundary.
+struct e1nBitSink
+{
+    Mat &bits;
+
+    void operator ()(const int row, const int col, const int count, const float *key) const
+    {
+        unsigned char *p = bits.ptr<unsigned char>(row) + col / 8;
+
+        for (int i = 0; i < count; i += 8)
+        {
+            int           n    = min(8, count - i);
+            unsigned char byte = 0;
+
+            for (int j = 0; j < n; ++j) {byte |= (unsigned char) ((key[i + j] >= 0.5f) << j);}
+
+            p[i / 8] = byte;
+        }
+    }
+};
+
+static void CheckImage(const Mat &rgbImage)
+{
+    int type = rgbImage.type();
+
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_32FC3 || type == CV_32FC4);
+}
+
+//====================================================================================================
+// Public functions:
+//====================================================================================================
+
+void e1nKeyHLS(const Mat &rgbImage, Mat &mask, const e1nKeyRange &range, e1nTileScheduler *scheduler)
+{
+    CheckImage(rgbImage);
+
+    Mat input = rgbImage;               // Held in case mask shares its buffer.
+
+    E1N_TRACE_OP("e1nKeyHLS", input.total(), input.total() * (input.elemSize() + 1));
+
+    mask.create(input.size(), CV_8UC1);
+
+    KeyImage(input.size(), range, scheduler, e1nMatSource{input}, e1nByteSink{mask});
+}
+
+void e1nKeyHLS(const e1nColorPlanes &rgbPlanes, Mat &mask, const e1nKeyRange &range, e1nTileScheduler *scheduler)
+{
+    Size size(rgbPlanes.Cols(), rgbPlanes.Rows());
+
+    E1N_TRACE_OP("e1nKeyHLS", size.area(), (uint64_t) size.area() * 13);
+
+    mask.create(size, CV_8UC1);
+
+    KeyImage(size, range, scheduler, e1nPlanesSource{rgbPlanes}, e1nByteSink{mask});
+}
+
+e1nMask e1nKeyHLSBits(const Mat &rgbImage, Mat &bits, const e1nKeyRange &range, e1nTileScheduler *scheduler)
+{
+    CheckImage(rgbImage);
+
+    Mat input = rgbImage;
+
+    E1N_TRACE_OP("e1nKeyHLSBits", input.total(), input.total() * input.elemSize() + input.total() / 8);
+
+    bits.create(input.rows, (input.cols + 7) / 8, CV_8UC1);
+
+    KeyImage(input.size(), range, scheduler, e1nMatSource{input}, e1nBitSink{bits});
+
+    return e1nMask(bits, input.cols);
+}
+
+e1nMask e1nKeyHLSBits(const e1nColorPlanes &rgbPlanes, Mat &bits, const e1nKeyRange &range, e1nTileScheduler *scheduler)
+{
+    Size size(rgbPlanes.Cols(), rgbPlanes.Rows());
+
+    E1N_TRACE_OP("e1nKeyHLSBits", size.area(), (uint64_t) size.area() * 12 + size.area() / 8);
+
+    bits.create(size.height, (size.width + 7) / 8, CV_8UC1);
+
+    KeyImage(size, range, scheduler, e1nPlanesSource{rgbPlanes}, e1nBitSink{bits});
+
+    return e1nMask(bits, size.width);
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nKeying.h - Interface definition file for e1nColor's HLS range keying (selection masks).
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NKEYING_H
+#define E1NKEYING_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Keying selects pixels by color: "hue 0.05-0.12 & saturation above 0.3" becomes a mask that
+// e1nMask takes as it is, so it feeds straight into the masked batch functions:
+//
+//     e1nKeyRange skin;
+//
+//     skin.hueLow = 0.05f; skin.hueHigh = 0.12f; skin.satLow = 0.3f; skin.softness = 0.02f;
+//
+//     e1nKeyHLS(rgbImage, mask, skin);
+//     e1nConvertRGB2HLS(rgbImage);
+//     e1nScaleSat(rgbImage, 0.8f, mask);
+//
+//     The key is computed from RGB in one SIMD pass with the same HLS math as e1nColor (saturation is
+// max - min, value is lightness), without an HLS image in between. Each component scores 1 inside its
+// range & falls smoothly to 0 over its softness beyond either end; the key is the product of the
+// three.
+//
+//     Hue is 0-1 around the wheel. A range whose low end is above its high end wraps through red,
+// so 0.95-0.05 takes in the reds either side of 0, & softness wraps with it. Grays have no real
+// hue (they come out as 0, red), so pair a hue range with a saturation floor.
+//====================================================================================================
+
+struct e1nKeyRange
+{
+    float hueLow, hueHigh;              // 0-1; the full wheel by default.
+    float satLow, satHigh;
+    float valLow, valHigh;
+
+    float softness;                     // Falloff width beyond each end, for every component.
+    float hueSoftness;                  // Per-component falloff, used instead when non-negative.
+    float satSoftness;
+    float valSoftness;
+
+    bool invert;                        // Select everything outside the range instead.
+
+    e1nKeyRange() : hueLow(0.0f), hueHigh(1.0f), satLow(0.0f), satHigh(1.0f), valLow(0.0f), valHigh(1.0f),
+                    softness(0.0f), hueSoftness(-1.0f), satSoftness(-1.0f), valSoftness(-1.0f), invert(false) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+//     8-bit keys: mask is (re)created as a CV_8UC1 (0-255) the size of the image. Images may be
+// CV_8UC3/4 or CV_32FC3/4 RGB. Rows are spread across the tile scheduler; a null scheduler means
+// e1nTileScheduler::Default().
+//----------------------------------------------------------------------------------------------------
+
+void e1nKeyHLS(const Mat &rgbImage, Mat &mask, const e1nKeyRange &range, e1nTileScheduler *scheduler = nullptr);
+void e1nKeyHLS(const e1nColorPlanes &rgbPlanes, Mat &mask, const e1nKeyRange &range, e1nTileScheduler *scheduler = nullptr);
+
+//----------------------------------------------------------------------------------------------------
+//     1-bit keys: a pixel is in where its key reaches 0.5, so softness only moves the edge. bits is
+// (re)created as packed CV_8UC1 rows of (cols + 7) / 8 bytes, an eighth the size of an 8-bit key; the
+// e1nMask returned wraps it (see e1nMask), & stays valid as long as bits isn't reallocated.
+//----------------------------------------------------------------------------------------------------
+
+e1nMask e1nKeyHLSBits(const Mat &rgbImage, Mat &bits, const e1nKeyRange &range, e1nTileScheduler *scheduler = nullptr);
+e1nMask e1nKeyHLSBits(const e1nColorPlanes &rgbPlanes, Mat &bits, const e1nKeyRange &range, e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NKEYING_H
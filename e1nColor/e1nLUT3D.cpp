@@ -0,0 +1,428 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nLUT3D.cpp - Implementation file for e1nColor's baked 3D lookup tables.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nLUT3D.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Constructors & building the table:
+//====================================================================================================
+
+e1nLUT3D::e1nLUT3D() : size(0)
+{
+    SetDomain(0.0f, 1.0f);
+}
+
+e1nLUT3D::e1nLUT3D(const int lutSize) : size(0)
+{
+    SetDomain(0.0f, 1.0f);
+    Reset(lutSize);
+}
+
+void e1nLUT3D::SetDomain(const float minValue, const float maxValue)
+{
+    float minRGB[3] = {minValue, minValue, minValue};
+    float maxRGB[3] = {maxValue, maxValue, maxValue};
+
+    SetDomain(minRGB, maxRGB);
+}
+
+void e1nLUT3D::SetDomain(const float *minRGB, const float *maxRGB)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!(maxRGB[i] > minRGB[i])) {CV_Error(Error::StsBadArg, "e1nLUT3D: domain is empty");}
+
+        domainMin[i] = minRGB[i];
+        domainMax[i] = maxRGB[i];
+    }
+}
+
+// The input value of lattice point i along a channel.
+static float LatticeValue(const int i, const int size, const float lo, const float hi)
+{
+    return lo + (hi - lo) * ((float) i / (float) (size - 1));
+}
+
+void e1nLUT3D::Reset(const int lutSize)
+{
+    CV_Assert(lutSize >= E1N_LUT3D_MIN_SIZE && lutSize <= E1N_LUT3D_MAX_SIZE);
+
+    size_t points = (size_t) lutSize * lutSize * lutSize;
+
+    size = lutSize;
+    table.resize(points * 3);
+
+    for (size_t i = 0; i < points; ++i)
+    {
+        table[i]              = LatticeValue((int) (i % size),        size, domainMin[0], domainMax[0]);
+        table[points + i]     = LatticeValue((int) (i / size % size), size, domainMin[1], domainMax[1]);
+        table[points * 2 + i] = LatticeValue((int) (i / size / size), size, domainMin[2], domainMax[2]);
+    }
+}
+
+//     Every lattice row (a run of red at one green & blue) is one short planar run through the chain,
+// at most 256 points, so it's a single batch chunk however large the table. The new table is built
+// aside & only swapped in once every run is done, so a chain that throws leaves the LUT as it was.
+void e1nLUT3D::Bake(const e1nPipeline &chain, const int lutSize, e1nTileScheduler *scheduler)
+{
+    CV_Assert(lutSize >= E1N_LUT3D_MIN_SIZE && lutSize <= E1N_LUT3D_MAX_SIZE);
+
+    E1N_TRACE_OP("e1nLUT3D::Bake", (uint64_t) lutSize * lutSize * lutSize, (uint64_t) lutSize * lutSize * lutSize * 12);
+
+    size_t            points = (size_t) lutSize * lutSize * lutSize;
+    e1nTileScheduler &pool   = scheduler ? *scheduler : e1nTileScheduler::Default();
+    vector<float>     baked(points * 3);
+
+    pool.ParallelFor(lutSize * lutSize, [&](const int run, const int)
+    {
+        float *c0 = &baked[(size_t) run * lutSize];
+        float *c1 = c0 + points;
+        float *c2 = c1 + points;
+
+        float g = LatticeValue(run % lutSize, lutSize, domainMin[1], domainMax[1]);
+        float b = LatticeValue(run / lutSize, lutSize, domainMin[2], domainMax[2]);
+
+        for (int i = 0; i < lutSize; ++i)
+        {
+            c0[i] = LatticeValue(i, lutSize, domainMin[0], domainMax[0]);
+            c1[i] = g;
+            c2[i] = b;
+        }
+
+        chain.RunPlanes(c0, c1, c2, lutSize);
+    });
+
+    size = lutSize;
+    table.swap(baked);
+}
+
+void e1nLUT3D::SetEntry(const int r, const int g, const int b, const float *rgb)
+{
+    CV_Assert(r >= 0 && r < size && g >= 0 && g < size && b >= 0 && b < size);
+
+    size_t points = (size_t) size * size * size;
+    size_t i      = ((size_t) b * size + g) * size + r;
+
+    table[i]              = rgb[0];
+    table[points + i]     = rgb[1];
+    table[points * 2 + i] = rgb[2];
+}
+
+void e1nLUT3D::GetEntry(const int r, const int g, const int b, float *rgb) const
+{
+    CV_Assert(r >= 0 && r < size && g >= 0 && g < size && b >= 0 && b < size);
+
+    size_t points = (size_t) size * size * size;
+    size_t i      = ((size_t) b * size + g) * size + r;
+
+    rgb[0] = table[i];
+    rgb[1] = table[points + i];
+    rgb[2] = table[points * 2 + i];
+}
+
+const float *e1nLUT3D::GetPlane(const int channel) const
+{
+    CV_Assert(!Empty() && channel >= 0 && channel < 3);
+
+    return &table[(size_t) channel * size * size * size];
+}
+
+//====================================================================================================
+// .cube files:
+//====================================================================================================
+
+// Reads count floats from text, returning whether there were that many.
+static bool ParseFloats(const char *text, float *values, const int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        char *end;
+
+        values[i] = strtof(text, &end);
+
+        if (end == text) {return false;}
+
+        text = end;
+    }
+
+    return true;
+}
+
+void e1nLUT3D::Read(istream &is)
+{
+    int           lutSize = 0;
+    size_t        points  = 0;
+    size_t        entries = 0;
+    float         lo[3]   = {0.0f, 0.0f, 0.0f};
+    float         hi[3]   = {1.0f, 1.0f, 1.0f};
+    string        name;
+    vector<float> values;
+    string        line;
+
+    while (getline(is, line))
+    {
+        size_t start = line.find_first_not_of(" \t\r");
+
+        if (start == string::npos || line[start] == '#') {continue;}
+
+        const char *text = line.c_str() + start;
+        char        c    = *text;
+
+        // Lattice points.
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.')
+        {
+            float rgb[3];
+
+            if (lutSize == 0)         {CV_Error(Error::StsParseError, "e1nLUT3D: .cube data before LUT_3D_SIZE");}
+            if (entries == points)    {CV_Error(Error::StsParseError, "e1nLUT3D: .cube has too many entries");}
+            if (!ParseFloats(text, rgb, 3)) {CV_Error(Error::StsParseError, "e1nLUT3D: bad .cube entry: " + line);}
+
+            values[entries]              = rgb[0];
+            values[points + entries]     = rgb[1];
+            values[points * 2 + entries] = rgb[2];
+            ++entries;
+            continue;
+        }
+
+        // Keywords.
+        size_t split   = line.find_first_of(" \t", start);
+        string keyword = line.substr(start, split == string::npos ? string::npos : split - start);
+        string rest    = split == string::npos ? string() : line.substr(split);
+
+        if (keyword == "TITLE")
+        {
+            size_t first = rest.find('"');
+            size_t last  = rest.rfind('"');
+
+            name = first != string::npos && last > first ? rest.substr(first + 1, last - first - 1) : rest;
+        }
+        else if (keyword == "LUT_3D_SIZE")
+        {
+            lutSize = atoi(rest.c_str());
+
+            if (lutSize < E1N_LUT3D_MIN_SIZE || lutSize > E1N_LUT3D_MAX_SIZE || entries > 0)
+            {
+                CV_Error(Error::StsParseError, "e1nLUT3D: bad .cube LUT_3D_SIZE: " + line);
+            }
+
+            points = (size_t) lutSize * lutSize * lutSize;
+            values.resize(points * 3);
+        }
+        else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX")
+        {
+            if (!ParseFloats(rest.c_str(), keyword == "DOMAIN_MIN" ? lo : hi, 3))
+            {
+                CV_Error(Error::StsParseError, "e1nLUT3D: bad .cube domain: " + line);
+            }
+        }
+        else if (keyword == "LUT_3D_INPUT_RANGE")
+        {
+            float range[2];
+
+            if (!ParseFloats(rest.c_str(), range, 2)) {CV_Error(Error::StsParseError, "e1nLUT3D: bad .cube input range: " + line);}
+
+            for (int i = 0; i < 3; ++i) {lo[i] = range[0]; hi[i] = range[1];}
+        }
+        else if (keyword == "LUT_1D_SIZE")
+        {
+            CV_Error(Error::StsUnsupportedFormat, "e1nLUT3D: 1D .cube LUTs aren't supported");
+        }
+
+        // Anything else is an application's own keyword, which the format says to skip.
+    }
+
+    if (lutSize == 0)       {CV_Error(Error::StsParseError, "e1nLUT3D: .cube has no LUT_3D_SIZE");}
+    if (entries != points)  {CV_Error(Error::StsParseError, "e1nLUT3D: .cube has too few entries");}
+
+    // Only take it all on once the whole file has made sense.
+    SetDomain(lo, hi);
+
+    size  = lutSize;
+    title = name;
+    table.swap(values);
+}
+
+void e1nLUT3D::Write(ostream &os) const
+{
+    CV_Assert(!Empty());
+
+    size_t points = (size_t) size * size * size;
+    char   line[128];
+
+    if (!title.empty()) {os << "TITLE \"" << title << "\"\n";}
+
+    os << "LUT_3D_SIZE " << size << "\n";
+
+    bool unit = true;
+
+    for (int i = 0; i < 3; ++i) {unit = unit && domainMin[i] == 0.0f && domainMax[i] == 1.0f;}
+
+    if (!unit)
+    {
+        snprintf(line, sizeof(line), "DOMAIN_MIN %.6f %.6f %.6f\n", domainMin[0], domainMin[1], domainMin[2]);
+        os << line;
+        snprintf(line, sizeof(line), "DOMAIN_MAX %.6f %.6f %.6f\n", domainMax[0], domainMax[1], domainMax[2]);
+        os << line;
+    }
+
+    os << "\n";
+
+    for (size_t i = 0; i < points; ++i)
+    {
+        int length = snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", table[i], table[points + i], table[points * 2 + i]);
+
+        os.write(line, length);
+    }
+}
+
+void e1nLUT3D::Load(const string &path)
+{
+    ifstream file(path.c_str());
+
+    if (!file) {CV_Error(Error::StsError, "e1nLUT3D: can't open " + path);}
+
+    Read(file);
+}
+
+bool e1nLUT3D::Save(const string &path) const
+{
+    ofstream file(path.c_str());
+
+    if (!file) {return false;}
+
+    Write(file);
+
+    return (bool) file;
+}
+
+//====================================================================================================
+// Applying the table:
+//====================================================================================================
+
+static void MakeKernel(const e1nLUT3D &lut, e1nLUT3DKernel &k)
+{
+    CV_Assert(!lut.Empty());
+
+    float size = (float) lut.GetSize();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        k.plane[i]  = lut.GetPlane(i);
+        k.scale[i]  = (size - 1.0f) / (lut.GetDomainMax()[i] - lut.GetDomainMin()[i]);
+        k.offset[i] = -lut.GetDomainMin()[i] * k.scale[i];
+    }
+
+    k.last      = size - 1.0f;
+    k.stride[0] = 1.0f;
+    k.stride[1] = size;
+    k.stride[2] = size * size;
+}
+
+void e1nLUT3D::ApplyPlanes(float *c0, float *c1, float *c2, const size_t count) const
+{
+    e1nLUT3DKernel k;
+
+    MakeKernel(*this, k);
+
+    e1nGetKernels().lut3D(c0, c1, c2, count, k);
+}
+
+// Runs one tile of an interleaved image, a chunk of a row at a time.
+void e1nLUT3D::RunRows(const Mat &src, Mat &dst, const Rect &tile) const
+{
+    bool                    alpha  = dst.channels() == 4;
+    e1nKernelTable::LUT3DFn lookup = e1nGetKernels().lut3D;
+    e1nLUT3DKernel          k;
+
+    MakeKernel(*this, k);
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+    alignas(64) float c3[E1N_BATCH_CHUNK];
+
+    for (int row = tile.y; row < tile.y + tile.height; ++row)
+    {
+        for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+            e1nUnpackRow(src, row, col, count, c0, c1, c2, alpha ? c3 : nullptr);
+            lookup(c0, c1, c2, count, k);
+            e1nPackRow(dst, row, col, count, c0, c1, c2, alpha ? c3 : nullptr);
+        }
+    }
+}
+
+void e1nLUT3D::RunRows(e1nColorPlanes &planes, const Rect &tile) const
+{
+    e1nKernelTable::LUT3DFn lookup = e1nGetKernels().lut3D;
+    e1nLUT3DKernel          k;
+
+    MakeKernel(*this, k);
+
+    for (int row = tile.y; row < tile.y + tile.height; ++row)
+    {
+        lookup(planes.Row(0, row) + tile.x, planes.Row(1, row) + tile.x, planes.Row(2, row) + tile.x, tile.width, k);
+    }
+}
+
+void e1nLUT3D::Apply(Mat &image, e1nTileScheduler *scheduler) const
+{
+    Apply(image, image, -1, scheduler);
+}
+
+void e1nLUT3D::Apply(const Mat &src, Mat &dst, const int dstType, e1nTileScheduler *scheduler) const
+{
+    CV_Assert(!Empty());
+    CV_Assert(src.type() == CV_8UC3 || src.type() == CV_8UC4 || src.type() == CV_32FC3 || src.type() == CV_32FC4);
+
+    int type = dstType < 0 ? src.type() : dstType;
+
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_32FC3 || type == CV_32FC4);
+
+    // Hold on to the source in case dst is src & create() is about to reallocate it.
+    Mat               input = src;
+    e1nTileScheduler &pool  = scheduler ? *scheduler : e1nTileScheduler::Default();
+
+    dst.create(input.size(), type);
+
+    E1N_TRACE_OP("e1nLUT3D::Apply", input.total(), input.total() * (input.elemSize() + dst.elemSize()));
+
+    pool.ForEachTile(input.size(), [&](const Rect &tile, const int)
+    {
+        RunRows(input, dst, tile);
+    });
+}
+
+void e1nLUT3D::Apply(e1nColorPlanes &planes, e1nTileScheduler *scheduler) const
+{
+    CV_Assert(!Empty());
+
+    e1nTileScheduler &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+
+    E1N_TRACE_OP("e1nLUT3D::Apply", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    pool.ForEachTile(Size(planes.Cols(), planes.Rows()), [&](const Rect &tile, const int)
+    {
+        RunRows(planes, tile);
+    });
+}
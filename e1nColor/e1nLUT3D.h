@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nLUT3D.h - Interface definition file for e1nColor's baked 3D lookup tables.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NLUT3D_H
+#define E1NLUT3D_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nPipeline.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nLUT3D - A color transform sampled on a size x size x size lattice over RGB. Once a grade has
+// been settled, baking its pipeline into a LUT turns the whole chain (RGB -> HLS, any number of
+// adjustments, HLS -> RGB) into one lookup per pixel, so applying it costs the same however long the
+// chain was:
+//
+//      e1nPipeline grade;
+//      grade.ConvertRGB2HLS().ShiftHue(-0.02f).ScaleSat(1.2f).ShiftVal(0.05f).ConvertHLS2RGB();
+//
+//      e1nLUT3D lut;
+//      lut.Bake(grade, 33);
+//      lut.Save("grade.cube");
+//
+//      for (...) {lut.Apply(frame);}
+//
+//     Between lattice points the LUT interpolates tetrahedrally (four lattice points per pixel,
+// against trilinear's eight), in SIMD across as many pixels as the register holds, with images split
+// into tiles across the tile scheduler's threads. Inputs outside the domain are clamped to it. How
+// closely it follows the chain depends on the size: 33 is the usual choice, 65 for grades with sharp
+// turns. Hue rotations that move colors across the red/magenta seam are the hardest case. The lookups
+// are gathers, so a LUT only overtakes a fused e1nPipeline once the chain is more than a few steps long.
+//
+//     Files are the .cube format (Adobe / Resolve): TITLE, LUT_3D_SIZE, DOMAIN_MIN & DOMAIN_MAX (or
+// LUT_3D_INPUT_RANGE), # comments, then one "r g b" line per lattice point with red varying fastest.
+// 1D LUTs aren't supported.
+//====================================================================================================
+
+class e1nLUT3D
+{
+private:
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    int           size;                 // Lattice points along each axis; 0 when empty.
+    float         domainMin[3];         // The input range the lattice spans, per channel.
+    float         domainMax[3];
+    string        title;
+    vector<float> table;                // Three planes of size^3 outputs (r, g, b), red fastest.
+
+    void RunRows(const Mat &src, Mat &dst, const Rect &tile) const;
+    void RunRows(e1nColorPlanes &planes, const Rect &tile) const;
+
+public:
+
+    // The lattice sizes allowed; 256^3 is as far as a float indexes exactly.
+    enum
+    {
+        E1N_LUT3D_MIN_SIZE = 2,
+        E1N_LUT3D_MAX_SIZE = 256
+    };
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nLUT3D();
+    e1nLUT3D(const int lutSize);        // The identity, at this size.
+
+    //----------------------------------------------------------------------------------------------------
+    // Building the table:
+    //----------------------------------------------------------------------------------------------------
+
+    // Resizes to the identity over the current domain.
+    void Reset(const int lutSize);
+
+    //     Samples a chain at every lattice point of the current domain (0-1 unless SetDomain() says
+    // otherwise), the lattice's rows spread across the scheduler. The chain runs exactly as it would
+    // on an image, so it should take RGB in & give RGB out.
+    void Bake(const e1nPipeline &chain, const int lutSize = 33, e1nTileScheduler *scheduler = nullptr);
+
+    void SetDomain(const float minValue, const float maxValue);
+    void SetDomain(const float *minRGB, const float *maxRGB);
+    void SetTitle(const string &newTitle);
+
+    // The output at one lattice point; (r, g, b) are lattice coordinates.
+    void SetEntry(const int r, const int g, const int b, const float *rgb);
+    void GetEntry(const int r, const int g, const int b, float *rgb) const;
+
+    bool          Empty() const;
+    int           GetSize() const;
+    const float  *GetDomainMin() const;
+    const float  *GetDomainMax() const;
+    const string &GetTitle() const;
+    const float  *GetPlane(const int channel) const;        // size^3 floats, red fastest.
+
+    //----------------------------------------------------------------------------------------------------
+    // .cube files. Load() raises a cv::Exception on a file it can't read or make sense of; Save()
+    // returns whether the file was written.
+    //----------------------------------------------------------------------------------------------------
+
+    void Load(const string &path);
+    bool Save(const string &path) const;
+
+    void Read(istream &is);
+    void Write(ostream &os) const;
+
+    //----------------------------------------------------------------------------------------------------
+    //     Applying the table. Mats may be CV_8UC3/4 or CV_32FC3/4 RGB; the two-image form creates dst
+    // as src's size in dstType (default: src's type), & src & dst may be the same Mat. Alpha is passed
+    // straight through. A null scheduler means e1nTileScheduler::Default().
+    //----------------------------------------------------------------------------------------------------
+
+    void Apply(Mat &image, e1nTileScheduler *scheduler = nullptr) const;
+    void Apply(const Mat &src, Mat &dst, const int dstType = -1, e1nTileScheduler *scheduler = nullptr) const;
+    void Apply(e1nColorPlanes &planes, e1nTileScheduler *scheduler = nullptr) const;
+
+    // Runs the table over count pixels of three float planes, in place, on the calling thread.
+    void ApplyPlanes(float *c0, float *c1, float *c2, const size_t count) const;
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline bool          e1nLUT3D::Empty() const        {return size == 0;}
+inline int           e1nLUT3D::GetSize() const      {return size;}
+inline const float  *e1nLUT3D::GetDomainMin() const {return domainMin;}
+inline const float  *e1nLUT3D::GetDomainMax() const {return domainMax;}
+inline const string &e1nLUT3D::GetTitle() const     {return title;}
+
+inline void e1nLUT3D::SetTitle(const string &newTitle) {title = newTitle;}
+
+#endif     // E1NLUT3D_H
@@ -0,0 +1,510 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPack.cpp - Implementation file for e1nColor's float to 8 & 16-bit packing & dithering.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPack.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+// Side of the blue-noise threshold map, & the Gaussian the void-and-cluster search measures with.
+#define E1N_BLUE_NOISE_SIZE   64
+#define E1N_BLUE_NOISE_SIGMA  1.5f
+#define E1N_BLUE_NOISE_RADIUS 7
+
+// Columns an error-diffusion row processes between checks on the row above.
+#define E1N_DIFFUSION_BLOCK 64
+
+//====================================================================================================
+// Threshold maps:
+//====================================================================================================
+
+static const unsigned char bayer8[8][8] =
+{
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+//----------------------------------------------------------------------------------------------------
+//     The void-and-cluster search (Ulichney, 1993). Each pixel's energy is the Gaussian-weighted count
+// of set pixels around it, wrapping at the edges so the map tiles. Starting from a sparse random
+// pattern relaxed until it's even, set pixels are ranked by removing the tightest cluster (highest
+// energy) until none are left, & the rest by filling the largest void (lowest energy) until the map
+// is full. Thresholding the ranks at any level then gives an evenly spread pattern.
+//----------------------------------------------------------------------------------------------------
+
+class e1nVoidAndCluster
+{
+private:
+
+    vector<float>         weights;      // The Gaussian, (2 * radius + 1)^2.
+    vector<float>         energy;
+    vector<unsigned char> bits;
+
+public:
+
+    e1nVoidAndCluster() : energy(E1N_BLUE_NOISE_SIZE * E1N_BLUE_NOISE_SIZE, 0.0f), bits(energy.size(), 0)
+    {
+        int span = 2 * E1N_BLUE_NOISE_RADIUS + 1;
+
+        weights.resize(span * span);
+
+        for (int dy = 0; dy < span; ++dy)
+        {
+            for (int dx = 0; dx < span; ++dx)
+            {
+                float x = (float) (dx - E1N_BLUE_NOISE_RADIUS);
+                float y = (float) (dy - E1N_BLUE_NOISE_RADIUS);
+
+                weights[dy * span + dx] = exp(-(x * x + y * y) / (2.0f * E1N_BLUE_NOISE_SIGMA * E1N_BLUE_NOISE_SIGMA));
+            }
+        }
+    }
+
+    bool IsSet(const int i) const {return bits[i] != 0;}
+
+    void Toggle(const int i)
+    {
+        int   span = 2 * E1N_BLUE_NOISE_RADIUS + 1;
+        int   x    = i % E1N_BLUE_NOISE_SIZE;
+        int   y    = i / E1N_BLUE_NOISE_SIZE;
+        float sign = bits[i] ? -1.0f : 1.0f;
+
+        bits[i] = !bits[i];
+
+        for (int dy = 0; dy < span; ++dy)
+        {
+            int row = (y + dy - E1N_BLUE_NOISE_RADIUS) & (E1N_BLUE_NOISE_SIZE - 1);
+
+            for (int dx = 0; dx < span; ++dx)
+            {
+                int col = (x + dx - E1N_BLUE_NOISE_RADIUS) & (E1N_BLUE_NOISE_SIZE - 1);
+
+                energy[row * E1N_BLUE_NOISE_SIZE + col] += sign * weights[dy * span + dx];
+            }
+        }
+    }
+
+    // The set pixel with the most energy, or the clear one with the least; the first on a tie.
+    int TightestCluster() const
+    {
+        int best = -1;
+
+        for (int i = 0; i < (int) bits.size(); ++i)
+        {
+            if (bits[i] && (best < 0 || energy[i] > energy[best])) {best = i;}
+        }
+
+        return best;
+    }
+
+    int LargestVoid() const
+    {
+        int best = -1;
+
+        for (int i = 0; i < (int) bits.size(); ++i)
+        {
+            if (!bits[i] && (best < 0 || energy[i] < energy[best])) {best = i;}
+        }
+
+        return best;
+    }
+};
+
+// Thresholds in 0-1, one per pixel of the map, row by row. Built once, from a fixed seed.
+static void BuildBlueNoise(vector<float> &thresholds)
+{
+    const int count = E1N_BLUE_NOISE_SIZE * E1N_BLUE_NOISE_SIZE;
+    const int seeds = count / 10;
+
+    e1nVoidAndCluster prototype;
+    uint32_t          state = 0x2545F491u;
+
+    for (int placed = 0; placed < seeds; )
+    {
+        state = state * 1664525u + 1013904223u;
+
+        int i = (int) ((state >> 8) % count);
+
+        if (!prototype.IsSet(i)) {prototype.Toggle(i); ++placed;}
+    }
+
+    // Moves the tightest cluster into the largest void until that would put it straight back.
+    for (int pass = 0; pass < count; ++pass)
+    {
+        int cluster = prototype.TightestCluster();
+
+        prototype.Toggle(cluster);
+
+        int gap = prototype.LargestVoid();
+
+        prototype.Toggle(gap);
+
+        if (gap == cluster) {break;}
+    }
+
+    vector<int> rank(count);
+
+    e1nVoidAndCluster pattern = prototype;
+
+    for (int r = seeds - 1; r >= 0; --r)
+    {
+        int i = pattern.TightestCluster();
+
+        pattern.Toggle(i);
+        rank[i] = r;
+    }
+
+    for (int r = seeds; r < count; ++r)
+    {
+        int i = prototype.LargestVoid();
+
+        prototype.Toggle(i);
+        rank[i] = r;
+    }
+
+    thresholds.resize(count);
+
+    for (int i = 0; i < count; ++i) {thresholds[i] = (rank[i] + 0.5f) / count;}
+}
+
+static const float *GetBlueNoise()
+{
+    static vector<float> thresholds;
+    static once_flag     built;
+
+    call_once(built, [] {BuildBlueNoise(thresholds);});
+
+    return thresholds.data();
+}
+
+//----------------------------------------------------------------------------------------------------
+//     The rounding offsets for an ordered dither: one row per row of the map, each repeated out to a
+// chunk plus a period, so the offsets for a run of up to E1N_BATCH_CHUNK pixels from (row, col) are
+// the row for row % period starting at col % period. No dither is a period of 1, all 0.5.
+//----------------------------------------------------------------------------------------------------
+
+static int BuildOffsets(const e1nPackOptions &options, vector<float> &offsets)
+{
+    int          period = 1;
+    const float *map    = nullptr;
+    float        bayer[64];
+
+    if (options.dither == E1N_DITHER_BAYER)
+    {
+        for (int i = 0; i < 64; ++i) {bayer[i] = (bayer8[i / 8][i % 8] + 0.5f) / 64.0f;}
+
+        period = 8;
+        map    = bayer;
+    }
+    else if (options.dither == E1N_DITHER_BLUE_NOISE)
+    {
+        period = E1N_BLUE_NOISE_SIZE;
+        map    = GetBlueNoise();
+    }
+
+    int width = E1N_BATCH_CHUNK + period;
+
+    offsets.resize((size_t) period * width);
+
+    for (int y = 0; y < period; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            float t = map ? map[y * period + x % period] : 0.5f;
+
+            offsets[(size_t) y * width + x] = 0.5f + options.strength * (t - 0.5f);
+        }
+    }
+
+    return period;
+}
+
+//====================================================================================================
+// Packing:
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+//     Where the packers read from: an interleaved float Mat, unpacked a run at a time, or planes read
+// where they are.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nPackSource
+{
+    const Mat            *image;
+    const e1nColorPlanes *planes;
+    bool                  alpha;        // Whether to read alpha (both sides have it).
+
+    // Points c at count values of each channel from (row, col); c[3] is null without alpha.
+    void Fetch(const int row, const int col, const int count, float (*scratch)[E1N_BATCH_CHUNK], const float **c) const
+    {
+        if (planes)
+        {
+            for (int k = 0; k < 3; ++k) {c[k] = planes->Row(k, row) + col;}
+
+            c[3] = alpha ? planes->Row(3, row) + col : nullptr;
+        }
+        else
+        {
+            e1nUnpackRow(*image, row, col, count, scratch[0], scratch[1], scratch[2], alpha ? scratch[3] : nullptr);
+
+            for (int k = 0; k < 3; ++k) {c[k] = scratch[k];}
+
+            c[3] = alpha ? scratch[3] : nullptr;
+        }
+    }
+};
+
+// Writes count pixels of quantized planes into an interleaved row; q[3] is ignored without alpha.
+template <class T> static void Interleave(T *p, const int cn, const int count, T (*q)[E1N_BATCH_CHUNK],
+                                          const bool alpha, const T top)
+{
+    if (cn == 3)
+    {
+        for (int i = 0; i < count; ++i, p += 3)
+        {
+            p[0] = q[0][i];
+            p[1] = q[1][i];
+            p[2] = q[2][i];
+        }
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i, p += 4)
+        {
+            p[0] = q[0][i];
+            p[1] = q[1][i];
+            p[2] = q[2][i];
+            p[3] = alpha ? q[3][i] : top;
+        }
+    }
+}
+
+// No dither & the ordered dithers, over one tile.
+template <class T> static void PackOrdered(const e1nPackSource &source, Mat &dst, const Rect &tile,
+                                           void (*quantize)(const float *, const float *, T *, const size_t),
+                                           const float *offsets, const int period, const T top)
+{
+    int cn     = dst.channels();
+    int planes = source.alpha ? 4 : 3;
+    int width  = E1N_BATCH_CHUNK + period;
+
+    alignas(64) float scratch[4][E1N_BATCH_CHUNK];
+    alignas(64) T     q[4][E1N_BATCH_CHUNK];
+
+    const float *c[4];
+
+    for (int row = tile.y; row < tile.y + tile.height; ++row)
+    {
+        const float *offsetRow = offsets + (size_t) (row % period) * width;
+
+        for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+            source.Fetch(row, col, count, scratch, c);
+
+            for (int k = 0; k < planes; ++k) {quantize(c[k], offsetRow + col % period, q[k], count);}
+
+            Interleave(dst.ptr<T>(row) + (size_t) col * cn, cn, count, q, source.alpha, top);
+        }
+    }
+}
+
+static inline float Clamp01(const float x)
+{
+    // Written so that NaN falls through to zero.
+    return x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f;
+}
+
+static void WaitFor(const atomic<int> &progress, const int target)
+{
+    while (progress.load(memory_order_acquire) < target) {this_thread::yield();}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Floyd-Steinberg on one row. Pixel x's error goes 7/16 to x + 1 on this row & 3/16, 5/16 & 1/16
+// to x - 1, x & x + 1 on the next, so a row can run as soon as the row above is two pixels ahead of
+// it. Rows keep to that by waiting for the row above to finish each block's columns plus one before
+// starting the block, & publishing their own progress after it.
+//
+//     Errors live in three rows of (cols + 2) per channel, indexed x + 1: the row takes its own from
+// row % 3 & builds the next row's in (row + 1) % 3, assigning the rightmost of each pixel's three
+// rather than adding to it, so it never has to be cleared. The third is still being read by the row
+// two above, which is always further along than this row is writing.
+//----------------------------------------------------------------------------------------------------
+
+template <class T> static void DiffuseRow(const e1nPackSource &source, Mat &dst, const int row, atomic<int> *progress,
+                                          float *errors, const float strength, const T top,
+                                          float (*scratch)[E1N_BATCH_CHUNK])
+{
+    int    cn     = dst.channels();
+    int    planes = source.alpha ? 4 : 3;
+    size_t width  = (size_t) dst.cols + 2;
+    float  scale  = (float) top;
+
+    float *cur[4];
+    float *next[4];
+    float  carry[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    for (int k = 0; k < planes; ++k)
+    {
+        cur[k]  = errors + ((row % 3) * 4 + k) * width;
+        next[k] = errors + (((row + 1) % 3) * 4 + k) * width;
+    }
+
+    const float *c[4];
+
+    for (int x0 = 0; x0 < dst.cols; x0 += E1N_DIFFUSION_BLOCK)
+    {
+        int x1 = min(x0 + E1N_DIFFUSION_BLOCK, dst.cols);
+
+        if (row > 0) {WaitFor(progress[row - 1], min(x1 + 1, dst.cols));}
+
+        if (x0 == 0)
+        {
+            for (int k = 0; k < planes; ++k) {next[k][0] = next[k][1] = 0.0f;}
+        }
+
+        source.Fetch(row, x0, x1 - x0, scratch, c);
+
+        T *p = dst.ptr<T>(row) + (size_t) x0 * cn;
+
+        for (int x = x0; x < x1; ++x, p += cn)
+        {
+            for (int k = 0; k < planes; ++k)
+            {
+                float v = Clamp01(c[k][x - x0]) * scale + cur[k][x + 1] + carry[k];
+                int   q = (int) min(max(v + 0.5f, 0.0f), scale);
+                float e = (v - q) * strength;
+
+                p[k]            = (T) q;
+                carry[k]        = e * (7.0f / 16.0f);
+                next[k][x]     += e * (3.0f / 16.0f);
+                next[k][x + 1] += e * (5.0f / 16.0f);
+                next[k][x + 2]  = e * (1.0f / 16.0f);
+            }
+
+            if (cn == 4 && planes == 3) {p[3] = top;}
+        }
+
+        progress[row].store(x1, memory_order_release);
+    }
+}
+
+//     Every thread takes the next row as it finishes one. Rows are taken in order by threads that are
+// running them, so the row any thread waits on is always being worked on, & a scheduler that runs
+// the items one after another (a single thread, or a call from inside a tile) simply does the whole
+// image on the first.
+template <class T> static void PackDiffused(const e1nPackSource &source, Mat &dst, const float strength, const T top,
+                                            e1nTileScheduler &pool)
+{
+    vector<float>             errors(3 * 4 * ((size_t) dst.cols + 2), 0.0f);
+    unique_ptr<atomic<int>[]> progress(new atomic<int>[dst.rows]);
+    atomic<int>               nextRow(0);
+
+    for (int row = 0; row < dst.rows; ++row) {progress[row].store(0, memory_order_relaxed);}
+
+    pool.ParallelFor(min(pool.GetThreadCount(), dst.rows), [&](const int, const int)
+    {
+        alignas(64) float scratch[4][E1N_BATCH_CHUNK];
+
+        for (int row = nextRow.fetch_add(1); row < dst.rows; row = nextRow.fetch_add(1))
+        {
+            DiffuseRow(source, dst, row, progress.get(), errors.data(), strength, top, scratch);
+        }
+    });
+}
+
+static void Pack(const e1nPackSource &source, const Size size, Mat &dst, const int dstType,
+                 const e1nPackOptions &options, e1nTileScheduler *scheduler)
+{
+    CV_Assert(dstType == CV_8UC3 || dstType == CV_8UC4 || dstType == CV_16UC3 || dstType == CV_16UC4);
+
+    if (options.dither < E1N_DITHER_NONE || options.dither > E1N_DITHER_ERROR_DIFFUSION)
+    {
+        CV_Error(Error::StsBadArg, "e1nPack: unknown dither mode");
+    }
+
+    if (!(options.strength >= 0.0f && options.strength <= 1.0f))
+    {
+        CV_Error(Error::StsBadArg, "e1nPack: strength must be 0-1");
+    }
+
+    e1nTileScheduler &pool  = scheduler ? *scheduler : e1nTileScheduler::Default();
+    bool              words = CV_MAT_DEPTH(dstType) == CV_16U;
+
+    dst.create(size, dstType);
+
+    if (dst.empty()) {return;}
+
+    if (options.dither == E1N_DITHER_ERROR_DIFFUSION)
+    {
+        if (words) {PackDiffused<unsigned short>(source, dst, options.strength, 65535, pool);}
+        else       {PackDiffused<unsigned char> (source, dst, options.strength, 255,   pool);}
+
+        return;
+    }
+
+    vector<float>         offsets;
+    int                   period  = BuildOffsets(options, offsets);
+    const e1nKernelTable &kernels = e1nGetKernels();
+
+    pool.ForEachTile(size, [&](const Rect &tile, const int)
+    {
+        if (words) {PackOrdered<unsigned short>(source, dst, tile, kernels.quantizeOffset16, offsets.data(), period, 65535);}
+        else       {PackOrdered<unsigned char> (source, dst, tile, kernels.quantizeOffset8,  offsets.data(), period, 255);}
+    });
+}
+
+//====================================================================================================
+// Public functions:
+//====================================================================================================
+
+void e1nPack(const Mat &src, Mat &dst, const int dstType, const e1nPackOptions &options, e1nTileScheduler *scheduler)
+{
+    CV_Assert(src.type() == CV_32FC3 || src.type() == CV_32FC4);
+
+    // Hold on to the source in case dst is src & create() is about to reallocate it.
+    Mat           input  = src;
+    e1nPackSource source = {&input, nullptr, input.channels() == 4 && CV_MAT_CN(dstType) == 4};
+
+    E1N_TRACE_OP("e1nPack", input.total(), input.total() * (input.elemSize() + CV_ELEM_SIZE(dstType)));
+
+    Pack(source, input.size(), dst, dstType, options, scheduler);
+}
+
+void e1nPack(const e1nColorPlanes &planes, Mat &dst, const int dstType, const e1nPackOptions &options,
+             e1nTileScheduler *scheduler)
+{
+    e1nPackSource source = {nullptr, &planes, planes.HasAlpha() && CV_MAT_CN(dstType) == 4};
+
+    E1N_TRACE_OP("e1nPack", (uint64_t) planes.Rows() * planes.Cols(),
+                 (uint64_t) planes.Rows() * planes.Cols() * ((planes.HasAlpha() ? 16 : 12) + CV_ELEM_SIZE(dstType)));
+
+    Pack(source, Size(planes.Cols(), planes.Rows()), dst, dstType, options, scheduler);
+}
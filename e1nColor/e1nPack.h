@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nPack.h - Interface definition file for e1nColor's float to 8 & 16-bit packing & dithering.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NPACK_H
+#define E1NPACK_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nPack() is the last stage of a job: it takes float results (a CV_32FC3/4 Mat or an
+// e1nColorPlanes buffer) out to CV_8UC3/4 or CV_16UC3/4, a whole image at a time, instead of a
+// GetVec3b() per pixel:
+//
+//     e1nPackOptions options;
+//
+//     options.dither = E1N_DITHER_BLUE_NOISE;
+//
+//     e1nPack(planes, output, CV_8UC3, options);
+//
+//     Values are clamped to 0-1 (NaN to 0) on the way, so results pushed out of range by a blend or
+// NormalizeRGB() saturate instead of wrapping. Without dithering every value is rounded exactly as
+// e1nFloatToByte() does it (& likewise to 0-65535), so 8-bit output matches GetVec3b().
+//
+//     Smooth gradients (skies, vignettes, heavy grades) band once they're cut down to 256 levels; the
+// dithers trade the bands for noise a fraction of a level strong:
+//
+//      E1N_DITHER_BAYER           - An 8 x 8 ordered pattern. The cheapest, but its cross-hatch shows
+//                                   on flat areas.
+//      E1N_DITHER_BLUE_NOISE      - A 64 x 64 void-and-cluster threshold map: the same cost as Bayer,
+//                                   with noise that has no pattern the eye can pick out.
+//      E1N_DITHER_ERROR_DIFFUSION - Floyd-Steinberg. Carries each pixel's rounding error on to its
+//                                   neighbors, so flat areas average out exactly. Noticeably slower.
+//
+//     Both ordered dithers (& no dither) are a rounding offset per pixel added in SIMD, with tiles
+// split across the scheduler's threads. Error diffusion is serial within a row, so rows run as a
+// wavefront instead: each thread takes the next row & follows a block of columns behind the row
+// above it. The output is the same as a plain top-to-bottom pass, whatever the thread count.
+//
+//     Alpha, when both sides have it, is packed & dithered like the color channels. A 4-channel
+// output from a 3-channel source is given full alpha; a 3-channel output drops the source's alpha.
+//====================================================================================================
+
+enum e1nDitherMode
+{
+    E1N_DITHER_NONE,
+    E1N_DITHER_BAYER,
+    E1N_DITHER_BLUE_NOISE,
+    E1N_DITHER_ERROR_DIFFUSION
+};
+
+struct e1nPackOptions
+{
+    int   dither;                       // An e1nDitherMode.
+    float strength;                     // 0-1: how much of the dither to apply; 0 is plain rounding.
+
+    e1nPackOptions() : dither(E1N_DITHER_NONE), strength(1.0f) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Packs into dst, created as the source's size in dstType (CV_8UC3/4 or CV_16UC3/4). A null
+// scheduler means e1nTileScheduler::Default().
+//----------------------------------------------------------------------------------------------------
+
+void e1nPack(const Mat &src, Mat &dst, const int dstType, const e1nPackOptions &options = e1nPackOptions(),
+             e1nTileScheduler *scheduler = nullptr);
+
+void e1nPack(const e1nColorPlanes &planes, Mat &dst, const int dstType, const e1nPackOptions &options = e1nPackOptions(),
+             e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NPACK_H
@@ -0,0 +1,404 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPalette.cpp - Implementation file for e1nColor's palette extraction & color quantization.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPalette.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+// Samples handed to each thread at a time.
+#define E1N_SAMPLE_BLOCK 4096
+
+// Most samples k-means++ seeding looks at. Seeding is serial & O(samples * colors), so it works from
+// every n-th sample, which still covers the whole image.
+#define E1N_SEED_SAMPLES 32768
+
+//====================================================================================================
+// Helpers:
+//====================================================================================================
+
+// A small, fast, repeatable random number generator (xorshift32).
+struct e1nRandom
+{
+    uint32_t state;
+
+    e1nRandom(const uint32_t seed) : state(seed ? seed : 1u) {}
+
+    uint32_t Next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state;
+    }
+
+    float NextFloat() {return (Next() >> 8) * (1.0f / 16777216.0f);}
+};
+
+// The cluster centers as three planes, so the assignment loop can broadcast straight from them.
+struct e1nCentroids
+{
+    vector<float> h;
+    vector<float> l;
+    vector<float> s;
+
+    int Count() const {return (int) h.size();}
+};
+
+// Finds the nearest centroid (as a float index) & its distance for a run of HLS pixels.
+static void NearestRun(const float *h, const float *l, const float *s, const size_t count, const e1nCentroids &centers,
+                       const float hueWeight, float *index, float *dist)
+{
+    e1nPaletteKernel k;
+
+    k.h         = centers.h.data();
+    k.l         = centers.l.data();
+    k.s         = centers.s.data();
+    k.count     = centers.Count();
+    k.hueWeight = hueWeight;
+
+    e1nGetKernels().nearestCentroid(h, l, s, count, k, index, dist);
+}
+
+//====================================================================================================
+// Clustering:
+//====================================================================================================
+
+// The sampled pixels, in HLS, plus the saturation-weighted hue vectors the centroid update averages.
+struct e1nSamples
+{
+    vector<float> h, l, s;
+    vector<float> hx, hy;
+
+    int Count() const {return (int) h.size();}
+};
+
+static void GatherSamples(const Mat &image, const e1nPaletteOptions &options, e1nTileScheduler &pool, e1nSamples &samples)
+{
+    uint64_t total = (uint64_t) image.rows * image.cols;
+    int      count = (int) min<uint64_t>(max(options.sampleSize, options.colors), total);
+    uint64_t step  = total / count;
+
+    for (vector<float> *plane : {&samples.h, &samples.l, &samples.s, &samples.hx, &samples.hy}) {plane->resize(count);}
+
+    pool.ParallelFor((count + E1N_SAMPLE_BLOCK - 1) / E1N_SAMPLE_BLOCK, [&](const int block, const int)
+    {
+        int first = block * E1N_SAMPLE_BLOCK;
+        int last  = min(first + E1N_SAMPLE_BLOCK, count);
+
+        // One pixel from each evenly spaced stretch of the image, jittered within it.
+        for (int i = first; i < last; ++i)
+        {
+            uint32_t hash = ((uint32_t) i ^ options.seed) * 2654435761u;
+
+            hash ^= hash >> 16;
+
+            uint64_t at = (uint64_t) i * step + hash % step;
+
+            e1nUnpackRow(image, (int) (at / image.cols), (int) (at % image.cols), 1, &samples.h[i], &samples.l[i], &samples.s[i]);
+        }
+
+        e1nGetKernels().convert[E1N_CONVERT_RGB2HLS](&samples.h[first], &samples.l[first], &samples.s[first], last - first);
+
+        for (int i = first; i < last; ++i)
+        {
+            double angle = 2.0 * PI * samples.h[i];
+
+            samples.hx[i] = samples.s[i] * (float) cos(angle);
+            samples.hy[i] = samples.s[i] * (float) sin(angle);
+        }
+    });
+}
+
+// k-means++: each new seed is picked with probability proportional to its squared distance from the
+// nearest seed so far, which spreads the seeds over the distinct colors.
+static void SeedCentroids(const e1nSamples &samples, const e1nPaletteOptions &options, e1nCentroids &centers)
+{
+    int           stride = (samples.Count() + E1N_SEED_SAMPLES - 1) / E1N_SEED_SAMPLES;
+    int           count  = (samples.Count() + stride - 1) / stride;
+    e1nRandom     random(options.seed);
+    vector<float> nearest(count, HUGE_VALF);
+
+    int pick = (int) (random.Next() % count);
+
+    for (int k = 0; k < options.colors; ++k)
+    {
+        int at = pick * stride;
+
+        centers.h.push_back(samples.h[at]);
+        centers.l.push_back(samples.l[at]);
+        centers.s.push_back(samples.s[at]);
+
+        double total = 0.0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int      j = i * stride;
+            e1nF32x1 d = PaletteDistance(e1nF32x1(samples.h[j]), e1nF32x1(samples.l[j]), e1nF32x1(samples.s[j]),
+                                         samples.h[at], samples.l[at], samples.s[at], options.hueWeight);
+
+            nearest[i] = min(nearest[i], d.v);
+            total     += nearest[i];
+        }
+
+        // Fewer distinct colors than asked for? The remaining seeds duplicate, & empty out below.
+        if (total <= 0.0) {continue;}
+
+        double target = random.NextFloat() * total;
+
+        for (pick = 0; pick < count - 1 && (target -= nearest[pick]) > 0.0; ++pick) {}
+    }
+}
+
+// One thread's sums for the centroid update.
+struct e1nClusterSums
+{
+    vector<double> count, l, s, hx, hy;
+    float          worstDist;           // The worst-fitting sample seen, for refilling empty clusters.
+    int            worstIndex;
+    int            changed;
+
+    void Reset(const int colors)
+    {
+        for (vector<double> *v : {&count, &l, &s, &hx, &hy}) {v->assign(colors, 0.0);}
+
+        worstDist  = -1.0f;
+        worstIndex = 0;
+        changed    = 0;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Lloyd iterations: assign every sample to its nearest centroid across the scheduler's threads,
+// then move each centroid to the mean of its samples. Returns the final per-cluster sample counts.
+//----------------------------------------------------------------------------------------------------
+
+static vector<double> RunLloyd(const e1nSamples &samples, const e1nPaletteOptions &options, e1nTileScheduler &pool, e1nCentroids &centers)
+{
+    int                    count  = samples.Count();
+    int                    colors = centers.Count();
+    int                    blocks = (count + E1N_SAMPLE_BLOCK - 1) / E1N_SAMPLE_BLOCK;
+    vector<int>            labels(count, -1);
+    vector<e1nClusterSums> sums(pool.GetThreadCount());
+    vector<double>         totals;
+
+    for (int iteration = 0; iteration <= options.iterations; ++iteration)
+    {
+        for (e1nClusterSums &t : sums) {t.Reset(colors);}
+
+        pool.ParallelFor(blocks, [&](const int block, const int thread)
+        {
+            e1nClusterSums &t     = sums[thread];
+            int             first = block * E1N_SAMPLE_BLOCK;
+            int             n     = min(E1N_SAMPLE_BLOCK, count - first);
+
+            alignas(64) float index[E1N_SAMPLE_BLOCK];
+            alignas(64) float dist [E1N_SAMPLE_BLOCK];
+
+            NearestRun(&samples.h[first], &samples.l[first], &samples.s[first], n, centers, options.hueWeight, index, dist);
+
+            for (int i = 0; i < n; ++i)
+            {
+                int k = (int) index[i];
+                int j = first + i;
+
+                t.changed += labels[j] != k;
+                labels[j]  = k;
+
+                t.count[k] += 1.0;
+                t.l[k]     += samples.l[j];
+                t.s[k]     += samples.s[j];
+                t.hx[k]    += samples.hx[j];
+                t.hy[k]    += samples.hy[j];
+
+                if (dist[i] > t.worstDist)
+                {
+                    t.worstDist  = dist[i];
+                    t.worstIndex = j;
+                }
+            }
+        });
+
+        for (size_t t = 1; t < sums.size(); ++t)
+        {
+            for (int k = 0; k < colors; ++k)
+            {
+                sums[0].count[k] += sums[t].count[k];
+                sums[0].l[k]     += sums[t].l[k];
+                sums[0].s[k]     += sums[t].s[k];
+                sums[0].hx[k]    += sums[t].hx[k];
+                sums[0].hy[k]    += sums[t].hy[k];
+            }
+
+            sums[0].changed += sums[t].changed;
+
+            if (sums[t].worstDist > sums[0].worstDist)
+            {
+                sums[0].worstDist  = sums[t].worstDist;
+                sums[0].worstIndex = sums[t].worstIndex;
+            }
+        }
+
+        totals = sums[0].count;
+
+        // The last pass only counts; so does one where no sample changed cluster.
+        if (iteration == options.iterations || sums[0].changed == 0) {break;}
+
+        bool refilled = false;
+
+        for (int k = 0; k < colors; ++k)
+        {
+            const e1nClusterSums &t = sums[0];
+
+            if (t.count[k] == 0.0)
+            {
+                // An empty cluster takes over the sample that fits its own cluster worst (once per pass,
+                // since that's the only sample we know to be badly served).
+                if (refilled) {continue;}
+
+                centers.h[k] = samples.h[t.worstIndex];
+                centers.l[k] = samples.l[t.worstIndex];
+                centers.s[k] = samples.s[t.worstIndex];
+                refilled     = true;
+                continue;
+            }
+
+            centers.l[k] = (float) (t.l[k] / t.count[k]);
+            centers.s[k] = (float) (t.s[k] / t.count[k]);
+
+            // A cluster of grays has no hue direction; keep the one it had.
+            if (t.hx[k] != 0.0 || t.hy[k] != 0.0)
+            {
+                double angle = atan2(t.hy[k], t.hx[k]) / (2.0 * PI);
+
+                centers.h[k] = (float) (angle < 0.0 ? angle + 1.0 : angle);
+            }
+        }
+    }
+
+    return totals;
+}
+
+//====================================================================================================
+// Palette extraction & quantization:
+//====================================================================================================
+
+vector<e1nPaletteEntry> e1nExtractPalette(const Mat &rgbImage, const e1nPaletteOptions &options, e1nTileScheduler *scheduler)
+{
+    CV_Assert(rgbImage.type() == CV_8UC3 || rgbImage.type() == CV_8UC4 || rgbImage.type() == CV_32FC3 || rgbImage.type() == CV_32FC4);
+    CV_Assert(!rgbImage.empty());
+    CV_Assert(options.colors >= 1 && options.colors <= 256 && options.iterations >= 0);
+
+    E1N_TRACE_OP("e1nExtractPalette", rgbImage.total(), rgbImage.total() * rgbImage.elemSize());
+
+    e1nTileScheduler &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+    e1nSamples        samples;
+    e1nCentroids      centers;
+
+    GatherSamples(rgbImage, options, pool, samples);
+    SeedCentroids(samples, options, centers);
+
+    vector<double>          counts = RunLloyd(samples, options, pool, centers);
+    vector<e1nPaletteEntry> palette;
+
+    for (int k = 0; k < centers.Count(); ++k)
+    {
+        if (counts[k] == 0.0) {continue;}
+
+        e1nPaletteEntry entry;
+
+        entry.hue    = centers.h[k];
+        entry.light  = centers.l[k];
+        entry.sat    = min(centers.s[k], 2.0f * min(entry.light, 1.0f - entry.light));
+        entry.weight = (float) (counts[k] / samples.Count());
+        entry.color  = e1nColor(entry.hue, entry.light, entry.sat);
+
+        entry.color.ConvertHLS2RGB();
+
+        palette.push_back(entry);
+    }
+
+    stable_sort(palette.begin(), palette.end(), [](const e1nPaletteEntry &a, const e1nPaletteEntry &b) {return a.weight > b.weight;});
+
+    return palette;
+}
+
+void e1nQuantize(Mat &rgbImage, const vector<e1nPaletteEntry> &palette, Mat *indices, const float hueWeight, e1nTileScheduler *scheduler)
+{
+    CV_Assert(rgbImage.type() == CV_8UC3 || rgbImage.type() == CV_8UC4 || rgbImage.type() == CV_32FC3 || rgbImage.type() == CV_32FC4);
+    CV_Assert(!palette.empty() && palette.size() <= 256);
+
+    E1N_TRACE_OP("e1nQuantize", rgbImage.total(), rgbImage.total() * rgbImage.elemSize() * 2);
+
+    e1nTileScheduler &pool = scheduler ? *scheduler : e1nTileScheduler::Default();
+    e1nCentroids      centers;
+    vector<float>     red, green, blue;
+
+    for (const e1nPaletteEntry &entry : palette)
+    {
+        const e1nColor &color = entry.color;
+
+        centers.h.push_back(entry.hue);
+        centers.l.push_back(entry.light);
+        centers.s.push_back(entry.sat);
+
+        red.push_back(color.GetRedFloat());
+        green.push_back(color.GetGreenFloat());
+        blue.push_back(color.GetBlueFloat());
+    }
+
+    if (indices) {indices->create(rgbImage.size(), CV_8UC1);}
+
+    pool.ForEachTile(rgbImage.size(), [&](const Rect &tile, const int)
+    {
+        alignas(64) float c0[E1N_BATCH_CHUNK];
+        alignas(64) float c1[E1N_BATCH_CHUNK];
+        alignas(64) float c2[E1N_BATCH_CHUNK];
+        alignas(64) float index[E1N_BATCH_CHUNK];
+        alignas(64) float dist [E1N_BATCH_CHUNK];
+
+        for (int row = tile.y; row < tile.y + tile.height; ++row)
+        {
+            for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+                e1nUnpackRow(rgbImage, row, col, count, c0, c1, c2);
+                e1nGetKernels().convert[E1N_CONVERT_RGB2HLS](c0, c1, c2, count);
+                NearestRun(c0, c1, c2, count, centers, hueWeight, index, dist);
+
+                for (int i = 0; i < count; ++i)
+                {
+                    int k = (int) index[i];
+
+                    c0[i] = red[k];
+                    c1[i] = green[k];
+                    c2[i] = blue[k];
+                }
+
+                e1nPackRow(rgbImage, row, col, count, c0, c1, c2);
+
+                if (indices)
+                {
+                    unsigned char *p = indices->ptr<unsigned char>(row) + col;
+
+                    for (int i = 0; i < count; ++i) {p[i] = (unsigned char) index[i];}
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nPalette.h - Interface definition file for e1nColor's palette extraction & color quantization.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NPALETTE_H
+#define E1NPALETTE_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Palette extraction is k-means clustering in e1nColor's HLS space. Distances treat hue as the
+// angle it is: the hue difference is taken the short way round the wheel (0.95 & 0.05 are 0.1 apart,
+// not 0.9), & is weighted by the lesser of the two saturations, since the less saturated a color is
+// the less its hue means; grays are told apart by lightness alone.
+//
+//      d² = (hueWeight * min(s1, s2) * hueDiff)² + (l1 - l2)² + (s1 - s2)²
+//
+//     Centroid hues are likewise saturation-weighted circular means rather than plain averages.
+//
+//     Clustering runs on a subsample of the image (k-means++ seeding, then Lloyd iterations whose
+// nearest-centroid assignment is vectorized & spread across the tile scheduler), so its cost doesn't
+// grow with the image. Remapping the full image to the palette is then one threaded pass.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// Settings.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nPaletteOptions
+{
+    int      colors;                    // Palette size, 1-256.
+    int      sampleSize;                // Pixels clustered (fewer if the image is smaller).
+    int      iterations;                // Most Lloyd iterations; stops early once nothing moves.
+    float    hueWeight;                 // Weight of hue against lightness & saturation.
+    uint32_t seed;                      // Seed for sampling & seeding, so results are repeatable.
+
+    e1nPaletteOptions() : colors(16), sampleSize(1 << 18), iterations(16), hueWeight(2.0f), seed(0x9E3779B9u) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+// One palette color.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nPaletteEntry
+{
+    e1nColor color;                     // The color as RGB.
+    float    hue;                       // The cluster center in HLS.
+    float    light;
+    float    sat;
+    float    weight;                    // Share of the sampled pixels in this cluster, 0-1.
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Extracts a palette from an RGB CV_8UC3/4 or CV_32FC3/4 image, most common color first. A null
+// scheduler means e1nTileScheduler::Default().
+//----------------------------------------------------------------------------------------------------
+
+vector<e1nPaletteEntry> e1nExtractPalette(const Mat &rgbImage, const e1nPaletteOptions &options = e1nPaletteOptions(),
+                                          e1nTileScheduler *scheduler = nullptr);
+
+//----------------------------------------------------------------------------------------------------
+//     Replaces every pixel of an RGB image with its nearest palette color, in place, leaving alpha
+// alone. indices, if given, receives each pixel's palette index as CV_8UC1.
+//----------------------------------------------------------------------------------------------------
+
+void e1nQuantize(Mat &rgbImage, const vector<e1nPaletteEntry> &palette, Mat *indices = nullptr,
+                 const float hueWeight = 2.0f, e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NPALETTE_H
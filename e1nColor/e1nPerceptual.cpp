@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPerceptual.cpp - Implementation file for e1nColor's XYZ, CIE Lab & OKLab conversions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPerceptual.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include "lib/e1nColor/e1nTransfer.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Drivers:
+//====================================================================================================
+//     A run of three planes is decoded to linear (if the conversion starts from RGB), converted, &
+// re-encoded (if it ends in RGB), all before moving on.
+//----------------------------------------------------------------------------------------------------
+
+static void ConvertRun(float *c0, float *c1, float *c2, const int count, const e1nKernelTable::ConvertFn convert,
+                       const e1nTransferCurve curve, const bool fromRGB)
+{
+    if (fromRGB && curve != E1N_TRANSFER_LINEAR)
+    {
+        e1nToLinear(c0, count, curve);
+        e1nToLinear(c1, count, curve);
+        e1nToLinear(c2, count, curve);
+    }
+
+    convert(c0, c1, c2, count);
+
+    if (!fromRGB && curve != E1N_TRANSFER_LINEAR)
+    {
+        e1nFromLinear(c0, count, curve);
+        e1nFromLinear(c1, count, curve);
+        e1nFromLinear(c2, count, curve);
+    }
+}
+
+static void ConvertMat(Mat &image, const e1nConvertKernel kernel, const e1nTransferCurve curve, const bool fromRGB,
+                       e1nTileScheduler *scheduler)
+{
+    CV_Assert(image.type() == CV_32FC3 || image.type() == CV_32FC4);
+
+    e1nTileScheduler          &pool    = scheduler ? *scheduler : e1nTileScheduler::Default();
+    e1nKernelTable::ConvertFn  convert = e1nGetKernels().convert[kernel];
+
+    pool.ForEachTile(image, [&](Mat &tile)
+    {
+        alignas(64) float c0[E1N_BATCH_CHUNK];
+        alignas(64) float c1[E1N_BATCH_CHUNK];
+        alignas(64) float c2[E1N_BATCH_CHUNK];
+
+        for (int row = 0; row < tile.rows; ++row)
+        {
+            for (int col = 0; col < tile.cols; col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, tile.cols - col);
+
+                e1nUnpackRow(tile, row, col, count, c0, c1, c2);
+                ConvertRun(c0, c1, c2, count, convert, curve, fromRGB);
+                e1nPackRow(tile, row, col, count, c0, c1, c2);
+            }
+        }
+    });
+}
+
+static void ConvertPlanes(e1nColorPlanes &planes, const e1nConvertKernel kernel, const e1nTransferCurve curve, const bool fromRGB,
+                          e1nTileScheduler *scheduler)
+{
+    e1nTileScheduler          &pool    = scheduler ? *scheduler : e1nTileScheduler::Default();
+    e1nKernelTable::ConvertFn  convert = e1nGetKernels().convert[kernel];
+
+    pool.ForEachTile(planes, [&](e1nColorPlanes &tile)
+    {
+        for (int row = 0; row < tile.Rows(); ++row)
+        {
+            for (int col = 0; col < tile.Cols(); col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, tile.Cols() - col);
+
+                ConvertRun(tile.Row(0, row) + col, tile.Row(1, row) + col, tile.Row(2, row) + col, count, convert, curve, fromRGB);
+            }
+        }
+    });
+}
+
+//====================================================================================================
+// CIE XYZ:
+//====================================================================================================
+
+void e1nConvertRGB2XYZ(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2XYZ", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_RGB2XYZ, curve, true, scheduler);
+}
+
+void e1nConvertXYZ2RGB(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertXYZ2RGB", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_XYZ2RGB, curve, false, scheduler);
+}
+
+void e1nConvertRGB2XYZ(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2XYZ", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_RGB2XYZ, curve, true, scheduler);
+}
+
+void e1nConvertXYZ2RGB(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertXYZ2RGB", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_XYZ2RGB, curve, false, scheduler);
+}
+
+//====================================================================================================
+// CIE L*a*b*:
+//====================================================================================================
+
+void e1nConvertRGB2Lab(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2Lab", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_RGB2LAB, curve, true, scheduler);
+}
+
+void e1nConvertLab2RGB(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertLab2RGB", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_LAB2RGB, curve, false, scheduler);
+}
+
+void e1nConvertRGB2Lab(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2Lab", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_RGB2LAB, curve, true, scheduler);
+}
+
+void e1nConvertLab2RGB(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertLab2RGB", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_LAB2RGB, curve, false, scheduler);
+}
+
+//====================================================================================================
+// OKLab:
+//====================================================================================================
+
+void e1nConvertRGB2OKLab(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2OKLab", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_RGB2OKLAB, curve, true, scheduler);
+}
+
+void e1nConvertOKLab2RGB(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertOKLab2RGB", image.total(), image.total() * image.elemSize() * 2);
+
+    ConvertMat(image, E1N_CONVERT_OKLAB2RGB, curve, false, scheduler);
+}
+
+void e1nConvertRGB2OKLab(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertRGB2OKLab", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_RGB2OKLAB, curve, true, scheduler);
+}
+
+void e1nConvertOKLab2RGB(e1nColorPlanes &planes, const e1nTransferCurve curve, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nConvertOKLab2RGB", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    ConvertPlanes(planes, E1N_CONVERT_OKLAB2RGB, curve, false, scheduler);
+}
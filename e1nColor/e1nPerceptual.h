@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nPerceptual.h - Interface definition file for e1nColor's XYZ, CIE Lab & OKLab conversions.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NPERCEPTUAL_H
+#define E1NPERCEPTUAL_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Batch conversions between RGB & the perceptual spaces, in place, following the same convention
+// as e1nConvertRGB2HLS(): channel 0 holds red (then X, L* or L), 1 green (Y, a*, a) & 2 blue (Z, b*,
+// b), & alpha is left alone. They replace a round trip through cv::cvtColor() & the full-image copy
+// that goes with it.
+//
+//     RGB is taken to use the sRGB primaries & D65 white, encoded with the given transfer curve: the
+// default decodes sRGB on the way in & re-encodes it on the way out (as cvtColor does for float
+// data); pass E1N_TRANSFER_LINEAR for linear-light RGB. Each run of pixels is decoded, converted &
+// stored while it is still in L1 cache, so the curve costs no extra pass over the image.
+//
+// Scales:
+//
+//      XYZ   - Y = 1 for white.
+//      Lab   - CIE L*a*b*, L* 0-100, a* & b* roughly -128-128.
+//      OKLab - L 0-1, a & b roughly -0.4-0.4.
+//
+// Accuracy: the matrices run in single precision & cube roots go through the Cbrt() approximation in
+// e1nColorKernels.h (within 3e-7 relative). Against a double-precision reference, for linear RGB in
+// 0-1, Lab is within 2e-4 in L*, a* & b* (a ΔE of 1 is the just-noticeable difference), OKLab within
+// 1e-6 & XYZ within 2e-7. Each RGB -> space -> RGB round trip lands within 5e-6 of where it started
+// for linear RGB, & within 1e-4 through the sRGB curve, whose slope of 12.92 near black magnifies
+// the linear error.
+//
+//     Mat types: CV_32FC3 & CV_32FC4. A null scheduler means e1nTileScheduler::Default().
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// CIE XYZ:
+//----------------------------------------------------------------------------------------------------
+
+void e1nConvertRGB2XYZ  (Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertXYZ2RGB  (Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+void e1nConvertRGB2XYZ  (e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertXYZ2RGB  (e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+//----------------------------------------------------------------------------------------------------
+// CIE L*a*b* (D65):
+//----------------------------------------------------------------------------------------------------
+
+void e1nConvertRGB2Lab  (Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertLab2RGB  (Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+void e1nConvertRGB2Lab  (e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertLab2RGB  (e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+//----------------------------------------------------------------------------------------------------
+// OKLab:
+//----------------------------------------------------------------------------------------------------
+
+void e1nConvertRGB2OKLab(Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertOKLab2RGB(Mat &image, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+void e1nConvertRGB2OKLab(e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+void e1nConvertOKLab2RGB(e1nColorPlanes &planes, const e1nTransferCurve curve = E1N_TRANSFER_SRGB, e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NPERCEPTUAL_H
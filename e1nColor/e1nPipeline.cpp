@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPipeline.cpp - Implementation file for e1nColor's fused adjustment pipelines.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPipeline.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Step kernels:
+//====================================================================================================
+//     Every step is stored with a pointer to one of these, so running a chain is a straight walk down
+// an array of function pointers with no switching on the step type per chunk. Each one calls on into
+// the current level's kernel table, so a chain recorded before e1nSetCpuLevel() follows it.
+//----------------------------------------------------------------------------------------------------
+
+template <int Kernel> static void RunConvert(float *c0, float *c1, float *c2, const size_t count, const float)
+{
+    e1nGetKernels().convert[Kernel](c0, c1, c2, count);
+}
+
+template <int Op> static void RunAdjust(float *c0, float *c1, float *c2, const size_t count, const float amount)
+{
+    e1nGetKernels().adjust[Op](c0, c1, c2, nullptr, count, amount);
+}
+
+static e1nPipeline::Step::Kernel GetStepKernel(const e1nPipeline::StepType type)
+{
+    switch (type)
+    {
+        case e1nPipeline::E1N_STEP_RGB2HLS:   return RunConvert<E1N_CONVERT_RGB2HLS>;
+        case e1nPipeline::E1N_STEP_HLS2RGB:   return RunConvert<E1N_CONVERT_HLS2RGB>;
+        case e1nPipeline::E1N_STEP_SET_HUE:   return RunAdjust<E1N_ADJUST_SET_HUE>;
+        case e1nPipeline::E1N_STEP_SHIFT_HUE: return RunAdjust<E1N_ADJUST_SHIFT_HUE>;
+        case e1nPipeline::E1N_STEP_SET_SAT:   return RunAdjust<E1N_ADJUST_SET_SAT>;
+        case e1nPipeline::E1N_STEP_SCALE_SAT: return RunAdjust<E1N_ADJUST_SCALE_SAT>;
+        case e1nPipeline::E1N_STEP_SET_VAL:   return RunAdjust<E1N_ADJUST_SET_VAL>;
+        case e1nPipeline::E1N_STEP_SHIFT_VAL: return RunAdjust<E1N_ADJUST_SHIFT_VAL>;
+        case e1nPipeline::E1N_STEP_SCALE_VAL: return RunAdjust<E1N_ADJUST_SCALE_VAL>;
+    }
+
+    CV_Error(Error::StsBadArg, "e1nPipeline: unknown step type");
+}
+
+#if defined(E1N_ENABLE_TRACE)
+
+// What each step is called in a trace.
+static const char *GetStepName(const e1nPipeline::StepType type)
+{
+    switch (type)
+    {
+        case e1nPipeline::E1N_STEP_RGB2HLS:   return "pipeline ConvertRGB2HLS";
+        case e1nPipeline::E1N_STEP_HLS2RGB:   return "pipeline ConvertHLS2RGB";
+        case e1nPipeline::E1N_STEP_SET_HUE:   return "pipeline SetHue";
+        case e1nPipeline::E1N_STEP_SHIFT_HUE: return "pipeline ShiftHue";
+        case e1nPipeline::E1N_STEP_SET_SAT:   return "pipeline SetSat";
+        case e1nPipeline::E1N_STEP_SCALE_SAT: return "pipeline ScaleSat";
+        case e1nPipeline::E1N_STEP_SET_VAL:   return "pipeline SetVal";
+        case e1nPipeline::E1N_STEP_SHIFT_VAL: return "pipeline ShiftVal";
+        case e1nPipeline::E1N_STEP_SCALE_VAL: return "pipeline ScaleVal";
+    }
+
+    return "pipeline step";
+}
+
+#endif
+
+//====================================================================================================
+// Constructors & building the chain:
+//====================================================================================================
+
+e1nPipeline::e1nPipeline(e1nTileScheduler *tileScheduler)
+{
+    scheduler = tileScheduler ? tileScheduler : &e1nTileScheduler::Default();
+}
+
+e1nPipeline &e1nPipeline::Add(const StepType type, const float amount)
+{
+    Step step;
+
+    step.type   = type;
+    step.kernel = GetStepKernel(type);
+    step.amount = amount;
+
+    steps.push_back(step);
+
+    return *this;
+}
+
+//====================================================================================================
+// Running the chain:
+//====================================================================================================
+
+void e1nPipeline::RunPlanes(float *c0, float *c1, float *c2, const size_t count) const
+{
+#if defined(E1N_ENABLE_TRACE)
+    // Each step is timed on its own, so a trace shows where the chain's time goes.
+    if (e1nTrace::IsEnabled())
+    {
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            uint64_t begin = e1nTrace::Now();
+
+            steps[i].kernel(c0, c1, c2, count, steps[i].amount);
+
+            e1nTrace::AddStage(GetStepName(steps[i].type), e1nTrace::Now() - begin, count, count * 24);
+        }
+
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < steps.size(); ++i) {steps[i].kernel(c0, c1, c2, count, steps[i].amount);}
+}
+
+// Runs one tile of an interleaved image, a chunk of a row at a time.
+void e1nPipeline::RunRows(const Mat &src, Mat &dst, const Rect &tile) const
+{
+    bool alpha = dst.channels() == 4;
+
+    alignas(64) float c0[E1N_BATCH_CHUNK];
+    alignas(64) float c1[E1N_BATCH_CHUNK];
+    alignas(64) float c2[E1N_BATCH_CHUNK];
+    alignas(64) float c3[E1N_BATCH_CHUNK];
+
+    for (int row = tile.y; row < tile.y + tile.height; ++row)
+    {
+        for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+            e1nUnpackRow(src, row, col, count, c0, c1, c2, alpha ? c3 : nullptr);
+            RunPlanes(c0, c1, c2, count);
+            e1nPackRow(dst, row, col, count, c0, c1, c2, alpha ? c3 : nullptr);
+        }
+    }
+}
+
+// Planar tiles need no unpacking, but still go a chunk at a time so every step runs out of L1.
+void e1nPipeline::RunRows(e1nColorPlanes &planes, const Rect &tile) const
+{
+    for (int row = tile.y; row < tile.y + tile.height; ++row)
+    {
+        for (int col = tile.x; col < tile.x + tile.width; col += E1N_BATCH_CHUNK)
+        {
+            int count = min(E1N_BATCH_CHUNK, tile.x + tile.width - col);
+
+            RunPlanes(planes.Row(0, row) + col, planes.Row(1, row) + col, planes.Row(2, row) + col, count);
+        }
+    }
+}
+
+void e1nPipeline::Run(Mat &image) const
+{
+    Run(image, image);
+}
+
+void e1nPipeline::Run(const Mat &src, Mat &dst, const int dstType) const
+{
+    CV_Assert(src.type() == CV_8UC3  || src.type() == CV_8UC4  || src.type() == CV_16UC3 || src.type() == CV_16UC4 ||
+              src.type() == CV_32FC3 || src.type() == CV_32FC4);
+
+    int type = dstType < 0 ? src.type() : dstType;
+
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_16UC3 || type == CV_16UC4 || type == CV_32FC3 || type == CV_32FC4);
+
+    // Hold on to the source in case dst is src & create() is about to reallocate it.
+    Mat input = src;
+
+    dst.create(input.size(), type);
+
+    E1N_TRACE_OP("e1nPipeline::Run", input.total(), input.total() * (input.elemSize() + dst.elemSize()));
+
+    scheduler->ForEachTile(input.size(), [&](const Rect &tile, const int)
+    {
+        RunRows(input, dst, tile);
+    });
+}
+
+void e1nPipeline::Run(e1nColorPlanes &planes) const
+{
+    E1N_TRACE_OP("e1nPipeline::Run", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    scheduler->ForEachTile(Size(planes.Cols(), planes.Rows()), [&](const Rect &tile, const int)
+    {
+        RunRows(planes, tile);
+    });
+}
@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nPipeline.h - Interface definition file for e1nColor's fused adjustment pipelines.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NPIPELINE_H
+#define E1NPIPELINE_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     e1nPipeline - Records a chain of color operations once & runs the whole chain over an image in
+// a single pass. Calling e1nConvertRGB2HLS(), an adjustment & e1nConvertHLS2RGB() one after the other
+// sweeps the entire image through memory three times; a pipeline instead unpacks a short run of
+// pixels into float planes that stay in L1 cache, runs every step over them & packs them once, with
+// the image split into tiles across the tile scheduler's threads.
+//
+//     The chain is kept as data, so one pipeline can be built up front & run over any number of
+// images, from any number of threads at once. The builder functions return the pipeline, so a chain
+// reads left to right:
+//
+//      e1nPipeline warmer;
+//      warmer.ConvertRGB2HLS().ShiftHue(-0.02f).ScaleSat(1.2f).ShiftVal(0.05f).ConvertHLS2RGB();
+//      warmer.Run(photo8U, result8U);
+//
+//     The adjustments treat the channels as (h, l, s), with the same wrapping & clamping as
+// e1nColor::SetHue() / SetSat() / SetVal(); nothing checks that the image is actually in HLS at that
+// point in the chain, so a chain may also start or end in HLS. Alpha is passed straight through.
+//====================================================================================================
+
+class e1nPipeline
+{
+public:
+
+    // What a step does.
+    enum StepType
+    {
+        E1N_STEP_RGB2HLS,
+        E1N_STEP_HLS2RGB,
+        E1N_STEP_SET_HUE,
+        E1N_STEP_SHIFT_HUE,
+        E1N_STEP_SET_SAT,
+        E1N_STEP_SCALE_SAT,
+        E1N_STEP_SET_VAL,
+        E1N_STEP_SHIFT_VAL,
+        E1N_STEP_SCALE_VAL
+    };
+
+    // One recorded step: the kernel that runs it over three planes, & its amount.
+    struct Step
+    {
+        typedef void (*Kernel)(float *c0, float *c1, float *c2, const size_t count, const float amount);
+
+        StepType type;
+        Kernel   kernel;
+        float    amount;
+    };
+
+private:
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    vector<Step>      steps;            // The chain, in order.
+    e1nTileScheduler *scheduler;        // Scheduler the runs are split across.
+
+    e1nPipeline &Add(const StepType type, const float amount);
+
+    void RunRows(const Mat &src, Mat &dst, const Rect &tile) const;
+    void RunRows(e1nColorPlanes &planes, const Rect &tile) const;
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    // A null scheduler means e1nTileScheduler::Default().
+    e1nPipeline(e1nTileScheduler *tileScheduler = nullptr);
+
+    //----------------------------------------------------------------------------------------------------
+    // Building the chain:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nPipeline &ConvertRGB2HLS();
+    e1nPipeline &ConvertHLS2RGB();
+
+    e1nPipeline &SetHue   (const float newHue);     // 0-1, wraps around.
+    e1nPipeline &ShiftHue (const float delta);      // Turns the hue wheel; 0.5 is the complement.
+    e1nPipeline &SetSat   (const float newSat);
+    e1nPipeline &ScaleSat (const float factor);
+    e1nPipeline &SetVal   (const float newVal);
+    e1nPipeline &ShiftVal (const float delta);
+    e1nPipeline &ScaleVal (const float factor);
+
+    void Clear();
+    bool Empty() const;
+    int  StepCount() const;
+
+    const vector<Step> &GetSteps() const;
+
+    //----------------------------------------------------------------------------------------------------
+    //     Running the chain. Mats may be CV_8UC3/4, CV_16UC3/4 or CV_32FC3/4. The two-image form reads
+    // src & writes dst, creating dst as src's size in dstType (default: src's type), so e.g. a CV_32FC3
+    // working image can come out as CV_8UC3 in the same pass; src & dst may be the same Mat.
+    //----------------------------------------------------------------------------------------------------
+
+    void Run(Mat &image) const;
+    void Run(const Mat &src, Mat &dst, const int dstType = -1) const;
+    void Run(e1nColorPlanes &planes) const;
+
+    // Runs the chain over count pixels of three float planes, on the calling thread.
+    void RunPlanes(float *c0, float *c1, float *c2, const size_t count) const;
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline e1nPipeline &e1nPipeline::ConvertRGB2HLS()              {return Add(E1N_STEP_RGB2HLS,    0.0f);}
+inline e1nPipeline &e1nPipeline::ConvertHLS2RGB()              {return Add(E1N_STEP_HLS2RGB,    0.0f);}
+inline e1nPipeline &e1nPipeline::SetHue  (const float newHue)  {return Add(E1N_STEP_SET_HUE,    newHue);}
+inline e1nPipeline &e1nPipeline::ShiftHue(const float delta)   {return Add(E1N_STEP_SHIFT_HUE,  delta);}
+inline e1nPipeline &e1nPipeline::SetSat  (const float newSat)  {return Add(E1N_STEP_SET_SAT,    newSat);}
+inline e1nPipeline &e1nPipeline::ScaleSat(const float factor)  {return Add(E1N_STEP_SCALE_SAT,  factor);}
+inline e1nPipeline &e1nPipeline::SetVal  (const float newVal)  {return Add(E1N_STEP_SET_VAL,    newVal);}
+inline e1nPipeline &e1nPipeline::ShiftVal(const float delta)   {return Add(E1N_STEP_SHIFT_VAL,  delta);}
+inline e1nPipeline &e1nPipeline::ScaleVal(const float factor)  {return Add(E1N_STEP_SCALE_VAL,  factor);}
+
+inline void e1nPipeline::Clear()           {steps.clear();}
+inline bool e1nPipeline::Empty()     const {return steps.empty();}
+inline int  e1nPipeline::StepCount() const {return (int) steps.size();}
+
+inline const vector<e1nPipeline::Step> &e1nPipeline::GetSteps() const {return steps;}
+
+#endif     // E1NPIPELINE_H
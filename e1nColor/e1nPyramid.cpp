@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPyramid.cpp - Implementation file for e1nColor's hue-aware image pyramids & downscaling.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPyramid.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <cstring>
+#include <functional>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+// Floats kept either side of a working row, for the 5-tap filter's reach past the edges & the
+// column pass's over-read at the right.
+#define E1N_PYRAMID_PAD 4
+
+//====================================================================================================
+//     e1nPyramidBuilder - The streaming pass. Each level past the source is a stage with a ring of
+// input rows (two for the box, five for the binomial) in working form: RGB as it is, or HLS as the
+// hue vector (x, y) then l & s, alpha last if there is one. A row pushed into a stage emits every
+// output row it completes: the rows are combined down, then across into the next stage's ring (or a
+// row buffer, at the last), decoded & handed to the sink, & pushed on into that stage in turn.
+//====================================================================================================
+
+class e1nPyramidBuilder
+{
+public:
+
+    // Receives each finished row of a level in decoded form; c[3] is null without alpha.
+    typedef function<void(const int level, const int row, const float *const *c)> Sink;
+
+private:
+
+    struct Stage
+    {
+        int           inCols, inRows;
+        int           outCols, outRows;
+        int           received;         // Input rows pushed so far.
+        int           emitted;          // Output rows finished so far.
+        vector<float> ring;             // taps rows of channels rows of span floats.
+        vector<float> column;           // The rows combined, one row per channel, before the pass across.
+    };
+
+    int           channels;             // Working channels: 3 or 4 for RGB, 4 or 5 for HLS.
+    int           taps;                 // Rows per output row: 2 or 5.
+    int           span;                 // Floats per working row, pads included.
+    bool          hls;
+    bool          alpha;
+    Size          size;
+    vector<Stage> stages;
+    vector<float> last;                 // The last level's output row.
+    vector<float> hue;                  // Decoded hue, for the sink.
+    Sink          sink;
+
+    const e1nKernelTable &kernels;      // Picked once, for the whole pass.
+
+    float *Slot(const int stage, const int row, const int channel);
+    void   Push(const int stage, const int row);
+    void   Emit(const int stage, const int row);
+
+public:
+
+    e1nPyramidBuilder(const Size &imageSize, const int maxLevel, const bool withAlpha, const e1nPyramidOptions &options);
+
+    int  Levels() const;                                    // Levels past the source.
+    Size LevelSize(const int level) const;
+
+    void SetSink(const Sink &newSink);
+
+    // Where source row `row` goes, in decoded form (c[3] null without alpha), & then pushing it.
+    // Only for a builder with at least one level.
+    void InputRow(const int row, float **c);
+    void PushInput(const int row);
+};
+
+// Reflects a row or column index back into 0 to n - 1, without repeating the edge (BORDER_REFLECT_101).
+static int Reflect101(int i, const int n)
+{
+    if (n == 1) {return 0;}
+
+    for (;;)
+    {
+        if      (i < 0)  {i = -i;}
+        else if (i >= n) {i = 2 * n - 2 - i;}
+        else             {return i;}
+    }
+}
+
+e1nPyramidBuilder::e1nPyramidBuilder(const Size &imageSize, const int maxLevel, const bool withAlpha, const e1nPyramidOptions &options)
+    : kernels(e1nGetKernels())
+{
+    CV_Assert(options.filter == E1N_PYRAMID_BOX || options.filter == E1N_PYRAMID_GAUSSIAN);
+
+    hls      = options.hls;
+    alpha    = withAlpha;
+    channels = (hls ? 4 : 3) + (alpha ? 1 : 0);
+    taps     = options.filter == E1N_PYRAMID_BOX ? 2 : 5;
+    size     = imageSize;
+    span     = imageSize.width + 2 * E1N_PYRAMID_PAD;
+
+    Size in = imageSize;
+
+    for (int level = 0; level < maxLevel && (in.width > 1 || in.height > 1); ++level)
+    {
+        Stage stage;
+
+        stage.inCols   = in.width;
+        stage.inRows   = in.height;
+        stage.outCols  = (in.width + 1) / 2;
+        stage.outRows  = (in.height + 1) / 2;
+        stage.received = 0;
+        stage.emitted  = 0;
+
+        stage.ring.assign((size_t) taps * channels * span, 0.0f);
+        stage.column.assign((size_t) channels * span, 0.0f);
+
+        stages.push_back(stage);
+
+        in = Size(stage.outCols, stage.outRows);
+    }
+
+    last.assign((size_t) channels * span, 0.0f);
+    hue.assign(span, 0.0f);
+}
+
+inline int  e1nPyramidBuilder::Levels() const             {return (int) stages.size();}
+inline void e1nPyramidBuilder::SetSink(const Sink &newSink) {sink = newSink;}
+
+Size e1nPyramidBuilder::LevelSize(const int level) const
+{
+    return level == 0 ? size : Size(stages[level - 1].outCols, stages[level - 1].outRows);
+}
+
+// The first pixel of a row of one channel in a stage's ring.
+inline float *e1nPyramidBuilder::Slot(const int stage, const int row, const int channel)
+{
+    return &stages[stage].ring[((size_t) (row % taps) * channels + channel) * span + E1N_PYRAMID_PAD];
+}
+
+void e1nPyramidBuilder::InputRow(const int row, float **c)
+{
+    if (hls)
+    {
+        c[0] = Slot(0, row, 0);                             // h, turned into x in place by PushInput().
+        c[1] = Slot(0, row, 2);
+        c[2] = Slot(0, row, 3);
+        c[3] = alpha ? Slot(0, row, 4) : nullptr;
+    }
+    else
+    {
+        for (int k = 0; k < 3; ++k) {c[k] = Slot(0, row, k);}
+
+        c[3] = alpha ? Slot(0, row, 3) : nullptr;
+    }
+}
+
+void e1nPyramidBuilder::PushInput(const int row)
+{
+    if (hls) {kernels.hueToVector(Slot(0, row, 0), Slot(0, row, 1), Slot(0, row, 3), size.width);}
+
+    Push(0, row);
+}
+
+// Takes a stage's next input row & finishes every output row it completes.
+void e1nPyramidBuilder::Push(const int stage, const int row)
+{
+    Stage &s = stages[stage];
+
+    s.received = row + 1;
+
+    while (s.emitted < s.outRows)
+    {
+        int needed = min(2 * s.emitted + (taps == 2 ? 1 : 2), s.inRows - 1);
+
+        if (needed >= s.received) {break;}
+
+        Emit(stage, s.emitted++);
+    }
+}
+
+void e1nPyramidBuilder::Emit(const int stage, const int row)
+{
+    Stage &s     = stages[stage];
+    bool   final = stage + 1 == Levels();
+
+    float *out[5];
+
+    for (int k = 0; k < channels; ++k)
+    {
+        float *v = &s.column[(size_t) k * span + E1N_PYRAMID_PAD];
+
+        out[k] = final ? &last[(size_t) k * span + E1N_PYRAMID_PAD] : Slot(stage + 1, row, k);
+
+        // Down the rows...
+        if (taps == 2)
+        {
+            kernels.reduceRows2(Slot(stage, 2 * row, k), Slot(stage, min(2 * row + 1, s.inRows - 1), k), v, s.inCols);
+        }
+        else
+        {
+            const float *r[5];
+
+            for (int t = 0; t < 5; ++t) {r[t] = Slot(stage, Reflect101(2 * row - 2 + t, s.inRows), k);}
+
+            kernels.reduceRows5(r, v, s.inCols);
+        }
+
+        // ...& across. An odd last column pairs with itself in the box; the binomial reflects.
+        if (taps == 2)
+        {
+            v[s.inCols] = v[s.inCols - 1];
+
+            kernels.reduceCols2(v, out[k], s.outCols);
+        }
+        else
+        {
+            for (int i = 1; i <= 2; ++i)
+            {
+                v[-i]               = v[Reflect101(-i, s.inCols)];
+                v[s.inCols - 1 + i] = v[Reflect101(s.inCols - 1 + i, s.inCols)];
+            }
+
+            kernels.reduceCols5(v - 2, out[k], s.outCols);
+        }
+    }
+
+    if (sink)
+    {
+        const float *c[4];
+
+        if (hls)
+        {
+            kernels.vectorToHue(out[0], out[1], hue.data(), s.outCols);
+
+            c[0] = hue.data();
+            c[1] = out[2];
+            c[2] = out[3];
+            c[3] = alpha ? out[4] : nullptr;
+        }
+        else
+        {
+            c[0] = out[0];
+            c[1] = out[1];
+            c[2] = out[2];
+            c[3] = alpha ? out[3] : nullptr;
+        }
+
+        sink(stage + 1, row, c);
+    }
+
+    if (!final) {Push(stage + 1, row);}
+}
+
+//====================================================================================================
+// Public functions:
+//====================================================================================================
+
+static void CheckImage(const Mat &image)
+{
+    int type = image.type();
+
+    CV_Assert(type == CV_8UC3 || type == CV_8UC4 || type == CV_32FC3 || type == CV_32FC4);
+}
+
+// Streams a Mat's rows through a builder.
+static void RunMat(e1nPyramidBuilder &builder, const Mat &image)
+{
+    if (builder.Levels() == 0) {return;}
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        float *c[4];
+
+        builder.InputRow(row, c);
+        e1nUnpackRow(image, row, 0, image.cols, c[0], c[1], c[2], c[3]);
+        builder.PushInput(row);
+    }
+}
+
+void e1nBuildPyramid(const Mat &image, vector<Mat> &levels, const int maxLevel, const e1nPyramidOptions &options)
+{
+    CheckImage(image);
+
+    // Held in case image is one of the levels about to be reallocated.
+    Mat               input = image;
+    e1nPyramidBuilder builder(input.size(), maxLevel, input.channels() == 4, options);
+
+    E1N_TRACE_OP("e1nBuildPyramid", input.total(), input.total() * input.elemSize() * 4 / 3);
+
+    levels.resize(builder.Levels() + 1);
+    levels[0] = input;
+
+    for (int level = 1; level <= builder.Levels(); ++level) {levels[level].create(builder.LevelSize(level), input.type());}
+
+    builder.SetSink([&](const int level, const int row, const float *const *c)
+    {
+        e1nPackRow(levels[level], row, 0, levels[level].cols, c[0], c[1], c[2], c[3]);
+    });
+
+    RunMat(builder, input);
+}
+
+void e1nBuildPyramid(const e1nColorPlanes &planes, vector<e1nColorPlanes> &levels, const int maxLevel, const e1nPyramidOptions &options)
+{
+    e1nColorPlanes    input = planes;
+    e1nPyramidBuilder builder(Size(input.Cols(), input.Rows()), maxLevel, input.HasAlpha(), options);
+    int               count = input.HasAlpha() ? 4 : 3;
+
+    E1N_TRACE_OP("e1nBuildPyramid", (uint64_t) input.Rows() * input.Cols(), (uint64_t) input.Rows() * input.Cols() * count * 4 * 4 / 3);
+
+    levels.resize(builder.Levels() + 1);
+    levels[0] = input;
+
+    for (int level = 1; level <= builder.Levels(); ++level)
+    {
+        Size size = builder.LevelSize(level);
+
+        levels[level].Create(size.height, size.width, input.HasAlpha());
+    }
+
+    builder.SetSink([&](const int level, const int row, const float *const *c)
+    {
+        for (int k = 0; k < count; ++k) {memcpy(levels[level].Row(k, row), c[k], levels[level].Cols() * sizeof(float));}
+    });
+
+    for (int row = 0; row < input.Rows() && builder.Levels() > 0; ++row)
+    {
+        float *c[4];
+
+        builder.InputRow(row, c);
+
+        for (int k = 0; k < count; ++k) {memcpy(c[k], input.Row(k, row), input.Cols() * sizeof(float));}
+
+        builder.PushInput(row);
+    }
+}
+
+void e1nPyrDown(const Mat &src, Mat &dst, const int halvings, const e1nPyramidOptions &options)
+{
+    CheckImage(src);
+
+    Mat               input = src;
+    e1nPyramidBuilder builder(input.size(), halvings, input.channels() == 4, options);
+
+    if (builder.Levels() == 0)
+    {
+        dst = input.clone();
+        return;
+    }
+
+    E1N_TRACE_OP("e1nPyrDown", input.total(), input.total() * input.elemSize());
+
+    int last = builder.Levels();
+    Mat result(builder.LevelSize(last), input.type());
+
+    builder.SetSink([&](const int level, const int row, const float *const *c)
+    {
+        if (level == last) {e1nPackRow(result, row, 0, result.cols, c[0], c[1], c[2], c[3]);}
+    });
+
+    RunMat(builder, input);
+
+    dst = result;
+}
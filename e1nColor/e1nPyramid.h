@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nPyramid.h - Interface definition file for e1nColor's hue-aware image pyramids & downscaling.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NPYRAMID_H
+#define E1NPYRAMID_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Pyramids halve an image level by level, (w + 1) / 2 by (h + 1) / 2 each time, for thumbnails &
+// coarse-to-fine work. They take RGB, or HLS as it stands, so an HLS image never has to go back to
+// RGB just to be resized:
+//
+//     e1nPyramidOptions options;
+//
+//     options.hls = true;
+//
+//     e1nBuildPyramid(hlsImage, levels, 4, options);          // levels[0] is hlsImage, [4] 1/16th.
+//
+//     Averaging hue as a plain number mixes reds on either side of 0 into cyan, so HLS hue is averaged
+// on the circle instead, weighted by saturation (see HueToVector() in e1nColorKernels.h); lightness &
+// saturation average as usual. RGB & alpha average as they are, without premultiplying.
+//
+//     Every level comes out of one streaming pass over the source: each source row is read once,
+// reduced into a few rows of ring buffer per level, & each finished row is handed straight down to
+// the next level, so nothing coarser than the source is ever read back from memory. Levels carry
+// full float precision (& the hue vectors) between them, whatever the output type. The reductions
+// are SIMD. The pass runs on the calling thread, since each row depends on the ones above it; many
+// images at once go across threads with e1nBatchRunner.
+//
+//     Supported types: CV_8UC3/4 & CV_32FC3/4, with every level the source's type.
+//====================================================================================================
+
+enum e1nPyramidFilter
+{
+    E1N_PYRAMID_BOX,                    // 2 x 2 average.
+    E1N_PYRAMID_GAUSSIAN                // 5 x 5 binomial, as cv::pyrDown(); borders reflect (101).
+};
+
+struct e1nPyramidOptions
+{
+    bool hls;                           // The image is (h, l, s), not RGB.
+    int  filter;                        // An e1nPyramidFilter.
+
+    e1nPyramidOptions() : hls(false), filter(E1N_PYRAMID_GAUSSIAN) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Builds levels 0 to maxLevel, fewer if the image reaches 1 x 1 first. Level 0 shares the
+// source's pixels (a Mat header, or a copy of the planes' handle); the rest are (re)allocated.
+//----------------------------------------------------------------------------------------------------
+
+void e1nBuildPyramid(const Mat &image, vector<Mat> &levels, const int maxLevel,
+                     const e1nPyramidOptions &options = e1nPyramidOptions());
+
+void e1nBuildPyramid(const e1nColorPlanes &planes, vector<e1nColorPlanes> &levels, const int maxLevel,
+                     const e1nPyramidOptions &options = e1nPyramidOptions());
+
+//----------------------------------------------------------------------------------------------------
+//     Downscales by 2^halvings in the same single pass, keeping only the smallest level; the ones in
+// between only ever exist as ring-buffer rows. src & dst may be the same Mat.
+//----------------------------------------------------------------------------------------------------
+
+void e1nPyrDown(const Mat &src, Mat &dst, const int halvings = 1, const e1nPyramidOptions &options = e1nPyramidOptions());
+
+#endif     // E1NPYRAMID_H
@@ -0,0 +1,459 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nSimd.h - Thin SIMD register wrappers used by the e1nColor batch kernels.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NSIMD_H
+#define E1NSIMD_H
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Instruction set levels, for E1N_SIMD_LEVEL.
+#define E1N_SIMD_SCALAR 0
+#define E1N_SIMD_SSE4   1
+#define E1N_SIMD_AVX2   2
+#define E1N_SIMD_AVX512 3
+
+//     The level the wrappers are built for. By default it follows the compiler flags; the per-ISA
+// kernel files (e1nCpu*.cpp) define it themselves before including this, since a target pragma
+// enables the instructions without defining __AVX2__ & co.
+#if !defined(E1N_SIMD_LEVEL)
+#if   defined(__AVX512F__)
+#define E1N_SIMD_LEVEL E1N_SIMD_AVX512
+#elif defined(__AVX2__)
+#define E1N_SIMD_LEVEL E1N_SIMD_AVX2
+#elif defined(__SSE4_1__)
+#define E1N_SIMD_LEVEL E1N_SIMD_SSE4
+#else
+#define E1N_SIMD_LEVEL E1N_SIMD_SCALAR
+#endif
+#endif
+
+#if E1N_SIMD_LEVEL > E1N_SIMD_SCALAR
+#include <immintrin.h>
+#endif
+
+//     Everything is declared inside an inline namespace named for the level, so kernels built for
+// different levels in one program are different functions to the linker & an AVX2 copy of a template
+// can never stand in for the one a scalar caller was built against.
+#if   E1N_SIMD_LEVEL == E1N_SIMD_AVX512
+#define E1N_SIMD_ISA e1nIsaAVX512
+#elif E1N_SIMD_LEVEL == E1N_SIMD_AVX2
+#define E1N_SIMD_ISA e1nIsaAVX2
+#elif E1N_SIMD_LEVEL == E1N_SIMD_SSE4
+#define E1N_SIMD_ISA e1nIsaSSE4
+#else
+#define E1N_SIMD_ISA e1nIsaScalar
+#endif
+
+//====================================================================================================
+//     Every wrapper below exposes the same small vocabulary (loads, stores, arithmetic, comparisons
+// and selects), so the kernels in e1nColorKernels.h can be written once as templates and then
+// instantiated for whichever register width E1N_SIMD_LEVEL allows; e1nCpuDispatch.h picks between
+// the levels at runtime. The scalar wrapper is always available and doubles as the tail handler for
+// the wide ones.
+//====================================================================================================
+
+namespace e1nSimd
+{
+inline namespace E1N_SIMD_ISA
+{
+
+//----------------------------------------------------------------------------------------------------
+// Scalar (one lane):
+//----------------------------------------------------------------------------------------------------
+
+struct e1nM32x1
+{
+    bool m;
+
+    e1nM32x1() {}
+    e1nM32x1(const bool x) : m(x) {}
+};
+
+struct e1nF32x1
+{
+    typedef e1nM32x1 Mask;
+    static const int Width = 1;
+
+    float v;
+
+    e1nF32x1() {}
+    e1nF32x1(const float x) : v(x) {}
+
+    static e1nF32x1 Load(const float *p) {return p[0];}
+    void            Store(float *p) const {p[0] = v;}
+};
+
+inline e1nF32x1 operator +(const e1nF32x1 a, const e1nF32x1 b) {return a.v + b.v;}
+inline e1nF32x1 operator -(const e1nF32x1 a, const e1nF32x1 b) {return a.v - b.v;}
+inline e1nF32x1 operator *(const e1nF32x1 a, const e1nF32x1 b) {return a.v * b.v;}
+inline e1nF32x1 operator /(const e1nF32x1 a, const e1nF32x1 b) {return a.v / b.v;}
+
+inline e1nM32x1 operator ==(const e1nF32x1 a, const e1nF32x1 b) {return a.v == b.v;}
+inline e1nM32x1 operator !=(const e1nF32x1 a, const e1nF32x1 b) {return a.v != b.v;}
+inline e1nM32x1 operator < (const e1nF32x1 a, const e1nF32x1 b) {return a.v <  b.v;}
+inline e1nM32x1 operator <=(const e1nF32x1 a, const e1nF32x1 b) {return a.v <= b.v;}
+inline e1nM32x1 operator > (const e1nF32x1 a, const e1nF32x1 b) {return a.v >  b.v;}
+inline e1nM32x1 operator >=(const e1nF32x1 a, const e1nF32x1 b) {return a.v >= b.v;}
+
+inline e1nM32x1 operator &(const e1nM32x1 a, const e1nM32x1 b) {return a.m && b.m;}
+inline e1nM32x1 operator |(const e1nM32x1 a, const e1nM32x1 b) {return a.m || b.m;}
+inline e1nM32x1 AndNot    (const e1nM32x1 a, const e1nM32x1 b) {return a.m && !b.m;}     // a & ~b
+
+inline e1nF32x1 Min   (const e1nF32x1 a, const e1nF32x1 b) {return b.v < a.v ? b.v : a.v;}
+inline e1nF32x1 Max   (const e1nF32x1 a, const e1nF32x1 b) {return b.v > a.v ? b.v : a.v;}
+inline e1nF32x1 Abs   (const e1nF32x1 a)                   {return std::fabs(a.v);}
+inline e1nF32x1 Floor (const e1nF32x1 a)                   {return std::floor(a.v);}
+inline e1nF32x1 Sqrt  (const e1nF32x1 a)                   {return std::sqrt(a.v);}
+inline e1nF32x1 Select(const e1nM32x1 m, const e1nF32x1 a, const e1nF32x1 b) {return m.m ? a : b;}
+
+// Bit-level pieces of log2 / exp2, for positive normal floats & integral n in [-126, 127].
+inline e1nF32x1 Exponent(const e1nF32x1 a)  {uint32_t i; memcpy(&i, &a.v, 4); return (float) ((int) (i >> 23) - 127);}
+inline e1nF32x1 Mantissa(const e1nF32x1 a)  {uint32_t i; memcpy(&i, &a.v, 4); i = (i & 0x007FFFFFu) | 0x3F800000u; float f; memcpy(&f, &i, 4); return f;}
+inline e1nF32x1 Pow2    (const e1nF32x1 n)  {uint32_t i = (uint32_t) ((int) n.v + 127) << 23; float f; memcpy(&f, &i, 4); return f;}
+
+// Table lookup; each lane of index holds a whole number of floats past base.
+inline e1nF32x1 Gather(const float *base, const e1nF32x1 index) {return base[(int) index.v];}
+
+// Splits 2 * Width consecutive floats into their even & odd elements.
+inline void Deinterleave2(const float *p, e1nF32x1 &even, e1nF32x1 &odd) {even = p[0]; odd = p[1];}
+
+// Truncates each lane to an integer & stores it as a byte; lanes must already be in 0-255.
+inline void StoreBytes(const e1nF32x1 a, unsigned char *p) {p[0] = (unsigned char) a.v;}
+
+// The same as 16-bit words; lanes must already be in 0-65535.
+inline void StoreWords(const e1nF32x1 a, unsigned short *p) {p[0] = (unsigned short) a.v;}
+
+//----------------------------------------------------------------------------------------------------
+// SSE4.1 (four lanes):
+//----------------------------------------------------------------------------------------------------
+
+#if E1N_SIMD_LEVEL >= E1N_SIMD_SSE4
+
+struct e1nM32x4
+{
+    __m128 m;
+
+    e1nM32x4() {}
+    e1nM32x4(const __m128 x) : m(x) {}
+};
+
+struct e1nF32x4
+{
+    typedef e1nM32x4 Mask;
+    static const int Width = 4;
+
+    __m128 v;
+
+    e1nF32x4() {}
+    e1nF32x4(const __m128 x) : v(x) {}
+    e1nF32x4(const float x)  : v(_mm_set1_ps(x)) {}
+
+    static e1nF32x4 Load(const float *p) {return _mm_loadu_ps(p);}
+    void            Store(float *p) const {_mm_storeu_ps(p, v);}
+};
+
+inline e1nF32x4 operator +(const e1nF32x4 a, const e1nF32x4 b) {return _mm_add_ps(a.v, b.v);}
+inline e1nF32x4 operator -(const e1nF32x4 a, const e1nF32x4 b) {return _mm_sub_ps(a.v, b.v);}
+inline e1nF32x4 operator *(const e1nF32x4 a, const e1nF32x4 b) {return _mm_mul_ps(a.v, b.v);}
+inline e1nF32x4 operator /(const e1nF32x4 a, const e1nF32x4 b) {return _mm_div_ps(a.v, b.v);}
+
+inline e1nM32x4 operator ==(const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmpeq_ps (a.v, b.v);}
+inline e1nM32x4 operator !=(const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmpneq_ps(a.v, b.v);}
+inline e1nM32x4 operator < (const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmplt_ps (a.v, b.v);}
+inline e1nM32x4 operator <=(const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmple_ps (a.v, b.v);}
+inline e1nM32x4 operator > (const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmpgt_ps (a.v, b.v);}
+inline e1nM32x4 operator >=(const e1nF32x4 a, const e1nF32x4 b) {return _mm_cmpge_ps (a.v, b.v);}
+
+inline e1nM32x4 operator &(const e1nM32x4 a, const e1nM32x4 b) {return _mm_and_ps(a.m, b.m);}
+inline e1nM32x4 operator |(const e1nM32x4 a, const e1nM32x4 b) {return _mm_or_ps (a.m, b.m);}
+inline e1nM32x4 AndNot    (const e1nM32x4 a, const e1nM32x4 b) {return _mm_andnot_ps(b.m, a.m);}
+
+inline e1nF32x4 Min   (const e1nF32x4 a, const e1nF32x4 b) {return _mm_min_ps(b.v, a.v);}
+inline e1nF32x4 Max   (const e1nF32x4 a, const e1nF32x4 b) {return _mm_max_ps(b.v, a.v);}
+inline e1nF32x4 Abs   (const e1nF32x4 a)                   {return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);}
+inline e1nF32x4 Floor (const e1nF32x4 a)                   {return _mm_floor_ps(a.v);}
+inline e1nF32x4 Sqrt  (const e1nF32x4 a)                   {return _mm_sqrt_ps(a.v);}
+inline e1nF32x4 Select(const e1nM32x4 m, const e1nF32x4 a, const e1nF32x4 b) {return _mm_blendv_ps(b.v, a.v, m.m);}
+
+inline e1nF32x4 Exponent(const e1nF32x4 a)
+{
+    return _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(a.v), 23), _mm_set1_epi32(127)));
+}
+
+inline e1nF32x4 Mantissa(const e1nF32x4 a)
+{
+    return _mm_or_ps(_mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x007FFFFF))), _mm_set1_ps(1.0f));
+}
+
+inline e1nF32x4 Pow2(const e1nF32x4 n)
+{
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127)), 23));
+}
+
+// SSE has no gather instruction, so the lanes are looked up one at a time.
+inline e1nF32x4 Gather(const float *base, const e1nF32x4 index)
+{
+    alignas(16) int32_t i[4];
+
+    _mm_store_si128((__m128i *) i, _mm_cvttps_epi32(index.v));
+
+    return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+}
+
+inline void Deinterleave2(const float *p, e1nF32x4 &even, e1nF32x4 &odd)
+{
+    __m128 a = _mm_loadu_ps(p);
+    __m128 b = _mm_loadu_ps(p + 4);
+
+    even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    odd  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void StoreBytes(const e1nF32x4 a, unsigned char *p)
+{
+    __m128i i = _mm_cvttps_epi32(a.v);
+
+    i = _mm_packus_epi32(i, i);
+    i = _mm_packus_epi16(i, i);
+
+    int32_t x = _mm_cvtsi128_si32(i);
+
+    memcpy(p, &x, 4);
+}
+
+inline void StoreWords(const e1nF32x4 a, unsigned short *p)
+{
+    __m128i i = _mm_cvttps_epi32(a.v);
+
+    _mm_storel_epi64((__m128i *) p, _mm_packus_epi32(i, i));
+}
+
+#endif  // E1N_SIMD_SSE4
+
+//----------------------------------------------------------------------------------------------------
+// AVX2 (eight lanes):
+//----------------------------------------------------------------------------------------------------
+
+#if E1N_SIMD_LEVEL >= E1N_SIMD_AVX2
+
+struct e1nM32x8
+{
+    __m256 m;
+
+    e1nM32x8() {}
+    e1nM32x8(const __m256 x) : m(x) {}
+};
+
+struct e1nF32x8
+{
+    typedef e1nM32x8 Mask;
+    static const int Width = 8;
+
+    __m256 v;
+
+    e1nF32x8() {}
+    e1nF32x8(const __m256 x) : v(x) {}
+    e1nF32x8(const float x)  : v(_mm256_set1_ps(x)) {}
+
+    static e1nF32x8 Load(const float *p) {return _mm256_loadu_ps(p);}
+    void            Store(float *p) const {_mm256_storeu_ps(p, v);}
+};
+
+inline e1nF32x8 operator +(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_add_ps(a.v, b.v);}
+inline e1nF32x8 operator -(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_sub_ps(a.v, b.v);}
+inline e1nF32x8 operator *(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_mul_ps(a.v, b.v);}
+inline e1nF32x8 operator /(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_div_ps(a.v, b.v);}
+
+inline e1nM32x8 operator ==(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ);}
+inline e1nM32x8 operator !=(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ);}
+inline e1nM32x8 operator < (const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);}
+inline e1nM32x8 operator <=(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ);}
+inline e1nM32x8 operator > (const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);}
+inline e1nM32x8 operator >=(const e1nF32x8 a, const e1nF32x8 b) {return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ);}
+
+inline e1nM32x8 operator &(const e1nM32x8 a, const e1nM32x8 b) {return _mm256_and_ps(a.m, b.m);}
+inline e1nM32x8 operator |(const e1nM32x8 a, const e1nM32x8 b) {return _mm256_or_ps (a.m, b.m);}
+inline e1nM32x8 AndNot    (const e1nM32x8 a, const e1nM32x8 b) {return _mm256_andnot_ps(b.m, a.m);}
+
+inline e1nF32x8 Min   (const e1nF32x8 a, const e1nF32x8 b) {return _mm256_min_ps(b.v, a.v);}
+inline e1nF32x8 Max   (const e1nF32x8 a, const e1nF32x8 b) {return _mm256_max_ps(b.v, a.v);}
+inline e1nF32x8 Abs   (const e1nF32x8 a)                   {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v);}
+inline e1nF32x8 Floor (const e1nF32x8 a)                   {return _mm256_floor_ps(a.v);}
+inline e1nF32x8 Sqrt  (const e1nF32x8 a)                   {return _mm256_sqrt_ps(a.v);}
+inline e1nF32x8 Select(const e1nM32x8 m, const e1nF32x8 a, const e1nF32x8 b) {return _mm256_blendv_ps(b.v, a.v, m.m);}
+
+inline e1nF32x8 Exponent(const e1nF32x8 a)
+{
+    return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(a.v), 23), _mm256_set1_epi32(127)));
+}
+
+inline e1nF32x8 Mantissa(const e1nF32x8 a)
+{
+    return _mm256_or_ps(_mm256_and_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF))), _mm256_set1_ps(1.0f));
+}
+
+inline e1nF32x8 Pow2(const e1nF32x8 n)
+{
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127)), 23));
+}
+
+inline e1nF32x8 Gather(const float *base, const e1nF32x8 index)
+{
+    return _mm256_i32gather_ps(base, _mm256_cvttps_epi32(index.v), 4);
+}
+
+// The shuffles work within 128-bit halves, so the 64-bit quarters come out as (a0, b0, a1, b1).
+inline void Deinterleave2(const float *p, e1nF32x8 &even, e1nF32x8 &odd)
+{
+    __m256 a = _mm256_loadu_ps(p);
+    __m256 b = _mm256_loadu_ps(p + 8);
+
+    even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+    odd  = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+inline void StoreBytes(const e1nF32x8 a, unsigned char *p)
+{
+    __m256i i = _mm256_cvttps_epi32(a.v);
+    __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+
+    _mm_storel_epi64((__m128i *) p, _mm_packus_epi16(w, w));
+}
+
+inline void StoreWords(const e1nF32x8 a, unsigned short *p)
+{
+    __m256i i = _mm256_cvttps_epi32(a.v);
+
+    _mm_storeu_si128((__m128i *) p, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+
+#endif  // E1N_SIMD_AVX2
+
+//----------------------------------------------------------------------------------------------------
+//     AVX-512F (sixteen lanes). Comparisons give a bit per lane in a k register rather than a lane of
+// ones, so masks combine with plain integer logic. Only AVX-512F is assumed; the float forms of and /
+// or are DQ instructions, so the bit-level pieces go through the integer ones.
+//----------------------------------------------------------------------------------------------------
+
+#if E1N_SIMD_LEVEL >= E1N_SIMD_AVX512
+
+struct e1nM32x16
+{
+    __mmask16 m;
+
+    e1nM32x16() {}
+    e1nM32x16(const __mmask16 x) : m(x) {}
+};
+
+struct e1nF32x16
+{
+    typedef e1nM32x16 Mask;
+    static const int Width = 16;
+
+    __m512 v;
+
+    e1nF32x16() {}
+    e1nF32x16(const __m512 x) : v(x) {}
+    e1nF32x16(const float x)  : v(_mm512_set1_ps(x)) {}
+
+    static e1nF32x16 Load(const float *p) {return _mm512_loadu_ps(p);}
+    void             Store(float *p) const {_mm512_storeu_ps(p, v);}
+};
+
+inline e1nF32x16 operator +(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_add_ps(a.v, b.v);}
+inline e1nF32x16 operator -(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_sub_ps(a.v, b.v);}
+inline e1nF32x16 operator *(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_mul_ps(a.v, b.v);}
+inline e1nF32x16 operator /(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_div_ps(a.v, b.v);}
+
+inline e1nM32x16 operator ==(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ);}
+inline e1nM32x16 operator !=(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_NEQ_UQ);}
+inline e1nM32x16 operator < (const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ);}
+inline e1nM32x16 operator <=(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ);}
+inline e1nM32x16 operator > (const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ);}
+inline e1nM32x16 operator >=(const e1nF32x16 a, const e1nF32x16 b) {return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ);}
+
+inline e1nM32x16 operator &(const e1nM32x16 a, const e1nM32x16 b) {return (__mmask16) (a.m & b.m);}
+inline e1nM32x16 operator |(const e1nM32x16 a, const e1nM32x16 b) {return (__mmask16) (a.m | b.m);}
+inline e1nM32x16 AndNot    (const e1nM32x16 a, const e1nM32x16 b) {return (__mmask16) (a.m & ~b.m);}
+
+inline e1nF32x16 Min   (const e1nF32x16 a, const e1nF32x16 b) {return _mm512_min_ps(b.v, a.v);}
+inline e1nF32x16 Max   (const e1nF32x16 a, const e1nF32x16 b) {return _mm512_max_ps(b.v, a.v);}
+inline e1nF32x16 Floor (const e1nF32x16 a)                    {return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);}
+inline e1nF32x16 Sqrt  (const e1nF32x16 a)                    {return _mm512_sqrt_ps(a.v);}
+inline e1nF32x16 Select(const e1nM32x16 m, const e1nF32x16 a, const e1nF32x16 b) {return _mm512_mask_blend_ps(m.m, b.v, a.v);}
+
+inline e1nF32x16 Abs(const e1nF32x16 a)
+{
+    return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x7FFFFFFF)));
+}
+
+inline e1nF32x16 Exponent(const e1nF32x16 a)
+{
+    return _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(_mm512_castps_si512(a.v), 23), _mm512_set1_epi32(127)));
+}
+
+inline e1nF32x16 Mantissa(const e1nF32x16 a)
+{
+    __m512i i = _mm512_and_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x007FFFFF));
+
+    return _mm512_castsi512_ps(_mm512_or_si512(i, _mm512_set1_epi32(0x3F800000)));
+}
+
+inline e1nF32x16 Pow2(const e1nF32x16 n)
+{
+    return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n.v), _mm512_set1_epi32(127)), 23));
+}
+
+inline e1nF32x16 Gather(const float *base, const e1nF32x16 index)
+{
+    return _mm512_i32gather_ps(_mm512_cvttps_epi32(index.v), base, 4);
+}
+
+// One two-source permute per half gathers the elements straight across both registers.
+inline void Deinterleave2(const float *p, e1nF32x16 &even, e1nF32x16 &odd)
+{
+    __m512 a = _mm512_loadu_ps(p);
+    __m512 b = _mm512_loadu_ps(p + 16);
+
+    even = _mm512_permutex2var_ps(a, _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30), b);
+    odd  = _mm512_permutex2var_ps(a, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31), b);
+}
+
+// The conversion saturates on the way down, so no packing is needed.
+inline void StoreBytes(const e1nF32x16 a, unsigned char *p)
+{
+    _mm_storeu_si128((__m128i *) p, _mm512_cvtusepi32_epi8(_mm512_cvttps_epi32(a.v)));
+}
+
+inline void StoreWords(const e1nF32x16 a, unsigned short *p)
+{
+    _mm256_storeu_si256((__m256i *) p, _mm512_cvtusepi32_epi16(_mm512_cvttps_epi32(a.v)));
+}
+
+#endif  // E1N_SIMD_AVX512
+
+//----------------------------------------------------------------------------------------------------
+// The widest wrapper the level allows:
+//----------------------------------------------------------------------------------------------------
+
+#if   E1N_SIMD_LEVEL >= E1N_SIMD_AVX512
+typedef e1nF32x16 e1nF32xN;
+#elif E1N_SIMD_LEVEL >= E1N_SIMD_AVX2
+typedef e1nF32x8 e1nF32xN;
+#elif E1N_SIMD_LEVEL >= E1N_SIMD_SSE4
+typedef e1nF32x4 e1nF32xN;
+#else
+typedef e1nF32x1 e1nF32xN;
+#endif
+
+}   // inline namespace E1N_SIMD_ISA
+}   // namespace e1nSimd
+
+#endif     // E1NSIMD_H
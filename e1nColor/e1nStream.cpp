@@ -0,0 +1,698 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nStream.cpp - Implementation file for e1nColor's out-of-core (streaming) processing.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nStream.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <cstring>
+#include <future>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+// TIFF tags & field types used by the reader & writer.
+#define TIFF_TAG_IMAGE_WIDTH        256
+#define TIFF_TAG_IMAGE_LENGTH       257
+#define TIFF_TAG_BITS_PER_SAMPLE    258
+#define TIFF_TAG_COMPRESSION        259
+#define TIFF_TAG_PHOTOMETRIC        262
+#define TIFF_TAG_STRIP_OFFSETS      273
+#define TIFF_TAG_SAMPLES_PER_PIXEL  277
+#define TIFF_TAG_ROWS_PER_STRIP     278
+#define TIFF_TAG_STRIP_BYTE_COUNTS  279
+#define TIFF_TAG_PLANAR_CONFIG      284
+#define TIFF_TAG_EXTRA_SAMPLES      338
+#define TIFF_TAG_SAMPLE_FORMAT      339
+
+#define TIFF_SHORT 3
+#define TIFF_LONG  4
+
+//====================================================================================================
+// Platform file mapping:
+//====================================================================================================
+
+struct e1nMapHandle
+{
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int    fd;
+#endif
+};
+
+static size_t PageSize()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return (size_t) sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static bool HostIsLittleEndian()
+{
+    uint16_t      one = 1;
+    unsigned char first;
+
+    memcpy(&first, &one, 1);
+
+    return first == 1;
+}
+
+//====================================================================================================
+// e1nMappedRaster - Constructors & Destructor:
+//====================================================================================================
+
+e1nMappedRaster::e1nMappedRaster()
+{
+    base         = nullptr;
+    length       = 0;
+    handle       = nullptr;
+    rows         = 0;
+    cols         = 0;
+    type         = 0;
+    rowsPerStrip = 1;
+    rowBytes     = 0;
+    contiguous   = false;
+}
+
+e1nMappedRaster::~e1nMappedRaster()
+{
+    Close();
+}
+
+//====================================================================================================
+// e1nMappedRaster - Opening & closing:
+//====================================================================================================
+
+void e1nMappedRaster::Map(const string &path)
+{
+    Close();
+
+    e1nMapHandle *h = new e1nMapHandle;
+
+#if defined(_WIN32)
+    h->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    LARGE_INTEGER size;
+
+    if (h->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(h->file, &size))
+    {
+        delete h;
+        CV_Error(Error::StsError, "e1nMappedRaster: can't open " + path);
+    }
+
+    h->mapping = CreateFileMappingA(h->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    base       = h->mapping ? (unsigned char *) MapViewOfFile(h->mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    length     = (size_t) size.QuadPart;
+
+    if (!base)
+    {
+        if (h->mapping) {CloseHandle(h->mapping);}
+        CloseHandle(h->file);
+        delete h;
+        CV_Error(Error::StsError, "e1nMappedRaster: can't map " + path);
+    }
+#else
+    struct stat info;
+
+    h->fd = open(path.c_str(), O_RDONLY);
+
+    if (h->fd < 0 || fstat(h->fd, &info) != 0)
+    {
+        if (h->fd >= 0) {close(h->fd);}
+        delete h;
+        CV_Error(Error::StsError, "e1nMappedRaster: can't open " + path);
+    }
+
+    length = (size_t) info.st_size;
+    void *p = length ? mmap(nullptr, length, PROT_READ, MAP_SHARED, h->fd, 0) : MAP_FAILED;
+
+    if (p == MAP_FAILED)
+    {
+        close(h->fd);
+        delete h;
+        length = 0;
+        CV_Error(Error::StsError, "e1nMappedRaster: can't map " + path);
+    }
+
+    base = (unsigned char *) p;
+
+    // We walk the file front to back, so ask for aggressive read-ahead.
+    madvise(base, length, MADV_SEQUENTIAL);
+#endif
+
+    handle = h;
+}
+
+void e1nMappedRaster::OpenRaw(const string &path, const int numRows, const int numCols, const int pixelType, const size_t headerBytes)
+{
+    CV_Assert(numRows > 0 && numCols > 0);
+
+    Map(path);
+
+    rows         = numRows;
+    cols         = numCols;
+    type         = pixelType;
+    rowBytes     = (size_t) numCols * CV_ELEM_SIZE(pixelType);
+    rowsPerStrip = numRows;
+    contiguous   = true;
+
+    rowOffsets.assign(1, headerBytes);
+
+    if (headerBytes + rowBytes * numRows > length)
+    {
+        Close();
+        CV_Error(Error::StsBadSize, "e1nMappedRaster: raw file is smaller than the image described");
+    }
+}
+
+void e1nMappedRaster::OpenTIFF(const string &path)
+{
+    Map(path);
+
+    try
+    {
+        ParseTIFF();
+    }
+    catch (...)
+    {
+        Close();
+        throw;
+    }
+}
+
+void e1nMappedRaster::Close()
+{
+    if (handle)
+    {
+        e1nMapHandle *h = (e1nMapHandle *) handle;
+
+#if defined(_WIN32)
+        UnmapViewOfFile(base);
+        CloseHandle(h->mapping);
+        CloseHandle(h->file);
+#else
+        munmap(base, length);
+        close(h->fd);
+#endif
+
+        delete h;
+    }
+
+    base   = nullptr;
+    length = 0;
+    handle = nullptr;
+    rows   = 0;
+    cols   = 0;
+
+    rowOffsets.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Reads the first IFD of a classic (non-Big) TIFF. Anything outside the baseline subset we can
+// stream straight out of the file (compression, planar layouts, palettes, tiles) is rejected.
+//----------------------------------------------------------------------------------------------------
+
+void e1nMappedRaster::ParseTIFF()
+{
+    if (length < 8) {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: not a TIFF file");}
+
+    bool little = base[0] == 'I' && base[1] == 'I';
+    bool big    = base[0] == 'M' && base[1] == 'M';
+
+    if (!little && !big) {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: not a TIFF file");}
+
+    const unsigned char *file = base;
+    size_t               size = length;
+
+    auto get16 = [&](const size_t at) -> uint32_t
+    {
+        if (at + 2 > size) {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: truncated TIFF");}
+        return little ? (uint32_t) (file[at] | file[at + 1] << 8) : (uint32_t) (file[at] << 8 | file[at + 1]);
+    };
+
+    auto get32 = [&](const size_t at) -> uint32_t
+    {
+        return little ? get16(at) | get16(at + 2) << 16 : get16(at) << 16 | get16(at + 2);
+    };
+
+    if (get16(2) != 42) {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: not a classic TIFF file");}
+
+    size_t ifd     = get32(4);
+    int    entries = (int) get16(ifd);
+
+    uint32_t width = 0, height = 0, bits = 8, compression = 1, samples = 1, stripRows = 0, planar = 1, format = 1;
+    vector<size_t> offsets;
+
+    for (int e = 0; e < entries; ++e)
+    {
+        size_t   entry     = ifd + 2 + e * 12;
+        uint32_t tag       = get16(entry);
+        uint32_t fieldType = get16(entry + 2);
+        uint32_t count     = get32(entry + 4);
+        size_t   itemSize  = fieldType == TIFF_SHORT ? 2 : 4;
+        size_t   values    = count * itemSize <= 4 ? entry + 8 : get32(entry + 8);
+
+        // Every tag we care about is a SHORT or LONG (or an array of them).
+        auto value = [&](const uint32_t i) -> uint32_t
+        {
+            return fieldType == TIFF_SHORT ? get16(values + i * 2) : get32(values + i * 4);
+        };
+
+        switch (tag)
+        {
+            case TIFF_TAG_IMAGE_WIDTH:       width       = value(0); break;
+            case TIFF_TAG_IMAGE_LENGTH:      height      = value(0); break;
+            case TIFF_TAG_BITS_PER_SAMPLE:   bits        = value(0); break;
+            case TIFF_TAG_COMPRESSION:       compression = value(0); break;
+            case TIFF_TAG_SAMPLES_PER_PIXEL: samples     = value(0); break;
+            case TIFF_TAG_ROWS_PER_STRIP:    stripRows   = value(0); break;
+            case TIFF_TAG_PLANAR_CONFIG:     planar      = value(0); break;
+            case TIFF_TAG_SAMPLE_FORMAT:     format      = value(0); break;
+
+            case TIFF_TAG_STRIP_OFFSETS:
+                offsets.resize(count);
+                for (uint32_t i = 0; i < count; ++i) {offsets[i] = value(i);}
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (width == 0 || height == 0 || offsets.empty())       {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: TIFF has no strip image data");}
+    if (compression != 1 || planar != 1)                    {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: only uncompressed, interleaved TIFFs can be streamed");}
+    if (samples != 3 && samples != 4)                       {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: only RGB & RGBA TIFFs are supported");}
+    if (bits > 8 && little != HostIsLittleEndian())         {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: multi-byte samples must be in native byte order");}
+
+    if      (bits ==  8 && format == 1) {type = CV_MAKETYPE(CV_8U,  samples);}
+    else if (bits == 16 && format == 1) {type = CV_MAKETYPE(CV_16U, samples);}
+    else if (bits == 32 && format == 3) {type = CV_MAKETYPE(CV_32F, samples);}
+    else                                {CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: unsupported TIFF sample format");}
+
+    rows         = (int) height;
+    cols         = (int) width;
+    rowBytes     = (size_t) width * CV_ELEM_SIZE(type);
+    rowsPerStrip = stripRows == 0 || stripRows > height ? (int) height : (int) stripRows;
+    rowOffsets   = offsets;
+
+    if (rowOffsets.size() < (size_t) ((rows + rowsPerStrip - 1) / rowsPerStrip))
+    {
+        CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: TIFF is missing strips");
+    }
+
+    // Check every strip fits, & whether they run back to back (so regions can be mapped views).
+    contiguous = true;
+
+    for (size_t s = 0; s < rowOffsets.size(); ++s)
+    {
+        int stripHeight = min(rowsPerStrip, rows - (int) s * rowsPerStrip);
+
+        if (stripHeight <= 0) {break;}
+
+        if (rowOffsets[s] + rowBytes * stripHeight > length)
+        {
+            CV_Error(Error::StsUnsupportedFormat, "e1nMappedRaster: TIFF strip runs past the end of the file");
+        }
+
+        if (rowOffsets[s] != rowOffsets[0] + s * rowsPerStrip * rowBytes) {contiguous = false;}
+    }
+}
+
+//====================================================================================================
+// e1nMappedRaster - Access:
+//====================================================================================================
+
+Mat e1nMappedRaster::GetRegion(const Rect &region) const
+{
+    CV_Assert(region.x >= 0 && region.y >= 0 && region.x + region.width <= cols && region.y + region.height <= rows);
+
+    size_t pixelBytes = CV_ELEM_SIZE(type);
+
+    if (contiguous)
+    {
+        return Mat(region.height, region.width, type, (void *) (RowPtr(region.y) + region.x * pixelBytes), rowBytes);
+    }
+
+    Mat copy(region.height, region.width, type);
+
+    for (int r = 0; r < region.height; ++r)
+    {
+        memcpy(copy.ptr(r), RowPtr(region.y + r) + region.x * pixelBytes, region.width * pixelBytes);
+    }
+
+    return copy;
+}
+
+void e1nMappedRaster::CopyRows(const int first, Mat &dst) const
+{
+    CV_Assert(dst.type() == type && dst.cols == cols && first >= 0 && first + dst.rows <= rows);
+
+    for (int r = 0; r < dst.rows; ++r)
+    {
+        memcpy(dst.ptr(r), RowPtr(first + r), rowBytes);
+    }
+}
+
+// Hints cover whole strips, rounded out to pages.
+void e1nMappedRaster::Prefetch(const int first, const int count) const
+{
+#if !defined(_WIN32)
+    if (!base || count <= 0) {return;}
+
+    size_t    page  = PageSize();
+    uintptr_t begin = (uintptr_t) RowPtr(first) & ~(uintptr_t) (page - 1);
+    uintptr_t end   = (uintptr_t) RowPtr(first + count - 1) + rowBytes;
+
+    madvise((void *) begin, end - begin, MADV_WILLNEED);
+#else
+    (void) first;
+    (void) count;
+#endif
+}
+
+void e1nMappedRaster::Release(const int first, const int count) const
+{
+#if !defined(_WIN32)
+    if (!base || count <= 0) {return;}
+
+    // Only whole pages that lie entirely inside the rows, so neighbors aren't evicted.
+    size_t    page  = PageSize();
+    uintptr_t begin = ((uintptr_t) RowPtr(first) + page - 1) & ~(uintptr_t) (page - 1);
+    uintptr_t end   = ((uintptr_t) RowPtr(first + count - 1) + rowBytes) & ~(uintptr_t) (page - 1);
+
+    if (end > begin) {madvise((void *) begin, end - begin, MADV_DONTNEED);}
+#else
+    (void) first;
+    (void) count;
+#endif
+}
+
+//====================================================================================================
+// e1nRasterWriter:
+//====================================================================================================
+
+e1nRasterWriter::e1nRasterWriter()
+{
+    file        = nullptr;
+    rows        = 0;
+    cols        = 0;
+    type        = 0;
+    rowsWritten = 0;
+}
+
+e1nRasterWriter::~e1nRasterWriter()
+{
+    Close();
+}
+
+void e1nRasterWriter::CreateRaw(const string &path, const int numRows, const int numCols, const int pixelType)
+{
+    CV_Assert(numRows > 0 && numCols > 0);
+
+    Close();
+
+    file = fopen(path.c_str(), "wb");
+
+    if (!file) {CV_Error(Error::StsError, "e1nRasterWriter: can't create " + path);}
+
+    rows        = numRows;
+    cols        = numCols;
+    type        = pixelType;
+    rowsWritten = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Writes the header & IFD up front, since an uncompressed strip's size is known in advance; the
+// pixels then simply follow. Classic TIFF offsets are 32-bit, so images over 4GB need CreateRaw().
+//----------------------------------------------------------------------------------------------------
+
+void e1nRasterWriter::CreateTIFF(const string &path, const int numRows, const int numCols, const int pixelType)
+{
+    int depth    = CV_MAT_DEPTH(pixelType);
+    int channels = CV_MAT_CN(pixelType);
+
+    CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
+    CV_Assert(channels == 3 || channels == 4);
+
+    uint64_t dataBytes = (uint64_t) numRows * numCols * CV_ELEM_SIZE(pixelType);
+
+    if (dataBytes > 0xFFFFFFFFull - 4096) {CV_Error(Error::StsOutOfRange, "e1nRasterWriter: image too large for a classic TIFF, use CreateRaw()");}
+
+    CreateRaw(path, numRows, numCols, pixelType);
+
+    int      numEntries = channels == 4 ? 12 : 11;
+    uint32_t ifdBytes   = 2 + numEntries * 12 + 4;
+    uint32_t bitsAt     = 8 + ifdBytes;                     // BitsPerSample array (too big to inline).
+    uint32_t formatAt   = bitsAt + channels * 2;            // SampleFormat array.
+    uint32_t dataAt     = (formatAt + channels * 2 + 15) & ~15u;
+    uint32_t bits       = (uint32_t) CV_ELEM_SIZE1(pixelType) * 8;
+    uint32_t format     = depth == CV_32F ? 3 : 1;
+
+    vector<unsigned char> header(dataAt, 0);
+
+    auto put16 = [&](const size_t at, const uint32_t v) {header[at] = (unsigned char) v; header[at + 1] = (unsigned char) (v >> 8);};
+    auto put32 = [&](const size_t at, const uint32_t v) {put16(at, v & 0xFFFF); put16(at + 2, v >> 16);};
+
+    header[0] = 'I';
+    header[1] = 'I';
+    put16(2, 42);
+    put32(4, 8);
+    put16(8, numEntries);
+
+    size_t entry = 10;
+
+    auto tag = [&](const uint32_t id, const uint32_t fieldType, const uint32_t count, const uint32_t v)
+    {
+        put16(entry, id);
+        put16(entry + 2, fieldType);
+        put32(entry + 4, count);
+
+        if (fieldType == TIFF_SHORT && count == 1) {put16(entry + 8, v);}
+        else                                       {put32(entry + 8, v);}
+
+        entry += 12;
+    };
+
+    // Entries must be in ascending tag order.
+    tag(TIFF_TAG_IMAGE_WIDTH,       TIFF_LONG,  1,        numCols);
+    tag(TIFF_TAG_IMAGE_LENGTH,      TIFF_LONG,  1,        numRows);
+    tag(TIFF_TAG_BITS_PER_SAMPLE,   TIFF_SHORT, channels, bitsAt);
+    tag(TIFF_TAG_COMPRESSION,       TIFF_SHORT, 1,        1);
+    tag(TIFF_TAG_PHOTOMETRIC,       TIFF_SHORT, 1,        2);     // RGB.
+    tag(TIFF_TAG_STRIP_OFFSETS,     TIFF_LONG,  1,        dataAt);
+    tag(TIFF_TAG_SAMPLES_PER_PIXEL, TIFF_SHORT, 1,        channels);
+    tag(TIFF_TAG_ROWS_PER_STRIP,    TIFF_LONG,  1,        numRows);
+    tag(TIFF_TAG_STRIP_BYTE_COUNTS, TIFF_LONG,  1,        (uint32_t) dataBytes);
+    tag(TIFF_TAG_PLANAR_CONFIG,     TIFF_SHORT, 1,        1);
+
+    if (channels == 4) {tag(TIFF_TAG_EXTRA_SAMPLES, TIFF_SHORT, 1, 2);}  // Unassociated alpha.
+
+    tag(TIFF_TAG_SAMPLE_FORMAT,     TIFF_SHORT, channels, formatAt);
+
+    put32(entry, 0);                                        // No further IFDs.
+
+    for (int c = 0; c < channels; ++c)
+    {
+        put16(bitsAt   + c * 2, bits);
+        put16(formatAt + c * 2, format);
+    }
+
+    if (fwrite(header.data(), 1, header.size(), file) != header.size())
+    {
+        Close();
+        CV_Error(Error::StsError, "e1nRasterWriter: can't write TIFF header to " + path);
+    }
+}
+
+void e1nRasterWriter::Close()
+{
+    if (file) {fclose(file);}
+
+    file = nullptr;
+}
+
+void e1nRasterWriter::WriteRows(const Mat &strip)
+{
+    CV_Assert(file && strip.type() == type && strip.cols == cols && rowsWritten + strip.rows <= rows);
+
+    size_t rowBytes = (size_t) cols * strip.elemSize();
+
+    for (int r = 0; r < strip.rows; ++r)
+    {
+        if (fwrite(strip.ptr(r), 1, rowBytes, file) != rowBytes)
+        {
+            CV_Error(Error::StsError, "e1nRasterWriter: write failed");
+        }
+    }
+
+    rowsWritten += strip.rows;
+}
+
+//====================================================================================================
+// e1nStreamProcessor:
+//====================================================================================================
+
+e1nStreamProcessor::e1nStreamProcessor(const int rowsPerStrip, e1nTileScheduler *tileScheduler)
+{
+    CV_Assert(rowsPerStrip > 0);
+
+    stripRows = rowsPerStrip;
+    scheduler = tileScheduler ? tileScheduler : &e1nTileScheduler::Default();
+}
+
+void e1nStreamProcessor::Add(const e1nStripOp &op)
+{
+    chain.push_back(op);
+}
+
+void e1nStreamProcessor::Clear()
+{
+    chain.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Three strip buffers rotate between the reader, the chain & the writer. At strip k the reader
+// is filling buffer k + 1 while the writer drains buffer k - 1, so the disk is kept busy in both
+// directions while the cores work.
+//----------------------------------------------------------------------------------------------------
+
+void e1nStreamProcessor::Run(const e1nMappedRaster &source, e1nRasterWriter &dest)
+{
+    CV_Assert(source.Rows() == dest.Rows() && source.Cols() == dest.Cols() && source.Type() == dest.Type());
+
+    E1N_TRACE_OP("e1nStreamProcessor::Run", (uint64_t) source.Rows() * source.Cols(), (uint64_t) source.Rows() * source.Cols() * CV_ELEM_SIZE(source.Type()) * 2);
+
+    int numStrips = (source.Rows() + stripRows - 1) / stripRows;
+    Mat buffers[3];
+
+    for (int i = 0; i < 3; ++i) {buffers[i].create(min(stripRows, source.Rows()), source.Cols(), source.Type());}
+
+    auto read = [&source, &buffers, this, numStrips](const int strip)
+    {
+        int first = strip * stripRows;
+        int count = min(stripRows, source.Rows() - first);
+        Mat view  = buffers[strip % 3].rowRange(0, count);
+
+#if defined(E1N_ENABLE_TRACE)
+        uint64_t begin = e1nTrace::IsEnabled() ? e1nTrace::Now() : 0;
+#endif
+
+        // Start paging in the strip after this one while we copy this one.
+        if (strip + 1 < numStrips) {source.Prefetch(first + count, min(stripRows, source.Rows() - first - count));}
+
+        source.CopyRows(first, view);
+        source.Release(first, count);
+
+#if defined(E1N_ENABLE_TRACE)
+        if (begin) {e1nTrace::AddStage("stream read", e1nTrace::Now() - begin, view.total(), view.total() * view.elemSize());}
+#endif
+    };
+
+    future<void> reading = async(launch::async, read, 0);
+    future<void> writing;
+
+    for (int strip = 0; strip < numStrips; ++strip)
+    {
+        reading.get();
+
+        if (strip + 1 < numStrips) {reading = async(launch::async, read, strip + 1);}
+
+        int first = strip * stripRows;
+        Mat rows  = buffers[strip % 3].rowRange(0, min(stripRows, source.Rows() - first));
+
+#if defined(E1N_ENABLE_TRACE)
+        uint64_t begin = e1nTrace::IsEnabled() ? e1nTrace::Now() : 0;
+#endif
+
+        // Run the whole chain on each tile while it's in cache.
+        scheduler->ForEachTile(rows.size(), [&](const Rect &tile, const int)
+        {
+            Mat  view = rows(tile);
+            Rect where(tile.x, first + tile.y, tile.width, tile.height);
+
+            for (size_t op = 0; op < chain.size(); ++op) {chain[op](view, where);}
+        });
+
+#if defined(E1N_ENABLE_TRACE)
+        if (begin) {e1nTrace::AddStage("stream process", e1nTrace::Now() - begin, rows.total(), rows.total() * rows.elemSize() * 2);}
+#endif
+
+        if (writing.valid()) {writing.get();}
+
+        writing = async(launch::async, [&dest, rows]
+        {
+#if defined(E1N_ENABLE_TRACE)
+            uint64_t begin = e1nTrace::IsEnabled() ? e1nTrace::Now() : 0;
+#endif
+
+            dest.WriteRows(rows);
+
+#if defined(E1N_ENABLE_TRACE)
+            if (begin) {e1nTrace::AddStage("stream write", e1nTrace::Now() - begin, rows.total(), rows.total() * rows.elemSize());}
+#endif
+        });
+    }
+
+    if (writing.valid()) {writing.get();}
+}
+
+//====================================================================================================
+// Ready-made strip operations:
+//====================================================================================================
+
+//     The conversions go through one-step pipelines rather than e1nConvertRGB2HLS() & co., which only
+// take 3-channel Mats, so a streamed RGBA raster's alpha passes straight through.
+e1nStripOp e1nStripRGB2HLS()
+{
+    e1nPipeline convert;
+
+    convert.ConvertRGB2HLS();
+
+    return [convert](Mat &tile, const Rect &) {convert.Run(tile);};
+}
+
+e1nStripOp e1nStripHLS2RGB()
+{
+    e1nPipeline convert;
+
+    convert.ConvertHLS2RGB();
+
+    return [convert](Mat &tile, const Rect &) {convert.Run(tile);};
+}
+
+e1nStripOp e1nStripBlend(const e1nMappedRaster &layer, const e1nBlendMode mode, const float opacity)
+{
+    const e1nMappedRaster *source = &layer;
+
+    return [source, mode, opacity](Mat &tile, const Rect &where)
+    {
+        e1nBlend(tile, source->GetRegion(where), mode, opacity);
+    };
+}
+
+e1nStripOp e1nStripPipeline(const e1nPipeline &pipeline)
+{
+    const e1nPipeline *chain = &pipeline;
+
+    return [chain](Mat &tile, const Rect &) {chain->Run(tile);};
+}
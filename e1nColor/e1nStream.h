@@ -0,0 +1,210 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nStream.h - Interface definition file for e1nColor's out-of-core (streaming) processing.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NSTREAM_H
+#define E1NSTREAM_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nBlend.h"
+#include "lib/e1nColor/e1nPipeline.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+// Default strip height for e1nStreamProcessor, in rows.
+#define E1N_DEFAULT_STRIP_ROWS 256
+
+//====================================================================================================
+//     Streaming lets the batch operations run over images far larger than RAM. The source is memory
+// mapped rather than read, a strip of rows at a time is copied out of the mapping, run through a
+// chain of operations & written to the destination before the next strip is started. Peak memory is
+// three strips (one being read, one being processed, one being written), whatever the image size.
+//
+//     Files are either headerless raw interleaved pixels, or baseline TIFFs: uncompressed, chunky
+// (interleaved) RGB or RGBA, with 8-bit, 16-bit or 32-bit float samples in strips.
+//====================================================================================================
+
+//====================================================================================================
+// e1nMappedRaster - A read-only, memory-mapped raster image file.
+//====================================================================================================
+
+class e1nMappedRaster
+{
+private:
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    unsigned char *base;                // Start of the mapping.
+    size_t         length;              // Length of the mapping in bytes.
+    void          *handle;              // Platform file handle(s) behind the mapping.
+
+    int rows;                           // Image height.
+    int cols;                           // Image width.
+    int type;                           // OpenCV pixel type, e.g. CV_8UC3.
+
+    vector<size_t> rowOffsets;          // File offset of the first row of each strip.
+    int            rowsPerStrip;        // Rows per strip (the whole image for raw files).
+    size_t         rowBytes;            // Bytes per row.
+    bool           contiguous;          // True when every row follows the previous one in the file.
+
+    void Map(const string &path);
+    void ParseTIFF();
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    e1nMappedRaster();
+    ~e1nMappedRaster();
+
+    //----------------------------------------------------------------------------------------------------
+    // Opening & closing:
+    //----------------------------------------------------------------------------------------------------
+
+    void OpenRaw(const string &path, const int numRows, const int numCols, const int pixelType, const size_t headerBytes = 0);
+    void OpenTIFF(const string &path);
+    void Close();
+
+    //----------------------------------------------------------------------------------------------------
+    // Geometry & access:
+    //----------------------------------------------------------------------------------------------------
+
+    int  Rows() const;
+    int  Cols() const;
+    int  Type() const;
+    Size GetSize() const;
+
+    const unsigned char *RowPtr(const int row) const;
+
+    // A read-only view of part of the image straight out of the mapping when the rows are
+    // contiguous in the file, otherwise a copy. Don't write to it either way.
+    Mat GetRegion(const Rect &region) const;
+
+    // Copies rows [first, first + dst.rows) into dst, which must already be the right size & type.
+    void CopyRows(const int first, Mat &dst) const;
+
+    // Paging hints: start reading rows ahead of use, & drop them from memory once they're done with.
+    void Prefetch(const int first, const int count) const;
+    void Release (const int first, const int count) const;
+
+private:
+
+    // Not copyable, the mapping has one owner.
+    e1nMappedRaster(const e1nMappedRaster &);
+    e1nMappedRaster &operator =(const e1nMappedRaster &);
+};
+
+//====================================================================================================
+// e1nRasterWriter - Writes an image file sequentially, a strip of rows at a time.
+//====================================================================================================
+
+class e1nRasterWriter
+{
+private:
+
+    FILE  *file;                        // The output file.
+    int    rows;                        // Image height.
+    int    cols;                        // Image width.
+    int    type;                        // OpenCV pixel type.
+    int    rowsWritten;                 // Rows written so far.
+
+public:
+
+    e1nRasterWriter();
+    ~e1nRasterWriter();
+
+    // Creates a headerless raw file or a single-strip baseline TIFF of the given size & type.
+    void CreateRaw (const string &path, const int numRows, const int numCols, const int pixelType);
+    void CreateTIFF(const string &path, const int numRows, const int numCols, const int pixelType);
+    void Close();
+
+    int  Rows() const;
+    int  Cols() const;
+    int  Type() const;
+
+    // Appends the rows of strip, which must match the file's width & type.
+    void WriteRows(const Mat &strip);
+
+private:
+
+    e1nRasterWriter(const e1nRasterWriter &);
+    e1nRasterWriter &operator =(const e1nRasterWriter &);
+};
+
+//====================================================================================================
+//     e1nStreamProcessor - Runs a chain of operations over a mapped source, strip by strip, writing
+// the result to a destination of the same size & type. Reading the next strip & writing the last one
+// happen on background threads while the current strip is processed, & within a strip every tile is
+// run through the whole chain by the tile scheduler, so each pixel is loaded into cache once.
+//
+//     A strip operation gets a tile of the current strip, plus where that tile sits in the full
+// image so it can fetch matching pixels from other sources (see e1nStripBlend()).
+//====================================================================================================
+
+typedef function<void(Mat &tile, const Rect &where)> e1nStripOp;
+
+class e1nStreamProcessor
+{
+private:
+
+    int                stripRows;       // Strip height in rows.
+    e1nTileScheduler  *scheduler;       // Scheduler used within each strip.
+    vector<e1nStripOp> chain;           // The operations, in order.
+
+public:
+
+    // A null scheduler means e1nTileScheduler::Default().
+    e1nStreamProcessor(const int rowsPerStrip = E1N_DEFAULT_STRIP_ROWS, e1nTileScheduler *tileScheduler = nullptr);
+
+    void Add(const e1nStripOp &op);
+    void Clear();
+
+    void Run(const e1nMappedRaster &source, e1nRasterWriter &dest);
+};
+
+//----------------------------------------------------------------------------------------------------
+// Ready-made strip operations:
+//----------------------------------------------------------------------------------------------------
+
+e1nStripOp e1nStripRGB2HLS();
+e1nStripOp e1nStripHLS2RGB();
+
+// Blends the matching region of another mapped image into each tile. The layer must outlive the run.
+e1nStripOp e1nStripBlend(const e1nMappedRaster &layer, const e1nBlendMode mode, const float opacity = 1.0f);
+
+// Runs a whole pipeline over each tile. The pipeline must outlive the run.
+e1nStripOp e1nStripPipeline(const e1nPipeline &pipeline);
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline int  e1nMappedRaster::Rows()    const {return rows;}
+inline int  e1nMappedRaster::Cols()    const {return cols;}
+inline int  e1nMappedRaster::Type()    const {return type;}
+inline Size e1nMappedRaster::GetSize() const {return Size(cols, rows);}
+
+inline const unsigned char *e1nMappedRaster::RowPtr(const int row) const
+{
+    return base + rowOffsets[row / rowsPerStrip] + (size_t) (row % rowsPerStrip) * rowBytes;
+}
+
+inline int e1nRasterWriter::Rows() const {return rows;}
+inline int e1nRasterWriter::Cols() const {return cols;}
+inline int e1nRasterWriter::Type() const {return type;}
+
+#endif     // E1NSTREAM_H
@@ -0,0 +1,326 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nTileScheduler.cpp - Implementation file for the e1nColor multi-threaded tile scheduler.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+//     The scheduler the current thread is running a job for & its index in that scheduler's pool, or
+// null & -1 outside of a job. Used to run nested jobs serially instead of deadlocking the pool; the
+// index only means something to its own scheduler, so a nested job on another one runs as thread 0.
+static thread_local const e1nTileScheduler *e1nCurrentScheduler = nullptr;
+static thread_local int                     e1nCurrentThread    = -1;
+
+//====================================================================================================
+// Share packing:
+//====================================================================================================
+
+static inline uint64_t PackShare(const int begin, const int end)
+{
+    return ((uint64_t) (uint32_t) end << 32) | (uint32_t) begin;
+}
+
+static inline int ShareBegin(const uint64_t share) {return (int) (uint32_t) share;}
+static inline int ShareEnd  (const uint64_t share) {return (int) (uint32_t) (share >> 32);}
+
+//====================================================================================================
+// Constructors & Destructor:
+//====================================================================================================
+
+e1nTileScheduler::e1nTileScheduler(const int threadCount, const Size tiles)
+{
+    numThreads = threadCount > 0 ? threadCount : (int) thread::hardware_concurrency();
+    numThreads = max(numThreads, 1);
+
+    job        = nullptr;
+    generation = 0;
+    quit       = false;
+
+    jobRemaining.store(0);
+    jobActive.store(0);
+    jobFailed.store(false);
+
+    SetTileSize(tiles);
+
+    shares.reset(new atomic<uint64_t>[numThreads]);
+
+    for (int t = 0; t < numThreads; ++t) {shares[t].store(PackShare(0, 0));}
+
+    // Thread 0 is whichever thread calls ForEachTile(), so only the rest need starting.
+    for (int t = 1; t < numThreads; ++t)
+    {
+        workers.push_back(thread(&e1nTileScheduler::WorkerLoop, this, t));
+    }
+}
+
+e1nTileScheduler::~e1nTileScheduler()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        quit = true;
+    }
+
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i) {workers[i].join();}
+}
+
+e1nTileScheduler &e1nTileScheduler::Default()
+{
+    static e1nTileScheduler scheduler;
+
+    return scheduler;
+}
+
+//====================================================================================================
+// Configuration:
+//====================================================================================================
+
+// Not to be called while a job is running.
+void e1nTileScheduler::SetTileSize(const Size tiles)
+{
+    CV_Assert(tiles.width > 0 && tiles.height > 0);
+
+    tileSize = tiles;
+}
+
+//====================================================================================================
+// Running work:
+//====================================================================================================
+
+void e1nTileScheduler::ForEachTile(const Size &imageSize, const TileFunc &func)
+{
+    int tilesX = (imageSize.width  + tileSize.width  - 1) / tileSize.width;
+    int tilesY = (imageSize.height + tileSize.height - 1) / tileSize.height;
+    Size tiles = tileSize;
+
+#if defined(E1N_ENABLE_TRACE)
+    // Tiles are filed under the operation that issued them, which is only known on this thread.
+    const char *op = e1nTrace::CurrentOp();
+#endif
+
+    // Tiles are numbered row-major, so each thread's starting share is a contiguous band.
+    Run(tilesX * tilesY, [&](const int index, const int thread)
+    {
+        int  x = (index % tilesX) * tiles.width;
+        int  y = (index / tilesX) * tiles.height;
+        Rect tile(x, y, min(tiles.width, imageSize.width - x), min(tiles.height, imageSize.height - y));
+
+#if defined(E1N_ENABLE_TRACE)
+        if (e1nTrace::IsEnabled())
+        {
+            uint64_t begin = e1nTrace::Now();
+
+            func(tile, thread);
+            e1nTrace::Record(op ? op : "untraced", "tile", begin, e1nTrace::Now(), (uint64_t) tile.area(), 0);
+            return;
+        }
+#endif
+
+        func(tile, thread);
+    });
+}
+
+void e1nTileScheduler::ForEachTile(Mat &image, const function<void(Mat &tile)> &func)
+{
+    ForEachTile(image.size(), [&](const Rect &tile, const int)
+    {
+        Mat view = image(tile);
+        func(view);
+    });
+}
+
+void e1nTileScheduler::ForEachTile(e1nColorPlanes &planes, const function<void(e1nColorPlanes &tile)> &func)
+{
+    ForEachTile(Size(planes.Cols(), planes.Rows()), [&](const Rect &tile, const int)
+    {
+        e1nColorPlanes view = planes.Region(tile);
+        func(view);
+    });
+}
+
+void e1nTileScheduler::ParallelFor(const int count, const IndexFunc &func)
+{
+    Run(count, func);
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Deals the items out as even contiguous shares, wakes the pool, works on share 0 from the
+// calling thread & then waits for every worker to check back in.
+//----------------------------------------------------------------------------------------------------
+
+void e1nTileScheduler::Run(const int count, const IndexFunc &func)
+{
+    if (count <= 0) {return;}
+
+    // Nothing to share, or already inside a job? Just do the work here.
+    if (numThreads == 1 || count == 1 || e1nCurrentScheduler)
+    {
+        int thread = e1nCurrentScheduler == this ? e1nCurrentThread : 0;
+
+        for (int i = 0; i < count; ++i) {func(i, thread);}
+
+        return;
+    }
+
+    lock_guard<mutex> submit(submitLock);
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        shares[t].store(PackShare((int) ((int64_t) count * t / numThreads), (int) ((int64_t) count * (t + 1) / numThreads)));
+    }
+
+    job      = &func;
+    jobError = nullptr;
+    jobFailed.store(false);
+    jobRemaining.store(count);
+    jobActive.store(numThreads - 1);
+
+    {
+        lock_guard<mutex> guard(lock);
+        ++generation;
+    }
+
+    wake.notify_all();
+
+    e1nCurrentScheduler = this;
+    e1nCurrentThread    = 0;
+    RunShare(0);
+    e1nCurrentScheduler = nullptr;
+    e1nCurrentThread    = -1;
+
+    {
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [this] {return jobActive.load() == 0;});
+    }
+
+    job = nullptr;
+
+    if (jobError) {rethrow_exception(jobError);}
+}
+
+void e1nTileScheduler::WorkerLoop(const int thread)
+{
+    uint64_t seen = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&] {return quit || generation != seen;});
+
+            if (quit) {return;}
+
+            seen = generation;
+        }
+
+        e1nCurrentScheduler = this;
+        e1nCurrentThread    = thread;
+        RunShare(thread);
+        e1nCurrentScheduler = nullptr;
+        e1nCurrentThread    = -1;
+
+        if (jobActive.fetch_sub(1) == 1)
+        {
+            lock_guard<mutex> guard(lock);
+            done.notify_all();
+        }
+    }
+}
+
+// Works through this thread's share, then keeps stealing until there is nothing left to steal.
+void e1nTileScheduler::RunShare(const int thread)
+{
+    int item;
+
+    do
+    {
+        while (PopItem(thread, item))
+        {
+            // Once one item has failed the rest are skipped, but still counted off.
+            if (!jobFailed.load())
+            {
+                try
+                {
+                    (*job)(item, thread);
+                }
+                catch (...)
+                {
+                    lock_guard<mutex> guard(lock);
+                    if (!jobError) {jobError = current_exception();}
+                    jobFailed.store(true);
+                }
+            }
+
+            jobRemaining.fetch_sub(1);
+        }
+    }
+    while (jobRemaining.load() > 0 && StealItems(thread));
+}
+
+// Takes the next item from the front of this thread's own share.
+bool e1nTileScheduler::PopItem(const int thread, int &item)
+{
+    uint64_t share = shares[thread].load();
+
+    for (;;)
+    {
+        int begin = ShareBegin(share);
+        int end   = ShareEnd(share);
+
+        if (begin >= end) {return false;}
+
+        if (shares[thread].compare_exchange_weak(share, PackShare(begin + 1, end)))
+        {
+            item = begin;
+            return true;
+        }
+    }
+}
+
+// Moves the back half of the largest other share into this thread's (empty) share.
+bool e1nTileScheduler::StealItems(const int thread)
+{
+    for (;;)
+    {
+        int      victim = -1;
+        int      most   = 0;
+        uint64_t share  = 0;
+
+        for (int t = 0; t < numThreads; ++t)
+        {
+            if (t == thread) {continue;}
+
+            uint64_t s    = shares[t].load();
+            int      left = ShareEnd(s) - ShareBegin(s);
+
+            if (left > most)
+            {
+                victim = t;
+                most   = left;
+                share  = s;
+            }
+        }
+
+        if (victim < 0) {return false;}
+
+        int begin = ShareBegin(share);
+        int end   = ShareEnd(share);
+        int split = end - (most + 1) / 2;
+
+        if (shares[victim].compare_exchange_strong(share, PackShare(begin, split)))
+        {
+            shares[thread].store(PackShare(split, end));
+            return true;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nTileScheduler.h - Interface definition file for the e1nColor multi-threaded tile scheduler.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NTILESCHEDULER_H
+#define E1NTILESCHEDULER_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+// Default tile size. 256 x 256 pixels is 192KB as CV_8UC3 & 768KB as CV_32FC3, which keeps a tile
+// inside a typical per-core L2 while leaving each worker plenty of tiles to balance with.
+#define E1N_DEFAULT_TILE_WIDTH  256
+#define E1N_DEFAULT_TILE_HEIGHT 256
+
+//====================================================================================================
+//     e1nTileScheduler - Splits an image into tiles & runs a batch operation on them across a pool of
+// worker threads. Every worker starts with an even, contiguous share of the tiles & works through it
+// front to back; a worker that runs dry steals the back half of the largest remaining share, so
+// uneven tiles (masked edits, image edges) don't leave cores idle.
+//
+//     The calling thread works as well, so a scheduler with N threads starts N - 1 workers. Calls are
+// synchronous: ForEachTile() returns once every tile is done, & rethrows the first exception any
+// tile threw. A ForEachTile() issued from inside a tile runs serially on that thread, on this
+// scheduler or any other; on another, it runs as that scheduler's thread 0.
+//====================================================================================================
+
+class e1nTileScheduler
+{
+public:
+
+    // The work function: called once per tile with the tile's rectangle & the index (0 to
+    // GetThreadCount() - 1) of the thread running it, for per-thread scratch or accumulators.
+    typedef function<void(const Rect &tile, const int thread)> TileFunc;
+
+    // The same for ParallelFor(), with an item index in place of the tile.
+    typedef function<void(const int index, const int thread)> IndexFunc;
+
+private:
+
+    //----------------------------------------------------------------------------------------------------
+    // Member variables:
+    //----------------------------------------------------------------------------------------------------
+
+    int  numThreads;                    // Worker threads plus the calling thread.
+    Size tileSize;                      // Tile size in pixels.
+
+    vector<thread> workers;             // The pool, numThreads - 1 strong.
+
+    // One share of tiles per thread, packed as (end << 32) | begin so owner & thieves can both
+    // update it with a single compare-exchange.
+    unique_ptr<atomic<uint64_t>[]> shares;
+
+    // The current job.
+    const IndexFunc *job;               // The work function, valid while a job is running.
+    atomic<int>      jobRemaining;      // Items not yet finished.
+    atomic<int>      jobActive;         // Workers still inside the job.
+    atomic<bool>     jobFailed;         // Set once any item has thrown.
+    exception_ptr    jobError;          // First exception thrown by an item.
+
+    // Worker wake-up & shutdown.
+    mutex              lock;
+    condition_variable wake;
+    condition_variable done;
+    uint64_t           generation;      // Bumped once per job.
+    bool               quit;
+
+    mutex submitLock;                   // Serializes jobs from different calling threads.
+
+    //----------------------------------------------------------------------------------------------------
+    // Internals:
+    //----------------------------------------------------------------------------------------------------
+
+    void Run(const int count, const IndexFunc &func);
+    void WorkerLoop(const int thread);
+    void RunShare(const int thread);
+    bool PopItem(const int thread, int &item);
+    bool StealItems(const int thread);
+
+public:
+
+    //----------------------------------------------------------------------------------------------------
+    // Constructors & Destructors:
+    //----------------------------------------------------------------------------------------------------
+
+    // A thread count of zero means one per hardware thread.
+    e1nTileScheduler(const int threadCount = 0, const Size tiles = Size(E1N_DEFAULT_TILE_WIDTH, E1N_DEFAULT_TILE_HEIGHT));
+
+    ~e1nTileScheduler();
+
+    // The process-wide scheduler used by batch functions that don't take one explicitly.
+    static e1nTileScheduler &Default();
+
+    //----------------------------------------------------------------------------------------------------
+    // Configuration:
+    //----------------------------------------------------------------------------------------------------
+
+    int  GetThreadCount() const;
+    Size GetTileSize() const;
+    void SetTileSize(const Size tiles);
+
+    //----------------------------------------------------------------------------------------------------
+    // Running work:
+    //----------------------------------------------------------------------------------------------------
+
+    // Runs func once for every tile covering an image of the given size.
+    void ForEachTile(const Size &imageSize, const TileFunc &func);
+
+    // Runs a batch operation over every tile of an image, passed as a Mat or e1nColorPlanes view.
+    void ForEachTile(Mat &image, const function<void(Mat &tile)> &func);
+    void ForEachTile(e1nColorPlanes &planes, const function<void(e1nColorPlanes &tile)> &func);
+
+    // Runs func(index, thread) for every index in [0, count), with the same stealing.
+    void ParallelFor(const int count, const IndexFunc &func);
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline int  e1nTileScheduler::GetThreadCount() const {return numThreads;}
+inline Size e1nTileScheduler::GetTileSize()    const {return tileSize;}
+
+#endif     // E1NTILESCHEDULER_H
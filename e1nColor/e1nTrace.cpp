@@ -0,0 +1,480 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nTrace.cpp - Implementation file for e1nColor's hot-path instrumentation & trace export.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Preprocessor directives:
+using namespace std;
+
+// Events per buffer block. Blocks are chained, so a buffer grows without ever moving an event.
+#define E1N_TRACE_BLOCK 4096
+
+// Distinct stages one thread can keep totals for.
+#define E1N_TRACE_STAGES 64
+
+//====================================================================================================
+// Per-thread buffers:
+//====================================================================================================
+//     Only the owning thread writes to a buffer. It fills an event, then publishes it by bumping the
+// block's count with release ordering; a new block is likewise filled in before it is linked. A
+// reader walking the chain with acquire loads therefore only ever sees complete events.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nTraceBlock
+{
+    e1nTraceEvent                events[E1N_TRACE_BLOCK];
+    atomic<size_t>               used;
+    atomic<e1nTraceBlock *>      next;
+
+    e1nTraceBlock() : used(0), next(nullptr) {}
+};
+
+// A stage's running totals. Relaxed atomics, so a collector reading mid-run isn't a data race.
+struct e1nStageTotal
+{
+    atomic<const char *> name;
+    atomic<uint64_t>     first;
+    atomic<uint64_t>     nanoseconds;
+    atomic<uint64_t>     pixels;
+    atomic<uint64_t>     bytes;
+
+    e1nStageTotal() : name(nullptr), first(0), nanoseconds(0), pixels(0), bytes(0) {}
+};
+
+struct e1nTraceBuffer
+{
+    int             id;
+    e1nTraceBlock  *head;
+    e1nTraceBlock  *tail;
+    e1nStageTotal   stages[E1N_TRACE_STAGES];
+
+    e1nTraceBuffer(const int someId) : id(someId), head(new e1nTraceBlock), tail(head) {}
+
+    ~e1nTraceBuffer() {FreeAfter(head); delete head;}
+
+    void FreeAfter(e1nTraceBlock *block)
+    {
+        e1nTraceBlock *next = block->next.load();
+
+        while (next)
+        {
+            e1nTraceBlock *after = next->next.load();
+
+            delete next;
+            next = after;
+        }
+
+        block->next.store(nullptr);
+    }
+};
+
+// Every buffer ever created. Buffers outlive their threads, so a finished thread's events still show.
+static mutex                              registryLock;
+static vector<unique_ptr<e1nTraceBuffer>> registry;
+static vector<e1nTraceBuffer *>           retired;
+static atomic<bool>                       traceEnabled(false);
+
+//----------------------------------------------------------------------------------------------------
+//     When a thread exits its buffer is retired & the next new thread carries on appending to it, so
+// short-lived threads (std::async reads & writes, say) share a lane instead of piling up buffers.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nTraceBufferHolder
+{
+    e1nTraceBuffer *buffer;
+
+    e1nTraceBufferHolder() : buffer(nullptr) {}
+
+    ~e1nTraceBufferHolder()
+    {
+        if (!buffer) {return;}
+
+        lock_guard<mutex> hold(registryLock);
+
+        retired.push_back(buffer);
+    }
+};
+
+static thread_local e1nTraceBufferHolder localBuffer;
+static thread_local const char          *currentOp = nullptr;
+
+static e1nTraceBuffer &GetLocalBuffer()
+{
+    if (!localBuffer.buffer)
+    {
+        lock_guard<mutex> hold(registryLock);
+
+        if (!retired.empty())
+        {
+            localBuffer.buffer = retired.back();
+            retired.pop_back();
+        }
+        else
+        {
+            registry.emplace_back(new e1nTraceBuffer((int) registry.size()));
+            localBuffer.buffer = registry.back().get();
+        }
+    }
+
+    return *localBuffer.buffer;
+}
+
+//====================================================================================================
+// Control & recording:
+//====================================================================================================
+
+bool e1nTrace::Compiled()
+{
+#if defined(E1N_ENABLE_TRACE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void e1nTrace::SetEnabled(const bool enable)
+{
+    traceEnabled.store(enable, memory_order_relaxed);
+}
+
+bool e1nTrace::IsEnabled()
+{
+    return traceEnabled.load(memory_order_relaxed);
+}
+
+void e1nTrace::Clear()
+{
+    lock_guard<mutex> hold(registryLock);
+
+    for (unique_ptr<e1nTraceBuffer> &buffer : registry)
+    {
+        buffer->FreeAfter(buffer->head);
+        buffer->head->used.store(0);
+        buffer->tail = buffer->head;
+
+        for (e1nStageTotal &stage : buffer->stages)
+        {
+            stage.name.store(nullptr);
+            stage.first.store(0);
+            stage.nanoseconds.store(0);
+            stage.pixels.store(0);
+            stage.bytes.store(0);
+        }
+    }
+}
+
+void e1nTrace::Record(const char *name, const char *category, const uint64_t begin, const uint64_t end,
+                      const uint64_t pixels, const uint64_t bytes)
+{
+    e1nTraceBuffer &buffer = GetLocalBuffer();
+    e1nTraceBlock  *block  = buffer.tail;
+    size_t          used   = block->used.load(memory_order_relaxed);
+
+    if (used == E1N_TRACE_BLOCK)
+    {
+        e1nTraceBlock *fresh = new e1nTraceBlock;
+
+        block->next.store(fresh, memory_order_release);
+        buffer.tail = block = fresh;
+        used        = 0;
+    }
+
+    e1nTraceEvent &event = block->events[used];
+
+    event.name     = name;
+    event.category = category;
+    event.begin    = begin;
+    event.end      = end;
+    event.pixels   = pixels;
+    event.bytes    = bytes;
+    event.thread   = buffer.id;
+
+    block->used.store(used + 1, memory_order_release);
+}
+
+void e1nTrace::AddStage(const char *name, const uint64_t nanoseconds, const uint64_t pixels, const uint64_t bytes)
+{
+    e1nTraceBuffer &buffer = GetLocalBuffer();
+
+    for (e1nStageTotal &stage : buffer.stages)
+    {
+        const char *held = stage.name.load(memory_order_relaxed);
+
+        if (held && held != name) {continue;}
+
+        if (!held)
+        {
+            stage.first.store(Now() - nanoseconds, memory_order_relaxed);
+            stage.name.store(name, memory_order_release);
+        }
+
+        stage.nanoseconds.store(stage.nanoseconds.load(memory_order_relaxed) + nanoseconds, memory_order_relaxed);
+        stage.pixels.store(stage.pixels.load(memory_order_relaxed) + pixels, memory_order_relaxed);
+        stage.bytes.store(stage.bytes.load(memory_order_relaxed) + bytes, memory_order_relaxed);
+        return;
+    }
+
+    // Table full: the stage goes uncounted rather than slowing the hot path down.
+}
+
+const char *e1nTrace::CurrentOp()
+{
+    return currentOp;
+}
+
+const char *e1nTrace::SetCurrentOp(const char *name)
+{
+    const char *previous = currentOp;
+
+    currentOp = name;
+
+    return previous;
+}
+
+//====================================================================================================
+// Collection:
+//====================================================================================================
+
+vector<e1nTraceEvent> e1nTrace::Collect()
+{
+    vector<e1nTraceEvent> events;
+    lock_guard<mutex>     hold(registryLock);
+
+    for (unique_ptr<e1nTraceBuffer> &buffer : registry)
+    {
+        for (e1nTraceBlock *block = buffer->head; block; block = block->next.load(memory_order_acquire))
+        {
+            size_t used = block->used.load(memory_order_acquire);
+
+            events.insert(events.end(), block->events, block->events + used);
+        }
+
+        // Stages come out as one event per thread, starting at first use & lasting their total time.
+        for (e1nStageTotal &stage : buffer->stages)
+        {
+            const char *name = stage.name.load(memory_order_acquire);
+
+            if (!name) {continue;}
+
+            e1nTraceEvent event;
+
+            event.name     = name;
+            event.category = "stage";
+            event.begin    = stage.first.load(memory_order_relaxed);
+            event.end      = event.begin + stage.nanoseconds.load(memory_order_relaxed);
+            event.pixels   = stage.pixels.load(memory_order_relaxed);
+            event.bytes    = stage.bytes.load(memory_order_relaxed);
+            event.thread   = buffer->id;
+
+            events.push_back(event);
+        }
+    }
+
+    sort(events.begin(), events.end(), [](const e1nTraceEvent &a, const e1nTraceEvent &b) {return a.begin < b.begin;});
+
+    return events;
+}
+
+//====================================================================================================
+// Export:
+//====================================================================================================
+
+static void WriteJSONString(ostream &os, const char *text)
+{
+    os << '"';
+
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\') {os << '\\';}
+
+        os << *c;
+    }
+
+    os << '"';
+}
+
+void e1nTrace::WriteChromeTrace(ostream &os)
+{
+    vector<e1nTraceEvent> events = Collect();
+    uint64_t              origin = events.empty() ? 0 : events.front().begin;
+    char                  times[64];
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const e1nTraceEvent &e = events[i];
+
+        // Complete ("X") events, microseconds from the first one.
+        snprintf(times, sizeof(times), "%.3f,\"dur\":%.3f", (e.begin - origin) / 1000.0, (e.end - e.begin) / 1000.0);
+
+        os << (i ? ",\n" : "\n") << "{\"name\":";
+        WriteJSONString(os, e.name);
+        os << ",\"cat\":";
+        WriteJSONString(os, e.category);
+        os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << ",\"ts\":" << times
+           << ",\"args\":{\"pixels\":" << e.pixels << ",\"bytes\":" << e.bytes << "}}";
+    }
+
+    os << "\n]}\n";
+}
+
+bool e1nTrace::WriteChromeTrace(const string &path)
+{
+    ofstream file(path.c_str());
+
+    if (!file) {return false;}
+
+    WriteChromeTrace(file);
+
+    return (bool) file;
+}
+
+// Totals for one name (or thread) in the summary.
+struct e1nTraceTotals
+{
+    uint64_t count;
+    uint64_t time;
+    uint64_t least;
+    uint64_t most;
+    uint64_t pixels;
+    uint64_t bytes;
+    uint64_t first;
+    uint64_t last;
+
+    e1nTraceTotals() : count(0), time(0), least(UINT64_MAX), most(0), pixels(0), bytes(0), first(UINT64_MAX), last(0) {}
+
+    void Add(const e1nTraceEvent &e)
+    {
+        uint64_t span = e.end - e.begin;
+
+        count  += 1;
+        time   += span;
+        least   = min(least, span);
+        most    = max(most, span);
+        pixels += e.pixels;
+        bytes  += e.bytes;
+        first   = min(first, e.begin);
+        last    = max(last, e.end);
+    }
+};
+
+static string FormatLine(const char *format, ...)
+{
+    char    line[256];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    return line;
+}
+
+void e1nTrace::WriteSummary(ostream &os)
+{
+    vector<e1nTraceEvent> events = Collect();
+
+    if (events.empty())
+    {
+        os << "e1nTrace: nothing recorded" << (Compiled() ? "" : " (built without E1N_ENABLE_TRACE)") << ".\n";
+        return;
+    }
+
+    map<string, e1nTraceTotals> ops, tiles, stages;
+    map<int, e1nTraceTotals>    threads;
+    vector<e1nTraceEvent>       slowest;
+
+    for (const e1nTraceEvent &e : events)
+    {
+        string category = e.category;
+
+        if (category == "op")    {ops[e.name].Add(e);}
+        if (category == "stage") {stages[e.name].Add(e);}
+
+        if (category == "tile")
+        {
+            tiles[e.name].Add(e);
+            threads[e.thread].Add(e);
+            slowest.push_back(e);
+        }
+    }
+
+    double ms = 1.0e-6;
+
+    os << FormatLine("%-28s %6s %12s %12s %10s %10s\n", "Operations", "calls", "total ms", "mean ms", "Mpix/s", "GB/s");
+
+    for (auto &op : ops)
+    {
+        const e1nTraceTotals &t = op.second;
+        double                s = max(t.time, (uint64_t) 1) * 1.0e-9;
+
+        os << FormatLine("%-28s %6llu %12.3f %12.3f %10.1f %10.2f\n", op.first.c_str(), (unsigned long long) t.count,
+                         t.time * ms, t.time * ms / t.count, t.pixels / s * 1.0e-6, t.bytes / s * 1.0e-9);
+    }
+
+    // Imbalance is the slowest tile over the mean: well above 1 means a few tiles hold everyone up.
+    os << FormatLine("\n%-28s %6s %12s %12s %12s %10s\n", "Tiles", "count", "mean ms", "min ms", "max ms", "imbalance");
+
+    for (auto &tile : tiles)
+    {
+        const e1nTraceTotals &t    = tile.second;
+        double                mean = (double) t.time / t.count;
+
+        os << FormatLine("%-28s %6llu %12.3f %12.3f %12.3f %10.2f\n", tile.first.c_str(), (unsigned long long) t.count,
+                         mean * ms, t.least * ms, t.most * ms, t.most / max(mean, 1.0));
+    }
+
+    if (!stages.empty())
+    {
+        os << FormatLine("\n%-28s %7s %12s %10s %10s\n", "Stages", "threads", "total ms", "Mpix/s", "GB/s");
+
+        for (auto &stage : stages)
+        {
+            const e1nTraceTotals &t = stage.second;
+            double                s = max(t.time, (uint64_t) 1) * 1.0e-9;
+
+            os << FormatLine("%-28s %7llu %12.3f %10.1f %10.2f\n", stage.first.c_str(), (unsigned long long) t.count,
+                             t.time * ms, t.pixels / s * 1.0e-6, t.bytes / s * 1.0e-9);
+        }
+    }
+
+    // Busy is time spent in tiles; span runs from the thread's first tile to its last.
+    os << FormatLine("\n%-28s %6s %12s %12s %10s\n", "Thread", "tiles", "busy ms", "span ms", "busy %");
+
+    for (auto &thread : threads)
+    {
+        const e1nTraceTotals &t    = thread.second;
+        uint64_t              span = t.last - t.first;
+
+        os << FormatLine("%-28d %6llu %12.3f %12.3f %10.1f\n", thread.first, (unsigned long long) t.count,
+                         t.time * ms, span * ms, span ? 100.0 * t.time / span : 100.0);
+    }
+
+    size_t shown = min(slowest.size(), (size_t) 5);
+
+    partial_sort(slowest.begin(), slowest.begin() + shown, slowest.end(),
+                 [](const e1nTraceEvent &a, const e1nTraceEvent &b) {return a.end - a.begin > b.end - b.begin;});
+
+    os << FormatLine("\n%-28s %7s %12s %10s\n", "Slowest tiles", "thread", "ms", "pixels");
+
+    for (size_t i = 0; i < shown; ++i)
+    {
+        const e1nTraceEvent &e = slowest[i];
+
+        os << FormatLine("%-28s %7d %12.3f %10llu\n", e.name, e.thread, (e.end - e.begin) * ms, (unsigned long long) e.pixels);
+    }
+}
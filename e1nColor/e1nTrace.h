@@ -0,0 +1,167 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nTrace.h - Interface definition file for e1nColor's hot-path instrumentation & trace export.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NTRACE_H
+#define E1NTRACE_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//====================================================================================================
+//     Instrumentation is compiled in only when E1N_ENABLE_TRACE is defined (e.g. -DE1N_ENABLE_TRACE);
+// otherwise the E1N_TRACE_* macros expand to nothing & the hot paths are exactly as they were. A
+// build with tracing compiled in still records nothing until e1nTrace::SetEnabled(true), so one
+// binary can ship with it & switch it on for a problem run; off, each traced call costs one load &
+// branch.
+//
+// What gets recorded:
+//
+//      Operations - every public batch function & e1nPipeline::Run(): wall time, pixels & bytes
+//                   moved (read + written), on the calling thread.
+//      Tiles      - every tile the tile scheduler runs, under the name of the operation that issued
+//                   it, with the thread that ran it, so stragglers & idle threads show up.
+//      Stages     - e1nPipeline steps & e1nStreamProcessor read / process / write, as totals per
+//                   thread (steps run per chunk, far too often for an event each).
+//
+//     Each thread appends to its own buffer; nothing on the recording path takes a lock or touches
+// another thread's memory. A thread's buffer is registered (under a mutex) the first time it
+// records, & passed on to a later thread when it exits.
+//
+//     Collect() & the writers can run while jobs are in flight & see everything recorded so far;
+// Clear() must only be called between jobs.
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// One recorded interval. Times are nanoseconds on the steady clock.
+//----------------------------------------------------------------------------------------------------
+
+struct e1nTraceEvent
+{
+    const char *name;                   // Static strings only; the pointer is stored, not the text.
+    const char *category;               // "op", "tile" or "stage".
+    uint64_t    begin;
+    uint64_t    end;
+    uint64_t    pixels;
+    uint64_t    bytes;
+    int         thread;                 // Trace lane: one per live thread, handed on when it exits.
+};
+
+//----------------------------------------------------------------------------------------------------
+// e1nTrace - Control, collection & export. All static.
+//----------------------------------------------------------------------------------------------------
+
+class e1nTrace
+{
+public:
+
+    // Whether this build has tracing compiled in at all.
+    static bool Compiled();
+
+    // Runtime switch (off by default).
+    static void SetEnabled(const bool enable);
+    static bool IsEnabled();
+
+    // Drops everything recorded so far. Not safe while a traced job is running.
+    static void Clear();
+
+    // Every event recorded so far, stages included (as one event per thread & stage, spanning it).
+    static vector<e1nTraceEvent> Collect();
+
+    // Chrome trace JSON (chrome://tracing, Perfetto) & a plain-text summary: per operation & stage
+    // time, throughput & tile balance, per thread busy time, & the slowest tiles.
+    static void WriteChromeTrace(ostream &os);
+    static bool WriteChromeTrace(const string &path);
+    static void WriteSummary(ostream &os);
+
+    //----------------------------------------------------------------------------------------------------
+    // Recording, normally through the macros below:
+    //----------------------------------------------------------------------------------------------------
+
+    static uint64_t Now();
+
+    static void Record(const char *name, const char *category, const uint64_t begin, const uint64_t end,
+                       const uint64_t pixels, const uint64_t bytes);
+
+    // Adds to the calling thread's running total for a stage.
+    static void AddStage(const char *name, const uint64_t nanoseconds, const uint64_t pixels, const uint64_t bytes);
+
+    // The innermost operation running on the calling thread, which tiles are filed under.
+    static const char *CurrentOp();
+    static const char *SetCurrentOp(const char *name);          // Returns the previous one.
+};
+
+//----------------------------------------------------------------------------------------------------
+//     e1nTraceScope - Records one operation from construction to destruction, & makes it the calling
+// thread's current operation meanwhile.
+//----------------------------------------------------------------------------------------------------
+
+class e1nTraceScope
+{
+private:
+
+    const char *name;
+    const char *previous;
+    uint64_t    begin;
+    uint64_t    pixels;
+    uint64_t    bytes;
+    bool        active;
+
+public:
+
+    e1nTraceScope(const char *opName, const uint64_t numPixels, const uint64_t numBytes)
+        : name(opName), previous(nullptr), begin(0), pixels(numPixels), bytes(numBytes), active(e1nTrace::IsEnabled())
+    {
+        if (!active) {return;}
+
+        previous = e1nTrace::SetCurrentOp(name);
+        begin    = e1nTrace::Now();
+    }
+
+    ~e1nTraceScope()
+    {
+        if (!active) {return;}
+
+        e1nTrace::Record(name, "op", begin, e1nTrace::Now(), pixels, bytes);
+        e1nTrace::SetCurrentOp(previous);
+    }
+
+    e1nTraceScope(const e1nTraceScope &) = delete;
+    e1nTraceScope &operator =(const e1nTraceScope &) = delete;
+};
+
+//====================================================================================================
+//                                  Inline member functions.
+//====================================================================================================
+
+inline uint64_t e1nTrace::Now()
+{
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//====================================================================================================
+// Macros:
+//====================================================================================================
+//     E1N_TRACE_OP(name, pixels, bytes) traces the rest of the enclosing block as an operation. The
+// arguments aren't evaluated at all when tracing is compiled out.
+//----------------------------------------------------------------------------------------------------
+
+#define E1N_TRACE_JOIN2(a, b) a##b
+#define E1N_TRACE_JOIN(a, b)  E1N_TRACE_JOIN2(a, b)
+
+#if defined(E1N_ENABLE_TRACE)
+#define E1N_TRACE_OP(name, pixels, bytes) e1nTraceScope E1N_TRACE_JOIN(e1nTraceScope_, __LINE__)(name, (uint64_t) (pixels), (uint64_t) (bytes))
+#else
+#define E1N_TRACE_OP(name, pixels, bytes) ((void) 0)
+#endif
+
+#endif     // E1NTRACE_H
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nTransfer.cpp - Implementation file for e1nColor's gamma & transfer curve conversions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nTransfer.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nColorKernels.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include "lib/e1nColor/e1nTrace.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+using namespace e1nSimd;
+
+//====================================================================================================
+// Appliers:
+//====================================================================================================
+
+// A curve's kernel from the current level's table, bound to its exponent (used by the power curve only).
+struct e1nCurveKernel
+{
+    e1nKernelTable::TransferFn run;
+    float                      exponent;
+
+    void operator ()(float *x, const size_t count) const {run(x, count, exponent);}
+};
+
+static e1nCurveKernel GetCurveKernel(const int curve, const float exponent = 1.0f)
+{
+    return e1nCurveKernel{e1nGetKernels().transfer[curve], exponent};
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Integer images: run every possible channel value through the curve once, then look each channel
+// up. Encoding rounds to nearest & clamps, like e1nFloatToByte().
+//----------------------------------------------------------------------------------------------------
+
+template <class T> static void ApplyTable(Mat &image, const e1nCurveKernel &op, e1nTileScheduler &pool)
+{
+    const int     levels = 1 << (8 * sizeof(T));
+    const float   top    = (float) (levels - 1);
+    vector<float> curve(levels);
+    vector<T>     table(levels);
+
+    for (int i = 0; i < levels; ++i) {curve[i] = i / top;}
+
+    op(curve.data(), levels);
+
+    for (int i = 0; i < levels; ++i)
+    {
+        float x = curve[i] > 0.0f ? (curve[i] < 1.0f ? curve[i] : 1.0f) : 0.0f;
+
+        table[i] = (T) (x * top + 0.5f);
+    }
+
+    const int channels = image.channels();
+
+    pool.ForEachTile(image, [&](Mat &tile)
+    {
+        for (int row = 0; row < tile.rows; ++row)
+        {
+            T *p = tile.ptr<T>(row);
+
+            for (int col = 0; col < tile.cols; ++col, p += channels)
+            {
+                p[0] = table[p[0]];
+                p[1] = table[p[1]];
+                p[2] = table[p[2]];
+            }
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+//     Float images: a CV_32FC3 row is one run of values, all of them color, so it goes through the
+// kernel as it lies; CV_32FC4 rows are unpacked so alpha can be stepped around.
+//----------------------------------------------------------------------------------------------------
+
+static void ApplyFloat(Mat &image, const e1nCurveKernel &op, e1nTileScheduler &pool)
+{
+    pool.ForEachTile(image, [&](Mat &tile)
+    {
+        alignas(64) float c0[E1N_BATCH_CHUNK];
+        alignas(64) float c1[E1N_BATCH_CHUNK];
+        alignas(64) float c2[E1N_BATCH_CHUNK];
+
+        for (int row = 0; row < tile.rows; ++row)
+        {
+            if (tile.channels() == 3)
+            {
+                op(tile.ptr<float>(row), (size_t) tile.cols * 3);
+                continue;
+            }
+
+            for (int col = 0; col < tile.cols; col += E1N_BATCH_CHUNK)
+            {
+                int count = min(E1N_BATCH_CHUNK, tile.cols - col);
+
+                e1nUnpackRow(tile, row, col, count, c0, c1, c2);
+                op(c0, count);
+                op(c1, count);
+                op(c2, count);
+                e1nPackRow(tile, row, col, count, c0, c1, c2);
+            }
+        }
+    });
+}
+
+// Binds an image (or planes, or a run of values) & a scheduler, so Dispatch() can hand it any curve.
+struct e1nMatTarget
+{
+    Mat              &image;
+    e1nTileScheduler &pool;
+
+    void operator ()(const e1nCurveKernel &op) const
+    {
+        switch (image.depth())
+        {
+            case CV_8U:  ApplyTable<uint8_t> (image, op, pool); break;
+            case CV_16U: ApplyTable<uint16_t>(image, op, pool); break;
+            default:     ApplyFloat(image, op, pool);           break;
+        }
+    }
+};
+
+struct e1nPlanesTarget
+{
+    e1nColorPlanes   &planes;
+    e1nTileScheduler &pool;
+
+    void operator ()(const e1nCurveKernel &op) const
+    {
+        pool.ForEachTile(planes, [&](e1nColorPlanes &tile)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                for (int row = 0; row < tile.Rows(); ++row) {op(tile.Row(k, row), tile.Cols());}
+            }
+        });
+    }
+};
+
+struct e1nValuesTarget
+{
+    float  *values;
+    size_t  count;
+
+    void operator ()(const e1nCurveKernel &op) const {op(values, count);}
+};
+
+//----------------------------------------------------------------------------------------------------
+//     Picks the kernel for a curve & direction & runs it over the target. E1N_TRANSFER_LINEAR has
+// nothing to do.
+//----------------------------------------------------------------------------------------------------
+
+template <class Target> static void Dispatch(const Target &target, const e1nTransferCurve curve, const bool toLinear, const float gamma)
+{
+    switch (curve)
+    {
+        case E1N_TRANSFER_LINEAR:
+            break;
+
+        case E1N_TRANSFER_SRGB:
+            if (toLinear) {target(GetCurveKernel(E1N_CURVE_SRGB_TO_LINEAR));}
+            else          {target(GetCurveKernel(E1N_CURVE_LINEAR_TO_SRGB));}
+            break;
+
+        case E1N_TRANSFER_REC709:
+            if (toLinear) {target(GetCurveKernel(E1N_CURVE_REC709_TO_LINEAR));}
+            else          {target(GetCurveKernel(E1N_CURVE_LINEAR_TO_REC709));}
+            break;
+
+        case E1N_TRANSFER_GAMMA:
+            CV_Assert(gamma > 0.0f);
+            target(GetCurveKernel(E1N_CURVE_POW, toLinear ? gamma : 1.0f / gamma));
+            break;
+
+        default:
+            CV_Error(Error::StsBadArg, "e1nTransfer: unknown transfer curve.");
+    }
+}
+
+static e1nTileScheduler &GetPool(e1nTileScheduler *scheduler)
+{
+    return scheduler ? *scheduler : e1nTileScheduler::Default();
+}
+
+static void CheckImage(const Mat &image)
+{
+    int depth = image.depth();
+
+    CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
+    CV_Assert(image.channels() == 3 || image.channels() == 4);
+}
+
+//====================================================================================================
+// Public functions:
+//====================================================================================================
+
+void e1nToLinear(Mat &image, const e1nTransferCurve curve, const float gamma, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nToLinear", image.total(), image.total() * image.elemSize() * 2);
+
+    CheckImage(image);
+    Dispatch(e1nMatTarget{image, GetPool(scheduler)}, curve, true, gamma);
+}
+
+void e1nFromLinear(Mat &image, const e1nTransferCurve curve, const float gamma, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nFromLinear", image.total(), image.total() * image.elemSize() * 2);
+
+    CheckImage(image);
+    Dispatch(e1nMatTarget{image, GetPool(scheduler)}, curve, false, gamma);
+}
+
+void e1nToLinear(e1nColorPlanes &planes, const e1nTransferCurve curve, const float gamma, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nToLinear", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    Dispatch(e1nPlanesTarget{planes, GetPool(scheduler)}, curve, true, gamma);
+}
+
+void e1nFromLinear(e1nColorPlanes &planes, const e1nTransferCurve curve, const float gamma, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nFromLinear", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    Dispatch(e1nPlanesTarget{planes, GetPool(scheduler)}, curve, false, gamma);
+}
+
+void e1nToLinear(float *values, const size_t count, const e1nTransferCurve curve, const float gamma)
+{
+    Dispatch(e1nValuesTarget{values, count}, curve, true, gamma);
+}
+
+void e1nFromLinear(float *values, const size_t count, const e1nTransferCurve curve, const float gamma)
+{
+    Dispatch(e1nValuesTarget{values, count}, curve, false, gamma);
+}
+
+void e1nPowRGB(Mat &image, const float exponent, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nPowRGB", image.total(), image.total() * image.elemSize() * 2);
+
+    CheckImage(image);
+    e1nMatTarget{image, GetPool(scheduler)}(GetCurveKernel(E1N_CURVE_POW, exponent));
+}
+
+void e1nPowRGB(e1nColorPlanes &planes, const float exponent, e1nTileScheduler *scheduler)
+{
+    E1N_TRACE_OP("e1nPowRGB", (uint64_t) planes.Rows() * planes.Cols(), (uint64_t) planes.Rows() * planes.Cols() * 24);
+
+    e1nPlanesTarget{planes, GetPool(scheduler)}(GetCurveKernel(E1N_CURVE_POW, exponent));
+}
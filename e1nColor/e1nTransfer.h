@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// e1nTransfer.h - Interface definition file for e1nColor's gamma & transfer curve conversions.
+//
+// Copyright © 2022 Kunst Logic LLC. All rights reserved.
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef E1NTRANSFER_H
+#define E1NTRANSFER_H
+
+#pragma once
+
+#include "lib/stdafx.h"                 // Precompiled headers.
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorPlanes.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>           // OpenCV library.
+#include <cstddef>
+
+using namespace std;
+using namespace cv;
+
+//====================================================================================================
+//     Whole-image conversions between encoded (sRGB, Rec.709, gamma) & linear light, plus a plain
+// power curve. They apply to r, g & b & leave alpha alone, in place.
+//
+//     Float data goes through the polynomial Pow() kernel in e1nColorKernels.h at full SIMD width,
+// never through pow(). Accuracy against a double-precision reference, for inputs 0-1.5:
+//
+//      sRGB, Rec.709 - within 1.1e-6 absolute & 1e-6 relative, both directions.
+//      Gamma / Pow   - relative error within 3e-7 + 8e-8 * |exponent| * (1 + |log2(x)|).
+//
+//     Byte & 16-bit images go through a table of every possible input (256 or 65536 entries, built
+// with the same kernel on each call) & round to nearest: every byte value comes out exact, & a 16-bit
+// value is at most one step off, only where the exact curve lands within 1e-6 of a rounding midpoint.
+//
+//     Negative values keep their sign (the curve is applied to the magnitude) & values over 1 carry on
+// along the curve, so out-of-gamut float data survives a round trip.
+//
+//     Supported Mat types: CV_8UC3/4, CV_16UC3/4 & CV_32FC3/4. A null scheduler means
+// e1nTileScheduler::Default().
+//====================================================================================================
+
+//----------------------------------------------------------------------------------------------------
+// Encoded -> linear & linear -> encoded. gamma is only used by E1N_TRANSFER_GAMMA.
+//----------------------------------------------------------------------------------------------------
+
+void e1nToLinear  (Mat &image, const e1nTransferCurve curve, const float gamma = 2.2f, e1nTileScheduler *scheduler = nullptr);
+void e1nFromLinear(Mat &image, const e1nTransferCurve curve, const float gamma = 2.2f, e1nTileScheduler *scheduler = nullptr);
+
+void e1nToLinear  (e1nColorPlanes &planes, const e1nTransferCurve curve, const float gamma = 2.2f, e1nTileScheduler *scheduler = nullptr);
+void e1nFromLinear(e1nColorPlanes &planes, const e1nTransferCurve curve, const float gamma = 2.2f, e1nTileScheduler *scheduler = nullptr);
+
+// The same over a bare run of floats, every value treated alike. Runs on the calling thread.
+void e1nToLinear  (float *values, const size_t count, const e1nTransferCurve curve, const float gamma = 2.2f);
+void e1nFromLinear(float *values, const size_t count, const e1nTransferCurve curve, const float gamma = 2.2f);
+
+//----------------------------------------------------------------------------------------------------
+// r, g & b to the given power; the batch form of e1nColor::PowRGB().
+//----------------------------------------------------------------------------------------------------
+
+void e1nPowRGB(Mat &image, const float exponent, e1nTileScheduler *scheduler = nullptr);
+void e1nPowRGB(e1nColorPlanes &planes, const float exponent, e1nTileScheduler *scheduler = nullptr);
+
+#endif     // E1NTRANSFER_H
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nColorBatchTest.cpp - Checks the e1nColor batch conversions against the scalar member functions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Every
+// check runs at each kernel level the CPU supports.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColor.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const string &what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+
+    if (!ok) {++failures;}
+}
+
+// Counts the pixels where two images of the same size & type differ in any bit.
+static int CountDifferences(const Mat &a, const Mat &b)
+{
+    int differences = 0;
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        const unsigned char *p = a.ptr(row);
+        const unsigned char *q = b.ptr(row);
+
+        for (int col = 0; col < a.cols; ++col, p += a.elemSize(), q += a.elemSize())
+        {
+            differences += memcmp(p, q, a.elemSize()) != 0;
+        }
+    }
+
+    return differences;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Inputs & scalar references:
+//----------------------------------------------------------------------------------------------------
+
+// Every 8-bit triple, once: 4096 x 4096 pixels.
+static Mat MakeAllBytes()
+{
+    Mat image(4096, 4096, CV_8UC3);
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        Vec3b *p = image.ptr<Vec3b>(row);
+
+        for (int col = 0; col < image.cols; ++col)
+        {
+            int i = row * image.cols + col;
+
+            p[col] = Vec3b((uchar) (i >> 16), (uchar) (i >> 8), (uchar) i);
+        }
+    }
+
+    return image;
+}
+
+// Floats spread over 0-1, off the 8-bit grid, plus the grid's exact grays & primaries.
+static Mat MakeFloats()
+{
+    Mat      image(512, 512, CV_32FC3);
+    uint32_t state = 12345u;
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        Vec3f *p = image.ptr<Vec3f>(row);
+
+        for (int col = 0; col < image.cols; ++col)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                state     = state * 1664525u + 1013904223u;
+                p[col][k] = (state >> 8) * (1.0f / 16777216.0f);
+            }
+        }
+    }
+
+    for (int i = 0; i < 256; ++i)
+    {
+        float v = i / 255.0f;
+
+        image.ptr<Vec3f>(0)[i]       = Vec3f(v, v, v);
+        image.ptr<Vec3f>(1)[i]       = Vec3f(v, 0.0f, 0.0f);
+        image.ptr<Vec3f>(1)[i + 256] = Vec3f(1.0f, v, 1.0f - v);
+    }
+
+    return image;
+}
+
+static Mat ScalarBytes(const Mat &image, const bool toHLS)
+{
+    Mat result(image.size(), image.type());
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        const Vec3b *p = image.ptr<Vec3b>(row);
+        Vec3b       *q = result.ptr<Vec3b>(row);
+
+        for (int col = 0; col < image.cols; ++col)
+        {
+            Vec3b    pixel = p[col];
+            e1nColor someColor(pixel);
+
+            if (toHLS) {someColor.ConvertRGB2HLS();}
+            else       {someColor.ConvertHLS2RGB();}
+
+            q[col] = someColor.GetVec3b();
+        }
+    }
+
+    return result;
+}
+
+static Mat ScalarFloats(const Mat &image, const bool toHLS)
+{
+    Mat result(image.size(), image.type());
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        const Vec3f *p = image.ptr<Vec3f>(row);
+        Vec3f       *q = result.ptr<Vec3f>(row);
+
+        for (int col = 0; col < image.cols; ++col)
+        {
+            e1nColor someColor(p[col][0], p[col][1], p[col][2]);
+
+            if (toHLS) {someColor.ConvertRGB2HLS();}
+            else       {someColor.ConvertHLS2RGB();}
+
+            q[col] = Vec3f(someColor.GetRedFloat(), someColor.GetGreenFloat(), someColor.GetBlueFloat());
+        }
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+    Mat bytes  = MakeAllBytes();
+    Mat floats = MakeFloats();
+
+    Mat bytesToHLS  = ScalarBytes(bytes, true);
+    Mat bytesToRGB  = ScalarBytes(bytes, false);
+    Mat floatsToHLS = ScalarFloats(floats, true);
+    Mat floatsToRGB = ScalarFloats(floats, false);
+
+    for (int level = E1N_CPU_SCALAR; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (!e1nSetCpuLevel((e1nCpuLevel) level)) {continue;}
+
+        string name = string(e1nGetCpuLevelName((e1nCpuLevel) level)) + ": ";
+        Mat    work;
+
+        work = bytes.clone();
+        e1nConvertRGB2HLS(work);
+        Check(CountDifferences(work, bytesToHLS) == 0, name + "8-bit RGB2HLS matches GetVec3b() for all 16.7M inputs");
+
+        work = bytes.clone();
+        e1nConvertHLS2RGB(work);
+        Check(CountDifferences(work, bytesToRGB) == 0, name + "8-bit HLS2RGB matches GetVec3b() for all 16.7M inputs");
+
+        work = floats.clone();
+        e1nConvertRGB2HLS(work);
+        Check(CountDifferences(work, floatsToHLS) == 0, name + "float RGB2HLS is bit-identical to ConvertRGB2HLS()");
+
+        work = floats.clone();
+        e1nConvertHLS2RGB(work);
+        Check(CountDifferences(work, floatsToRGB) == 0, name + "float HLS2RGB is bit-identical to ConvertHLS2RGB()");
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nLUT3DTest.cpp - Checks e1nColor's 3D lookup tables & their .cube files.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. The
+// lookups run at each kernel level the CPU supports. Writes its .cube file to the working directory &
+// removes it again.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nLUT3D.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const string &what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+
+    if (!ok) {++failures;}
+}
+
+// Floats spread over 0-1, plus the lattice's own corners.
+static Mat MakeFloats(const int channels)
+{
+    Mat      image(256, 256, CV_32FC(channels));
+    uint32_t state = 54321u;
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        float *p = image.ptr<float>(row);
+
+        for (int i = 0; i < image.cols * channels; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            p[i]  = (state >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        float *p = image.ptr<float>(0) + i * channels;
+
+        for (int k = 0; k < 3; ++k) {p[k] = (float) ((i >> k) & 1);}
+    }
+
+    return image;
+}
+
+// The largest difference over the first three channels of two float images of the same size.
+static double MaxDifference(const Mat &a, const Mat &b)
+{
+    double worst = 0.0;
+    int    cn    = a.channels();
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        const float *p = a.ptr<float>(row);
+        const float *q = b.ptr<float>(row);
+
+        for (int col = 0; col < a.cols; ++col)
+        {
+            for (int k = 0; k < 3; ++k) {worst = max(worst, (double) fabs(p[col * cn + k] - q[col * cn + k]));}
+        }
+    }
+
+    return worst;
+}
+
+static bool SameImage(const Mat &a, const Mat &b)
+{
+    if (a.size() != b.size() || a.type() != b.type()) {return false;}
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        if (memcmp(a.ptr(row), b.ptr(row), a.cols * a.elemSize()) != 0) {return false;}
+    }
+
+    return true;
+}
+
+// The largest difference between the entries of two LUTs of the same size.
+static double MaxEntryDifference(const e1nLUT3D &a, const e1nLUT3D &b)
+{
+    size_t points = (size_t) a.GetSize() * a.GetSize() * a.GetSize();
+    double worst  = 0.0;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        for (size_t i = 0; i < points; ++i) {worst = max(worst, (double) fabs(a.GetPlane(k)[i] - b.GetPlane(k)[i]));}
+    }
+
+    return worst;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+//     The identity at any size gives back what went in: interpolating a linear function is exact but
+// for float rounding, & every byte lands back on itself.
+static void TestIdentity(const string &name)
+{
+    for (int lutSize : {2, 17, 33})
+    {
+        e1nLUT3D lut(lutSize);
+        char     label[64];
+
+        snprintf(label, sizeof(label), "%d^3 identity", lutSize);
+
+        for (int channels : {3, 4})
+        {
+            Mat source = MakeFloats(channels);
+            Mat result = source.clone();
+
+            lut.Apply(result);
+
+            bool alphaKept = true;
+
+            for (int row = 0; channels == 4 && row < source.rows; ++row)
+            {
+                for (int col = 0; col < source.cols; ++col) {alphaKept &= result.ptr<float>(row)[col * 4 + 3] == source.ptr<float>(row)[col * 4 + 3];}
+            }
+
+            Check(MaxDifference(result, source) <= 1.0e-6 && alphaKept,
+                  name + label + (channels == 3 ? " leaves float RGB within 1e-6" : " leaves float RGBA within 1e-6 & keeps alpha"));
+        }
+
+        Mat bytes(256, 256, CV_8UC3);
+
+        for (int row = 0; row < 256; ++row)
+        {
+            for (int col = 0; col < 256; ++col) {bytes.ptr<Vec3b>(row)[col] = Vec3b((uchar) col, (uchar) row, (uchar) (row ^ col));}
+        }
+
+        Mat result;
+
+        lut.Apply(bytes, result);
+
+        Check(SameImage(result, bytes), name + label + " leaves every 8-bit value unchanged");
+    }
+}
+
+// Inputs outside the domain are clamped to it.
+static void TestClamping(const string &name)
+{
+    e1nLUT3D lut(17);
+    float    r[4] = {-0.5f, 1.5f, -100.0f, 0.25f};
+    float    g[4] = {1.5f, -0.5f, 100.0f, 2.0f};
+    float    b[4] = {0.5f, 0.5f, 0.0f, -1.0f};
+
+    lut.ApplyPlanes(r, g, b, 4);
+
+    bool ok = r[0] == 0.0f && g[0] == 1.0f && r[1] == 1.0f && g[1] == 0.0f && r[2] == 0.0f && g[2] == 1.0f && b[2] == 0.0f
+           && g[3] == 1.0f && b[3] == 0.0f && fabs(b[0] - 0.5f) <= 1.0e-6f && fabs(r[3] - 0.25f) <= 1.0e-6f;
+
+    Check(ok, name + "inputs outside the domain are clamped to it");
+}
+
+//     A baked grade saved & loaded again keeps its size, title & domain, & its entries to the six
+// decimals the file holds, give or take a float rounding.
+static void TestSaveLoad()
+{
+    e1nPipeline grade;
+
+    grade.ConvertRGB2HLS().ShiftHue(-0.02f).ScaleSat(1.2f).ShiftVal(0.05f).ConvertHLS2RGB();
+
+    e1nLUT3D baked;
+
+    baked.SetDomain(-0.25f, 1.5f);
+    baked.Bake(grade, 17);
+    baked.SetTitle("e1nLUT3DTest grade");
+
+    Check(baked.Save("e1nLUT3DTest.cube"), "Save() writes the .cube file");
+
+    e1nLUT3D loaded;
+
+    loaded.Load("e1nLUT3DTest.cube");
+    remove("e1nLUT3DTest.cube");
+
+    bool header = loaded.GetSize() == 17 && loaded.GetTitle() == "e1nLUT3DTest grade";
+
+    for (int k = 0; k < 3; ++k) {header &= loaded.GetDomainMin()[k] == -0.25f && loaded.GetDomainMax()[k] == 1.5f;}
+
+    Check(header, "a loaded .cube keeps its size, title & domain");
+    Check(MaxEntryDifference(baked, loaded) <= 6.0e-7, "a loaded .cube keeps its entries within 6e-7");
+
+    // A unit-domain identity has no DOMAIN lines, & comes back as the same identity.
+    e1nLUT3D     identity(5);
+    e1nLUT3D     reread;
+    stringstream text;
+
+    identity.Write(text);
+    reread.Read(text);
+
+    Check(text.str().find("DOMAIN") == string::npos && MaxEntryDifference(identity, reread) <= 5.0e-7,
+          "a written identity reads back as the identity");
+}
+
+// What else a .cube may hold, & what it mustn't.
+static void TestRead()
+{
+    stringstream text("# A comment\n"
+                      "TITLE \"two\"\n"
+                      "LUT_3D_INPUT_RANGE 0.0 2.0\n"
+                      "LUT_3D_SIZE 2\n"
+                      "SOME_APP_KEYWORD 7\n"
+                      "\n"
+                      "0 0 0\n1 0 0\n0 1 0\n1 1 0\n0 0 1\n1 0 1\n0 1 1\n1 1 1\n");
+    e1nLUT3D     lut;
+    float        rgb[3];
+
+    lut.Read(text);
+    lut.GetEntry(1, 0, 1, rgb);
+
+    Check(lut.GetSize() == 2 && lut.GetTitle() == "two" && lut.GetDomainMax()[1] == 2.0f && rgb[0] == 1.0f && rgb[1] == 0.0f && rgb[2] == 1.0f,
+          "Read() takes comments, LUT_3D_INPUT_RANGE & unknown keywords, with red varying fastest");
+
+    const char *bad[] = {"0 0 0\n",
+                         "LUT_3D_SIZE 2\n0 0 0\n",
+                         "LUT_3D_SIZE 1\n",
+                         "LUT_1D_SIZE 16\n",
+                         "LUT_3D_SIZE 2\n0 0\n"};
+
+    bool allThrew = true;
+
+    for (const char *contents : bad)
+    {
+        stringstream badText(contents);
+        e1nLUT3D     kept(3);
+        bool         threw = false;
+
+        try {kept.Read(badText);}
+        catch (const cv::Exception &) {threw = true;}
+
+        allThrew &= threw && kept.GetSize() == 3;
+    }
+
+    Check(allThrew, "Read() raises on malformed files & leaves the LUT as it was");
+}
+
+int main()
+{
+    for (int level = E1N_CPU_SCALAR; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (!e1nSetCpuLevel((e1nCpuLevel) level)) {continue;}
+
+        string name = string(e1nGetCpuLevelName((e1nCpuLevel) level)) + ": ";
+
+        TestIdentity(name);
+        TestClamping(name);
+    }
+
+    TestSaveLoad();
+    TestRead();
+
+    return failures ? 1 : 0;
+}
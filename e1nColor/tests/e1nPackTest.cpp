@@ -0,0 +1,263 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPackTest.cpp - Checks e1nColor's float to 8 & 16-bit packing & dithering.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Every
+// check runs at each kernel level the CPU supports.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPack.h"
+#include "lib/e1nColor/e1nColorLUT.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const string &what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+
+    if (!ok) {++failures;}
+}
+
+//     Floats over -0.25-1.25, so a fifth of them need clamping, with the first row given over to the
+// awkward cases: NaN, the infinities, the ends of the range & the 8-bit rounding midpoints.
+static Mat MakeFloats(const int rows, const int cols, const int channels)
+{
+    Mat      image(rows, cols, CV_32FC(channels));
+    uint32_t state = 24680u;
+
+    for (int row = 0; row < rows; ++row)
+    {
+        float *p = image.ptr<float>(row);
+
+        for (int i = 0; i < cols * channels; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            p[i]  = (state >> 8) * (1.5f / 16777216.0f) - 0.25f;
+        }
+    }
+
+    const float special[] = {numeric_limits<float>::quiet_NaN(), numeric_limits<float>::infinity(),
+                             -numeric_limits<float>::infinity(), -0.0f, 0.0f, 1.0f, -1.0f, 2.0f};
+
+    float *p     = image.ptr<float>(0);
+    int   length = cols * channels;
+    int   i      = 0;
+
+    for (float x : special) {if (i < length) {p[i++] = x;}}
+
+    for (int step = 0; step < 255 && i < length; ++step) {p[i++] = (step + 0.5f) / 255.0f;}
+
+    return image;
+}
+
+// What the packed value should be without dithering: e1nFloatToByte(), & its 16-bit equivalent.
+static int Expected(const float x, const bool words)
+{
+    if (!words) {return e1nFloatToByte(x);}
+
+    float clamped = x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f;
+
+    return (int) (clamped * 65535.0f + 0.5f);
+}
+
+static int Sample(const Mat &image, const int row, const int i)
+{
+    return image.depth() == CV_16U ? image.ptr<unsigned short>(row)[i] : image.ptr<unsigned char>(row)[i];
+}
+
+static bool SameImage(const Mat &a, const Mat &b)
+{
+    if (a.size() != b.size() || a.type() != b.type()) {return false;}
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        if (memcmp(a.ptr(row), b.ptr(row), a.cols * a.elemSize()) != 0) {return false;}
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+//     Without dithering every value is rounded as e1nFloatToByte() rounds it, clamped & with NaN to 0,
+// from a Mat or from planes, & alpha is kept, dropped or filled in as the two sides call for.
+static void TestNoDither(const string &name)
+{
+    const int dstTypes[] = {CV_8UC3, CV_8UC4, CV_16UC3, CV_16UC4};
+
+    for (int channels : {3, 4})
+    {
+        Mat            source = MakeFloats(67, 301, channels);
+        e1nColorPlanes planes(source);
+
+        for (int dstType : dstTypes)
+        {
+            Mat  fromMat;
+            Mat  fromPlanes;
+            bool words  = CV_MAT_DEPTH(dstType) == CV_16U;
+            int  outCn  = CV_MAT_CN(dstType);
+            int  top    = words ? 65535 : 255;
+            bool values = true;
+
+            e1nPack(source, fromMat, dstType);
+            e1nPack(planes, fromPlanes, dstType);
+
+            for (int row = 0; row < source.rows; ++row)
+            {
+                const float *p = source.ptr<float>(row);
+
+                for (int col = 0; col < source.cols; ++col)
+                {
+                    for (int k = 0; k < outCn; ++k)
+                    {
+                        int expected = k < channels ? Expected(p[col * channels + k], words) : top;
+
+                        values &= Sample(fromMat, row, col * outCn + k) == expected;
+                    }
+                }
+            }
+
+            char label[96];
+
+            snprintf(label, sizeof(label), "no dither, %d channels to %d-bit x %d, matches e1nFloatToByte() rounding",
+                     channels, words ? 16 : 8, outCn);
+
+            Check(values && SameImage(fromMat, fromPlanes), name + label);
+        }
+    }
+
+    Mat            edges(1, 8, CV_32FC3);
+    const float    in[8]  = {numeric_limits<float>::quiet_NaN(), -1.0f, -0.0f, 0.5f / 255.0f, 0.999f, 1.0f, 2.0f,
+                             numeric_limits<float>::infinity()};
+    const int      out[8] = {0, 0, 0, 1, 255, 255, 255, 255};
+    Mat            packed;
+    bool           ok = true;
+
+    for (int i = 0; i < 8; ++i) {edges.ptr<Vec3f>(0)[i] = Vec3f(in[i], in[i], in[i]);}
+
+    e1nPack(edges, packed, CV_8UC3);
+
+    for (int i = 0; i < 8; ++i) {ok &= packed.ptr<Vec3b>(0)[i][0] == out[i] && packed.ptr<Vec3b>(0)[i][2] == out[i];}
+
+    Check(ok, name + "values clamp to 0-255, NaN packs to 0 & 0.5 / 255 rounds up");
+}
+
+//     Error diffusion runs rows as a wavefront across the threads, & must come out exactly as a single
+// thread's top-to-bottom pass would.
+static void TestDiffusionThreads(const string &name)
+{
+    e1nTileScheduler one(1);
+    e1nTileScheduler many(8);
+    e1nPackOptions   options;
+
+    options.dither = E1N_DITHER_ERROR_DIFFUSION;
+
+    const int dstTypes[] = {CV_8UC3, CV_8UC4, CV_16UC3, CV_16UC4};
+
+    for (int channels : {3, 4})
+    {
+        Mat source = MakeFloats(97, 1013, channels);
+
+        for (int dstType : dstTypes)
+        {
+            Mat serial;
+            Mat parallel;
+
+            e1nPack(source, serial, dstType, options, &one);
+
+            bool same = true;
+
+            for (int run = 0; run < 4; ++run)
+            {
+                e1nPack(source, parallel, dstType, options, &many);
+
+                same &= SameImage(serial, parallel);
+            }
+
+            char label[96];
+
+            snprintf(label, sizeof(label), "error diffusion, %d channels to %d-bit x %d, is the same at 1 & 8 threads",
+                     channels, CV_MAT_DEPTH(dstType) == CV_16U ? 16 : 8, CV_MAT_CN(dstType));
+
+            Check(same, name + label);
+        }
+    }
+}
+
+//     On a flat area every dither averages out to the value itself, where plain rounding is off by up
+// to half a level; & a dither at strength 0 is plain rounding.
+static void TestDitherMeans(const string &name)
+{
+    const int   modes[]  = {E1N_DITHER_BAYER, E1N_DITHER_BLUE_NOISE, E1N_DITHER_ERROR_DIFFUSION};
+    const char *labels[] = {"Bayer", "blue noise", "error diffusion"};
+    const float level    = 76.3f / 255.0f;
+
+    Mat flat(128, 128, CV_32FC3);
+
+    for (int row = 0; row < flat.rows; ++row)
+    {
+        for (int col = 0; col < flat.cols; ++col) {flat.ptr<Vec3f>(row)[col] = Vec3f(level, level, level);}
+    }
+
+    Mat plain;
+
+    e1nPack(flat, plain, CV_8UC3);
+
+    for (int m = 0; m < 3; ++m)
+    {
+        e1nPackOptions options;
+        Mat            dithered;
+        double         sum = 0.0;
+
+        options.dither = modes[m];
+
+        e1nPack(flat, dithered, CV_8UC3, options);
+
+        for (int row = 0; row < flat.rows; ++row)
+        {
+            for (int col = 0; col < flat.cols; ++col) {sum += dithered.ptr<Vec3b>(row)[col][1];}
+        }
+
+        Check(fabs(sum / (flat.rows * flat.cols) - 76.3) <= 0.02, name + labels[m] + " averages a flat 76.3 to within 0.02");
+
+        options.strength = 0.0f;
+
+        e1nPack(flat, dithered, CV_8UC3, options);
+
+        Check(SameImage(dithered, plain), name + labels[m] + " at strength 0 is plain rounding");
+    }
+}
+
+int main()
+{
+    for (int level = E1N_CPU_SCALAR; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (!e1nSetCpuLevel((e1nCpuLevel) level)) {continue;}
+
+        string name = string(e1nGetCpuLevelName((e1nCpuLevel) level)) + ": ";
+
+        TestNoDither(name);
+        TestDiffusionThreads(name);
+        TestDitherMeans(name);
+    }
+
+    return failures ? 1 : 0;
+}
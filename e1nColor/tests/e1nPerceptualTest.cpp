@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nPerceptualTest.cpp - Checks e1nColor's XYZ, Lab & OKLab conversions.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Checks
+// the accuracy stated in e1nPerceptual.h, at each kernel level the CPU supports.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nPerceptual.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const string &what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+
+    if (!ok) {++failures;}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     The double-precision reference: the same published matrices & constants as the kernels, with
+// none of the single-precision rounding or the Cbrt() approximation.
+//----------------------------------------------------------------------------------------------------
+
+static void Multiply(const double *m, double *c)
+{
+    double x = m[0] * c[0] + m[1] * c[1] + m[2] * c[2];
+    double y = m[3] * c[0] + m[4] * c[1] + m[5] * c[2];
+    double z = m[6] * c[0] + m[7] * c[1] + m[8] * c[2];
+
+    c[0] = x;
+    c[1] = y;
+    c[2] = z;
+}
+
+static void ReferenceXYZ(double *c)
+{
+    static const double rgb2xyz[9] = {0.4124564, 0.3575761, 0.1804375,
+                                      0.2126729, 0.7151522, 0.0721750,
+                                      0.0193339, 0.1191920, 0.9503041};
+
+    Multiply(rgb2xyz, c);
+}
+
+static double LabF(const double t)
+{
+    return t > 216.0 / 24389.0 ? cbrt(t) : t * (24389.0 / 27.0 / 116.0) + 4.0 / 29.0;
+}
+
+static void ReferenceLab(double *c)
+{
+    ReferenceXYZ(c);
+
+    double fx = LabF(c[0] / 0.95047);
+    double fy = LabF(c[1]);
+    double fz = LabF(c[2] / 1.08883);
+
+    c[0] = 116.0 * fy - 16.0;
+    c[1] = 500.0 * (fx - fy);
+    c[2] = 200.0 * (fy - fz);
+}
+
+static void ReferenceOKLab(double *c)
+{
+    static const double rgb2lms[9] = {0.4122214708, 0.5363325363, 0.0514459929,
+                                      0.2119034982, 0.6806995451, 0.1073969566,
+                                      0.0883024619, 0.2817188376, 0.6299787005};
+
+    static const double lms2lab[9] = {0.2104542553,  0.7936177850, -0.0040720468,
+                                      1.9779984951, -2.4285922050,  0.4505937099,
+                                      0.0259040371,  0.7827717662, -0.8086757660};
+
+    Multiply(rgb2lms, c);
+
+    for (int k = 0; k < 3; ++k) {c[k] = cbrt(c[k]);}
+
+    Multiply(lms2lab, c);
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+typedef void (*ConvertFn)(Mat &image, const e1nTransferCurve curve, e1nTileScheduler *scheduler);
+typedef void (*ReferenceFn)(double *c);
+
+// Linear RGB on a 65-step grid over the unit cube.
+static Mat MakeGrid()
+{
+    Mat image(65 * 65, 65, CV_32FC3);
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        Vec3f *p = image.ptr<Vec3f>(row);
+
+        for (int col = 0; col < image.cols; ++col) {p[col] = Vec3f(row / 65 / 64.0f, row % 65 / 64.0f, col / 64.0f);}
+    }
+
+    return image;
+}
+
+// The largest channel difference between two float images of the same size.
+static double MaxDifference(const Mat &a, const Mat &b)
+{
+    double worst = 0.0;
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        for (int col = 0; col < a.cols; ++col)
+        {
+            for (int k = 0; k < 3; ++k) {worst = max(worst, (double) fabs(a.ptr<Vec3f>(row)[col][k] - b.ptr<Vec3f>(row)[col][k]));}
+        }
+    }
+
+    return worst;
+}
+
+static void TestSpace(const string &name, const char *space, ConvertFn forward, ConvertFn back, ReferenceFn reference,
+                      const double tolerance, const Mat &grid)
+{
+    Mat    work  = grid.clone();
+    double worst = 0.0;
+
+    forward(work, E1N_TRANSFER_LINEAR, nullptr);
+
+    for (int row = 0; row < grid.rows; ++row)
+    {
+        for (int col = 0; col < grid.cols; ++col)
+        {
+            double c[3] = {grid.ptr<Vec3f>(row)[col][0], grid.ptr<Vec3f>(row)[col][1], grid.ptr<Vec3f>(row)[col][2]};
+
+            reference(c);
+
+            for (int k = 0; k < 3; ++k) {worst = max(worst, fabs(work.ptr<Vec3f>(row)[col][k] - c[k]));}
+        }
+    }
+
+    char within[32];
+
+    snprintf(within, sizeof(within), " within %g", tolerance);
+
+    Check(worst <= tolerance, name + space + within + " of the double-precision reference");
+
+    back(work, E1N_TRANSFER_LINEAR, nullptr);
+
+    Check(MaxDifference(work, grid) <= 5.0e-6, name + space + " round trip within 5e-6 for linear RGB");
+
+    // The same through the sRGB curve, starting from the grid as encoded values.
+    work = grid.clone();
+
+    forward(work, E1N_TRANSFER_SRGB, nullptr);
+    back(work, E1N_TRANSFER_SRGB, nullptr);
+
+    Check(MaxDifference(work, grid) <= 1.0e-4, name + space + " round trip within 1e-4 through sRGB");
+}
+
+int main()
+{
+    Mat grid = MakeGrid();
+
+    for (int level = E1N_CPU_SCALAR; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (!e1nSetCpuLevel((e1nCpuLevel) level)) {continue;}
+
+        string name = string(e1nGetCpuLevelName((e1nCpuLevel) level)) + ": ";
+
+        TestSpace(name, "XYZ",   e1nConvertRGB2XYZ,   e1nConvertXYZ2RGB,   ReferenceXYZ,   2.0e-7, grid);
+        TestSpace(name, "Lab",   e1nConvertRGB2Lab,   e1nConvertLab2RGB,   ReferenceLab,   2.0e-4, grid);
+        TestSpace(name, "OKLab", e1nConvertRGB2OKLab, e1nConvertOKLab2RGB, ReferenceOKLab, 1.0e-6, grid);
+    }
+
+    return failures ? 1 : 0;
+}
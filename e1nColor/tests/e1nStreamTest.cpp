@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nStreamTest.cpp - Checks for e1nColor's streaming of 16-bit rasters.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Writes
+// its TIFFs to the working directory & removes them again.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorBatch.h"
+#include "lib/e1nColor/e1nStream.h"
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstring>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+
+    if (!ok) {++failures;}
+}
+
+// A 16-bit image whose samples use the low bits too, so an 8-bit round trip anywhere would show.
+static Mat MakeImage(const int rows, const int cols, const int type, const int seed)
+{
+    Mat image(rows, cols, type);
+    int cn = image.channels();
+
+    for (int row = 0; row < rows; ++row)
+    {
+        unsigned short *p = image.ptr<unsigned short>(row);
+
+        for (int i = 0; i < cols * cn; ++i) {p[i] = (unsigned short) ((row * 7919 + i * 104729 + seed * 31) & 0xFFFF);}
+    }
+
+    return image;
+}
+
+static bool SameImage(const Mat &a, const Mat &b)
+{
+    if (a.size() != b.size() || a.type() != b.type()) {return false;}
+
+    for (int row = 0; row < a.rows; ++row)
+    {
+        if (memcmp(a.ptr(row), b.ptr(row), a.cols * a.elemSize()) != 0) {return false;}
+    }
+
+    return true;
+}
+
+static void WriteTIFF(const string &path, const Mat &image)
+{
+    e1nRasterWriter writer;
+
+    writer.CreateTIFF(path, image.rows, image.cols, image.type());
+    writer.WriteRows(image);
+    writer.Close();
+}
+
+static Mat ReadTIFF(const string &path)
+{
+    e1nMappedRaster raster;
+
+    raster.OpenTIFF(path);
+
+    Mat image(raster.GetSize(), raster.Type());
+
+    raster.CopyRows(0, image);
+
+    return image;
+}
+
+// Streams source.tif through the processor's chain into result.tif & reads the result back.
+static Mat Stream(e1nStreamProcessor &processor, const Mat &source)
+{
+    WriteTIFF("e1nStreamTest.source.tif", source);
+
+    e1nMappedRaster input;
+    e1nRasterWriter output;
+
+    input.OpenTIFF("e1nStreamTest.source.tif");
+    output.CreateTIFF("e1nStreamTest.result.tif", input.Rows(), input.Cols(), input.Type());
+
+    processor.Run(input, output);
+
+    output.Close();
+    input.Close();
+
+    Mat result = ReadTIFF("e1nStreamTest.result.tif");
+
+    remove("e1nStreamTest.source.tif");
+    remove("e1nStreamTest.result.tif");
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+// Every 16-bit value comes back out of e1nUnpackRow() & e1nPackRow() as it went in.
+static void TestRowRoundTrip()
+{
+    Mat image(1, 65536, CV_16UC4);
+    Mat packed(1, 65536, CV_16UC4);
+
+    for (int i = 0; i < 65536; ++i)
+    {
+        unsigned short *p = image.ptr<unsigned short>(0) + i * 4;
+
+        p[0] = (unsigned short) i;
+        p[1] = (unsigned short) (65535 - i);
+        p[2] = (unsigned short) (i * 3);
+        p[3] = (unsigned short) (i * 5);
+    }
+
+    vector<float> c0(65536), c1(65536), c2(65536), c3(65536);
+
+    e1nUnpackRow(image, 0, 0, 65536, c0.data(), c1.data(), c2.data(), c3.data());
+
+    bool scaled = c0[0] == 0.0f && c0[65535] == 1.0f && c1[0] == 1.0f;
+
+    e1nPackRow(packed, 0, 0, 65536, c0.data(), c1.data(), c2.data(), c3.data());
+
+    Check(scaled, "16-bit samples unpack to 0-1");
+    Check(SameImage(image, packed), "every 16-bit sample survives unpacking & packing");
+}
+
+static void TestStreamCopy()
+{
+    e1nTileScheduler   scheduler(4, Size(32, 8));
+    e1nStreamProcessor processor(16, &scheduler);
+    Mat                source = MakeImage(100, 75, CV_16UC3, 1);
+
+    Check(SameImage(Stream(processor, source), source), "a 16-bit TIFF streams through an empty chain unchanged");
+}
+
+// The conversions run through e1nPipeline, so streamed tiles must match a whole-image run exactly.
+static void TestStreamConvert()
+{
+    e1nTileScheduler   scheduler(4, Size(32, 8));
+    e1nStreamProcessor processor(16, &scheduler);
+    e1nPipeline        pipeline(&scheduler);
+
+    processor.Add(e1nStripRGB2HLS());
+    pipeline.ConvertRGB2HLS();
+
+    for (int type : {CV_16UC3, CV_16UC4})
+    {
+        Mat source   = MakeImage(100, 75, type, 2);
+        Mat expected = source.clone();
+
+        pipeline.Run(expected);
+
+        Mat result = Stream(processor, source);
+
+        Check(SameImage(result, expected), type == CV_16UC3 ? "streamed 16-bit RGB2HLS matches e1nPipeline"
+                                                            : "streamed 16-bit RGBA RGB2HLS matches e1nPipeline");
+
+        if (type == CV_16UC4)
+        {
+            bool alphaKept = true;
+
+            for (int row = 0; row < source.rows; ++row)
+            {
+                for (int col = 0; col < source.cols; ++col)
+                {
+                    alphaKept &= result.ptr<unsigned short>(row)[col * 4 + 3] == source.ptr<unsigned short>(row)[col * 4 + 3];
+                }
+            }
+
+            Check(alphaKept, "streamed 16-bit RGB2HLS keeps alpha");
+        }
+    }
+}
+
+static void TestStreamBlend()
+{
+    e1nTileScheduler   scheduler(4, Size(32, 8));
+    e1nStreamProcessor processor(16, &scheduler);
+    Mat                source = MakeImage(100, 75, CV_16UC3, 3);
+    Mat                layer  = MakeImage(100, 75, CV_16UC3, 4);
+
+    WriteTIFF("e1nStreamTest.layer.tif", layer);
+
+    e1nMappedRaster layerRaster;
+
+    layerRaster.OpenTIFF("e1nStreamTest.layer.tif");
+    processor.Add(e1nStripBlend(layerRaster, E1N_BLEND_MULTIPLY, 0.75f));
+
+    Mat expected = source.clone();
+
+    e1nBlend(expected, layer, E1N_BLEND_MULTIPLY, 0.75f);
+
+    Check(SameImage(Stream(processor, source), expected), "streamed 16-bit blend matches e1nBlend()");
+
+    layerRaster.Close();
+    remove("e1nStreamTest.layer.tif");
+}
+
+int main()
+{
+    TestRowRoundTrip();
+    TestStreamCopy();
+    TestStreamConvert();
+    TestStreamBlend();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nTileSchedulerTest.cpp - Checks for the e1nColor tile scheduler.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Best run
+// under AddressSanitizer, which catches a thread index past the end of a per-thread array outright.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nColorStats.h"
+#include "lib/e1nColor/e1nTileScheduler.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdio>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+
+    if (!ok) {++failures;}
+}
+
+static bool SameChannel(const e1nChannelStats &a, const e1nChannelStats &b)
+{
+    return a.mean == b.mean && a.variance == b.variance && a.min == b.min && a.max == b.max;
+}
+
+//     Both runs go through the same one-thread scheduler, tile by tile in the same order, so every
+// field should match exactly.
+static bool SameStats(const e1nHLSStats &a, const e1nHLSStats &b)
+{
+    return a.pixels == b.pixels && a.grayPixels == b.grayPixels &&
+           a.hueHist == b.hueHist && a.satHist == b.satHist && a.valHist == b.valHist &&
+           SameChannel(a.hue, b.hue) && SameChannel(a.sat, b.sat) && SameChannel(a.val, b.val) &&
+           a.hueMean == b.hueMean && a.hueConcentration == b.hueConcentration && a.hueSpread == b.hueSpread &&
+           a.dominantHue == b.dominantHue;
+}
+
+//----------------------------------------------------------------------------------------------------
+//     A job nested inside another scheduler's job runs serially, & must be given thread indices in
+// its own scheduler's range, not the outer worker's.
+//----------------------------------------------------------------------------------------------------
+
+static void TestNestedOtherScheduler()
+{
+    e1nTileScheduler big(8, Size(16, 16));
+    e1nTileScheduler small(1);
+    e1nTileScheduler pair(2);
+    atomic<int>      outOfRange(0);
+
+    big.ParallelFor(64, [&](const int, const int)
+    {
+        small.ParallelFor(4, [&](const int, const int thread) {if (thread != 0) {++outOfRange;}});
+        pair.ParallelFor(4,  [&](const int, const int thread) {if (thread < 0 || thread >= 2) {++outOfRange;}});
+    });
+
+    Check(outOfRange.load() == 0, "nested job on another scheduler gets its own thread indices");
+
+    // The same through a library function with per-thread accumulators.
+    Mat image(64, 64, CV_8UC3);
+
+    for (int row = 0; row < image.rows; ++row)
+    {
+        for (int col = 0; col < image.cols; ++col) {image.ptr<Vec3b>(row)[col] = Vec3b(40, 120, (uchar) (col * 4));}
+    }
+
+    e1nHLSStats expected = e1nComputeStats(image, e1nStatsOptions(), e1nMask(), &small);
+    atomic<int> differences(0);
+
+    big.ForEachTile(image.size(), [&](const Rect &, const int)
+    {
+        e1nHLSStats nested = e1nComputeStats(image, e1nStatsOptions(), e1nMask(), &small);
+
+        if (!SameStats(nested, expected)) {++differences;}
+    });
+
+    Check(differences.load() == 0, "e1nComputeStats() inside another scheduler's tiles matches a serial run");
+}
+
+// A job nested inside the same scheduler keeps the index of the thread it runs on.
+static void TestNestedSameScheduler()
+{
+    e1nTileScheduler pool(4);
+    atomic<int>      mismatches(0);
+
+    pool.ParallelFor(16, [&](const int, const int outer)
+    {
+        pool.ParallelFor(4, [&](const int, const int inner) {if (inner != outer) {++mismatches;}});
+    });
+
+    Check(mismatches.load() == 0, "nested job on the same scheduler keeps the thread index");
+}
+
+int main()
+{
+    TestNestedOtherScheduler();
+    TestNestedSameScheduler();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//  e1nTransferTest.cpp - Checks e1nColor's transfer curves against a double-precision reference.
+//
+//  Copyright © 2022 Kunst Logic LLC. All rights reserved.
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//     Standalone: builds against the library & exits 0 if every check passes, 1 otherwise. Checks
+// the accuracy stated in e1nTransfer.h, at each kernel level the CPU supports.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Includes:
+#include "lib/stdafx.h"
+#include "lib/e1nColor/e1nTransfer.h"
+#include "lib/e1nColor/e1nCpuDispatch.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Preprocessor directives:
+using namespace std;
+using namespace cv;
+
+static int failures = 0;
+
+static void Check(const bool ok, const string &what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+
+    if (!ok) {++failures;}
+}
+
+//----------------------------------------------------------------------------------------------------
+//     The reference curves, in double precision. The breakpoints are compared as the floats the
+// kernels use: the Rec.709 curve jumps by 2e-4 at its breakpoint, so a double breakpoint would flag
+// the one float that falls between the two as wrong.
+//----------------------------------------------------------------------------------------------------
+
+static double ReferenceToLinear(const e1nTransferCurve curve, const float x, const double gamma)
+{
+    double a = fabs((double) x);
+    double y;
+
+    if      (curve == E1N_TRANSFER_SRGB)   {y = fabs(x) <= 0.04045f ? a / 12.92 : pow((a + 0.055) / 1.055, 2.4);}
+    else if (curve == E1N_TRANSFER_REC709) {y = fabs(x) < 0.081f ? a / 4.5 : pow((a + 0.099) / 1.099, 1.0 / 0.45);}
+    else                                   {y = pow(a, gamma);}
+
+    return x < 0.0f ? -y : y;
+}
+
+static double ReferenceFromLinear(const e1nTransferCurve curve, const float x, const double gamma)
+{
+    double a = fabs((double) x);
+    double y;
+
+    if      (curve == E1N_TRANSFER_SRGB)   {y = fabs(x) <= 0.0031308f ? a * 12.92 : 1.055 * pow(a, 1.0 / 2.4) - 0.055;}
+    else if (curve == E1N_TRANSFER_REC709) {y = fabs(x) < 0.018f ? a * 4.5 : 1.099 * pow(a, 0.45) - 0.099;}
+    else                                   {y = pow(a, 1.0 / gamma);}
+
+    return x < 0.0f ? -y : y;
+}
+
+static double Reference(const e1nTransferCurve curve, const bool toLinear, const float x, const double gamma)
+{
+    return toLinear ? ReferenceToLinear(curve, x, gamma) : ReferenceFromLinear(curve, x, gamma);
+}
+
+static void Apply(const e1nTransferCurve curve, const bool toLinear, float *values, const size_t count, const float gamma)
+{
+    if (toLinear) {e1nToLinear  (values, count, curve, gamma);}
+    else          {e1nFromLinear(values, count, curve, gamma);}
+}
+
+// 0-1.5 in 1.5M even steps, plus a sweep down through the small values.
+static vector<float> MakeInputs()
+{
+    vector<float> inputs;
+
+    for (int i = 0; i <= 1500000; ++i) {inputs.push_back(i * (1.5f / 1500000.0f));}
+    for (float x = 1.0e-30f; x < 1.0e-3f; x *= 1.001f) {inputs.push_back(x);}
+
+    return inputs;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Tests:
+//----------------------------------------------------------------------------------------------------
+
+// sRGB & Rec.709: within 1.1e-6 absolute & 1e-6 relative, both directions.
+static void TestPiecewise(const string &name, const vector<float> &inputs)
+{
+    const e1nTransferCurve curves[] = {E1N_TRANSFER_SRGB, E1N_TRANSFER_REC709};
+    const char            *names[]  = {"sRGB", "Rec.709"};
+
+    for (int c = 0; c < 2; ++c)
+    {
+        for (int toLinear = 0; toLinear < 2; ++toLinear)
+        {
+            vector<float> values   = inputs;
+            double        worstAbs = 0.0;
+            double        worstRel = 0.0;
+
+            Apply(curves[c], toLinear != 0, values.data(), values.size(), 2.2f);
+
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                double exact = Reference(curves[c], toLinear != 0, inputs[i], 2.2);
+                double error = fabs(values[i] - exact);
+
+                worstAbs = max(worstAbs, error);
+
+                if (exact != 0.0) {worstRel = max(worstRel, error / fabs(exact));}
+            }
+
+            Check(worstAbs <= 1.1e-6 && worstRel <= 1.0e-6,
+                  name + names[c] + (toLinear ? " to linear" : " from linear") + " within 1.1e-6 absolute & 1e-6 relative");
+        }
+    }
+}
+
+// Gamma / Pow: relative error within 3e-7 + 8e-8 * |exponent| * (1 + |log2(x)|).
+static void TestGamma(const string &name, const vector<float> &inputs)
+{
+    const float gammas[] = {0.1f, 0.45f, 1.0f / 2.2f, 1.5f, 2.2f, 2.4f, 3.0f, 8.0f};
+
+    bool ok = true;
+
+    for (float gamma : gammas)
+    {
+        vector<float> values = inputs;
+
+        e1nToLinear(values.data(), values.size(), E1N_TRANSFER_GAMMA, gamma);
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            double exact = pow((double) inputs[i], (double) gamma);
+
+            // Below the smallest normal float the result can't carry the relative precision.
+            if (exact < 1.0e-37) {continue;}
+
+            double bound = 3.0e-7 + 8.0e-8 * gamma * (1.0 + fabs(log2((double) inputs[i])));
+
+            ok &= fabs(values[i] - exact) <= bound * exact;
+        }
+    }
+
+    Check(ok, name + "gamma within 3e-7 + 8e-8 * |exponent| * (1 + |log2(x)|) relative");
+}
+
+// Negative values keep their sign, & values over 1 carry on along the curve.
+static void TestSigns(const string &name)
+{
+    const e1nTransferCurve curves[] = {E1N_TRANSFER_SRGB, E1N_TRANSFER_REC709, E1N_TRANSFER_GAMMA};
+
+    bool ok = true;
+
+    for (e1nTransferCurve curve : curves)
+    {
+        for (int toLinear = 0; toLinear < 2; ++toLinear)
+        {
+            float positive[4] = {0.002f, 0.25f, 1.0f, 1.5f};
+            float negative[4] = {-0.002f, -0.25f, -1.0f, -1.5f};
+
+            Apply(curve, toLinear != 0, positive, 4, 2.2f);
+            Apply(curve, toLinear != 0, negative, 4, 2.2f);
+
+            for (int i = 0; i < 4; ++i) {ok &= negative[i] == -positive[i];}
+
+            ok &= positive[3] > positive[2];
+        }
+    }
+
+    Check(ok, name + "negative inputs mirror the positive ones & the curves carry on past 1");
+}
+
+//     Integer images go through a table: every byte exact, & a 16-bit value at most one step off,
+// only where the exact curve lands within 1e-6 of a rounding midpoint.
+static void TestIntegers(const string &name)
+{
+    const e1nTransferCurve curves[] = {E1N_TRANSFER_SRGB, E1N_TRANSFER_REC709, E1N_TRANSFER_GAMMA};
+
+    bool bytesOK = true;
+    bool wordsOK = true;
+
+    for (e1nTransferCurve curve : curves)
+    {
+        for (int toLinear = 0; toLinear < 2; ++toLinear)
+        {
+            Mat bytes(1, 256, CV_8UC3);
+            Mat words(1, 65536, CV_16UC3);
+
+            for (int i = 0; i < 256; ++i)   {bytes.ptr<Vec3b>(0)[i] = Vec3b((uchar) i, (uchar) i, (uchar) i);}
+            for (int i = 0; i < 65536; ++i) {words.ptr<Vec3w>(0)[i] = Vec3w((ushort) i, (ushort) i, (ushort) i);}
+
+            if (toLinear) {e1nToLinear  (bytes, curve); e1nToLinear  (words, curve);}
+            else          {e1nFromLinear(bytes, curve); e1nFromLinear(words, curve);}
+
+            for (int i = 0; i < 256; ++i)
+            {
+                double exact = Reference(curve, toLinear != 0, i / 255.0f, 2.2) * 255.0;
+
+                bytesOK &= bytes.ptr<Vec3b>(0)[i][0] == (int) floor(exact + 0.5);
+            }
+
+            for (int i = 0; i < 65536; ++i)
+            {
+                double exact = Reference(curve, toLinear != 0, i / 65535.0f, 2.2) * 65535.0;
+                int    got   = words.ptr<Vec3w>(0)[i][0];
+                int    near  = (int) floor(exact + 0.5);
+
+                if (got == near) {continue;}
+
+                wordsOK &= abs(got - near) == 1 && fabs(exact - floor(exact) - 0.5) < 1.0e-6 * 65535.0;
+            }
+        }
+    }
+
+    Check(bytesOK, name + "every byte value converts exactly");
+    Check(wordsOK, name + "16-bit values are exact, or one step off next to a rounding midpoint");
+}
+
+int main()
+{
+    vector<float> inputs = MakeInputs();
+
+    for (int level = E1N_CPU_SCALAR; level < E1N_CPU_LEVEL_COUNT; ++level)
+    {
+        if (!e1nSetCpuLevel((e1nCpuLevel) level)) {continue;}
+
+        string name = string(e1nGetCpuLevelName((e1nCpuLevel) level)) + ": ";
+
+        TestPiecewise(name, inputs);
+        TestGamma(name, inputs);
+        TestSigns(name);
+        TestIntegers(name);
+    }
+
+    return failures ? 1 : 0;
+}